@@ -0,0 +1,160 @@
+// ESMS - Electronic Soccer Management Simulator
+// Copyright (C) <1998-2005>  Eli Bendersky
+//
+// This program is free software, licensed with the GPL (www.fsf.org)
+//
+#include <vector>
+
+#include "auto_teamsheet.h"
+#include "util.h"
+
+
+static int st_getter(RosterPlayerConstIterator player)
+{
+	return player->st * player->fitness / 100;
+}
+
+
+static int tk_getter(RosterPlayerConstIterator player)
+{
+	return player->tk * player->fitness / 100;
+}
+
+
+static int ps_getter(RosterPlayerConstIterator player)
+{
+	return player->ps * player->fitness / 100;
+}
+
+
+static int sh_getter(RosterPlayerConstIterator player)
+{
+	return player->sh * player->fitness / 100;
+}
+
+
+/// Gets the best player on some position from an array of roster players.
+/// 
+/// players 		- the array of players
+/// name_ids 		- the id of the name of each player (see index_roster_names)
+/// chosen 			- for each name id, whether it was already chosen (those won't be
+/// 				  chosen again)
+/// skill 			- pointer to a function receiving a player and returning the skill by
+/// 				  which "best" is judged.
+///
+/// Returns the chosen player (players.end() if there's no player left), and
+/// marks it in chosen.
+///
+static RosterPlayerConstIterator choose_best_player(const RosterPlayerArray& players, 
+													const vector<unsigned>& name_ids, 
+													vector<bool>& chosen, 
+													int (*skill)(RosterPlayerConstIterator player))
+{
+	int best_skill = -1;
+	RosterPlayerConstIterator best = players.end();
+	
+    for (RosterPlayerConstIterator player = players.begin(); player != players.end(); ++player)
+    {
+        if (!chosen[name_ids[player - players.begin()]] && 
+			skill(player) > best_skill && !player->injury && !player->suspension)
+        {
+            best_skill = skill(player);
+            best = player;
+        }
+    }
+
+	if (best != players.end())
+		chosen[name_ids[best - players.begin()]] = true;
+
+	return best;
+}
+
+
+string make_teamsheet(string team_name, const RosterPlayerArray& players, int dfs, int mfs, int fws,
+                      char tactic, int num_subs, string& teamsheet)
+{
+    // The number of subs is not constant, therefore there is
+    // a need for some smart assignment. The following array
+    // sets the positions of thr first 5 subs, and then iterates
+    // cyclicly. For example, if there are 2 subs allowed,
+    // their positions will be GK (mandatory 1st !) and MF
+    // If 7: GK, DF, MF, DF, FW, MF, DF
+    //                              ^
+    //                              cyclic repetition begins
+    //
+    static const char* const sub_position[] = {"DFC", "MFC", "DFC", "FWC", "MFC"};
+
+    // The skill each position is picked by
+    //
+    int (*const sub_skill[])(RosterPlayerConstIterator) = {tk_getter, ps_getter, tk_getter, sh_getter, ps_getter};
+
+	// This will keep us from picking the same players more than once.
+	// The roster names are interned, so a chosen player is a flag by
+	// the id of his name.
+	// 
+	name_index roster_names;
+	index_roster_names(players, roster_names);
+
+	vector<unsigned> name_ids;
+
+    for (RosterPlayerConstIterator player = players.begin(); player != players.end(); ++player)
+		name_ids.push_back(roster_names.find(player->name));
+
+	vector<bool> chosen(roster_names.size(), false);
+
+    // The positions and the skills they're picked by, in the order of
+    // the teamsheet: the GK, the defenders, midfielders and forwards,
+    // the sub GK and the other subs
+    //
+    vector<string> positions;
+    vector<int (*)(RosterPlayerConstIterator)> skills;
+
+    positions.push_back("GK");
+    skills.push_back(st_getter);
+
+    for (int i = 0; i < dfs + mfs + fws; ++i)
+    {
+        positions.push_back(i < dfs ? "DFC" : i < dfs + mfs ? "MFC" : "FWC");
+        skills.push_back(i < dfs ? tk_getter : i < dfs + mfs ? ps_getter : sh_getter);
+    }
+
+    if (num_subs > 0)
+    {
+        positions.push_back("GK");
+        skills.push_back(st_getter);
+    }
+
+    for (int i = 1; i < num_subs; ++i)
+    {
+        positions.push_back(sub_position[(i - 1) % 5]);
+        skills.push_back(sub_skill[(i - 1) % 5]);
+    }
+
+    // Start filling the team sheet with the roster name and the
+    // tactic
+    //
+    teamsheet = format_str("%s\n%c\n", team_name.c_str(), tactic);
+    string penalty_taker;
+
+    for (unsigned i = 0; i < positions.size(); ++i)
+    {
+        RosterPlayerConstIterator player = choose_best_player(players, name_ids, chosen, skills[i]);
+
+        if (player == players.end())
+            return format_str("Not enough players who can play in roster %s", team_name.c_str());
+
+        teamsheet += "\n" + positions[i] + " " + player->name;
+
+        if (i == 10)
+            teamsheet += "\n";
+
+        if (int(i) == dfs + mfs + 1)
+            penalty_taker = player->name;
+    }
+
+    // The penalty kick taker - the first forward
+    //
+    teamsheet += "\n\nPK: " + penalty_taker + "\n\n";
+
+    return "";
+}
@@ -0,0 +1,33 @@
+// ESMS - Electronic Soccer Management Simulator
+// Copyright (C) <1998-2005>  Eli Bendersky
+//
+// This program is free software, licensed with the GPL (www.fsf.org)
+//
+#ifndef AUTO_TEAMSHEET_H
+#define AUTO_TEAMSHEET_H
+
+
+#include <string>
+
+#include "rosterplayer.h"
+
+
+using namespace std;
+
+
+// Makes the teamsheet tsc makes for a team: the best shot stopper of
+// the roster in goal, then the best tacklers, passers and shooters
+// (by their skill times their fitness) for the dfs defenders, mfs
+// midfielders and fws forwards, and then num_subs subs - a GK first,
+// and then defenders, midfielders and forwards in turn. Injured and
+// suspended players aren't picked. The penalty taker is the first
+// forward.
+//
+// Returns "" and the text of the teamsheet in teamsheet, or an error
+// message if the roster doesn't have enough players who can play.
+//
+string make_teamsheet(string team_name, const RosterPlayerArray& players, int dfs, int mfs, int fws,
+                      char tactic, int num_subs, string& teamsheet);
+
+
+#endif // AUTO_TEAMSHEET_H
@@ -0,0 +1,137 @@
+// ESMS - Electronic Soccer Management Simulator
+// Copyright (C) <1998-2005>  Eli Bendersky
+//
+// This program is free software, licensed with the GPL (www.fsf.org)
+//
+#include "binary_file.h"
+
+#include <cstdio>
+#include <fcntl.h>
+#include <sys/stat.h>
+
+#ifdef WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#include <sys/mman.h>
+#endif
+
+
+void put_u8(string& out, unsigned value)
+{
+    out += char(value & 0xff);
+}
+
+
+void put_u16(string& out, unsigned value)
+{
+    put_u8(out, value);
+    put_u8(out, value >> 8);
+}
+
+
+void put_u32(string& out, unsigned value)
+{
+    put_u16(out, value);
+    put_u16(out, value >> 16);
+}
+
+
+void put_string(string& out, const string& str)
+{
+    put_u16(out, str.length());
+    out += str;
+}
+
+
+unsigned fnv1a_hash(const unsigned char* data, size_t size)
+{
+    unsigned hash = 2166136261u;
+
+    for (size_t i = 0; i < size; ++i)
+    {
+        hash ^= data[i];
+        hash *= 16777619u;
+    }
+
+    return hash & 0xffffffffu;
+}
+
+
+unsigned string_table::intern(const string& str)
+{
+    map<string, unsigned>::const_iterator found = offsets.find(str);
+
+    if (found != offsets.end())
+        return found->second;
+
+    unsigned offset = table.size();
+    offsets[str] = offset;
+    table.append(str.c_str(), str.length() + 1);
+
+    return offset;
+}
+
+
+mapped_file::~mapped_file()
+{
+#ifdef WIN32
+    delete [] data;
+#else
+    if (data)
+        munmap((void*) data, size);
+#endif
+}
+
+
+bool mapped_file::map_file(string filename)
+{
+#ifdef WIN32
+    FILE* file = fopen(filename.c_str(), "rb");
+
+    if (!file)
+        return false;
+
+    fseek(file, 0, SEEK_END);
+    size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+
+    unsigned char* buf = new unsigned char[size ? size : 1];
+    size = fread(buf, 1, size, file);
+    data = buf;
+
+    fclose(file);
+    return true;
+#else
+    int fd = open(filename.c_str(), O_RDONLY);
+
+    if (fd < 0)
+        return false;
+
+    struct stat st;
+
+    if (fstat(fd, &st) < 0)
+    {
+        close(fd);
+        return false;
+    }
+
+    size = st.st_size;
+
+    if (size > 0)
+    {
+        void* p = mmap(0, size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+        if (p == MAP_FAILED)
+        {
+            close(fd);
+            return false;
+        }
+
+        data = (const unsigned char*) p;
+    }
+
+    close(fd);
+    return true;
+#endif
+}
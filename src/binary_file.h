@@ -0,0 +1,82 @@
+// ESMS - Electronic Soccer Management Simulator
+// Copyright (C) <1998-2005>  Eli Bendersky
+//
+// This program is free software, licensed with the GPL (www.fsf.org)
+//
+#ifndef BINARY_FILE_H
+#define BINARY_FILE_H
+
+
+#include <cstddef>
+#include <map>
+#include <string>
+
+
+using namespace std;
+
+
+// Helpers for the binary files of ESMS (match records, stats files
+// and roster caches). The numbers in these files are little-endian,
+// whatever the machine, and are written and read a byte at a time.
+
+
+// Append a number (or a string - a u16 length and the chars) to out
+//
+void put_u8(string& out, unsigned value);
+void put_u16(string& out, unsigned value);
+void put_u32(string& out, unsigned value);
+void put_string(string& out, const string& str);
+
+
+// FNV-1a, of size bytes of data - to tell whether the data a file was
+// made from has changed since
+//
+unsigned fnv1a_hash(const unsigned char* data, size_t size);
+
+
+inline unsigned load_u32(const unsigned char* p)
+{
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((unsigned) p[3] << 24);
+}
+
+
+// Builds a string table - NUL-terminated strings, each stored once,
+// addressed by their offsets in the table
+//
+class string_table
+{
+public:
+    unsigned intern(const string& str);
+
+    string table;
+
+private:
+    map<string, unsigned> offsets;
+};
+
+
+// A file mapped into memory (or read into it where there's no mmap)
+//
+class mapped_file
+{
+public:
+    mapped_file()
+        : data(0), size(0)
+    {}
+
+    ~mapped_file();
+
+    // Returns false (with errno set) if the file can't be mapped
+    //
+    bool map_file(string filename);
+
+    const unsigned char* data;
+    size_t size;
+
+private:
+    mapped_file(const mapped_file& rhs);
+    mapped_file& operator= (const mapped_file& rhs);
+};
+
+
+#endif // BINARY_FILE_H
@@ -7,6 +7,8 @@
 #include <vector>
 #include <string>
 #include <fstream>
+#include <cstdio>
+#include <cstring>
 #include <cstdarg>
 #include <algorithm>
 
@@ -25,7 +27,103 @@ commentary& the_commentary(void)
 }
 
 
+// The names of the events in language.dat, in the order of
+// comm_event
+//
+static const char* event_names[NUM_COMM_EVENTS] =
+{
+    "ASSISTEDCHANCE",
+    "CHANCE",
+    "CHANGEPOSITION",
+    "CHANGETACTIC",
+    "COMM_FULLTIME",
+    "COMM_HALFTIME",
+    "COMM_INJURYTIME",
+    "COMM_KICKOFF",
+    "COMM_SCORE",
+    "COMM_SHOTSOFFTARGET",
+    "COMM_SHOTSONTARGET",
+    "COMM_STATISTICS",
+    "FOUL",
+    "GOAL",
+    "GOALCANCELLED",
+    "INJURY",
+    "NOSUBSLEFT",
+    "OFFTARGET",
+    "PENALTY",
+    "PENALTYSHOOTOUT",
+    "REDCARD",
+    "SAVE",
+    "SECONDYELLOWCARD",
+    "SHOT",
+    "SUB",
+    "TACKLE",
+    "WARNED",
+    "WONPENALTYSHOOTOUT",
+    "YELLOWCARD",
+    "UPDTR_END_INJURY",
+    "UPDTR_END_SUSPENSION",
+    "UPDTR_INJURY_1",
+    "UPDTR_INJURY_HARD",
+    "UPDTR_INJURY_LIGHT",
+    "UPDTR_INJURY_NONE",
+    "UPDTR_SKILL_DECREASE",
+    "UPDTR_SKILL_INCREASE",
+    "UPDTR_SUSPENDED_1",
+    "UPDTR_SUSPENDED_N"
+};
+
+
+// Compiles a commentary line of language.dat
+//
+static comm_template compile_comment(const string& comment, const string& event)
+{
+    comm_template compiled;
+    comm_template::piece piece;
+    piece.conversion = 0;
+
+    for (string::size_type i = 0; i < comment.length(); ++i)
+    {
+        // Convert the '\n's in the line into "real" newlines
+        //
+        if (comment[i] == '\\' && i + 1 < comment.length() && comment[i + 1] == 'n')
+        {
+            piece.text += '\n';
+            ++i;
+        }
+        else if (comment[i] == '%' && i + 1 < comment.length() && comment[i + 1] == '%')
+        {
+            piece.text += '%';
+            ++i;
+        }
+        else if (comment[i] == '%')
+        {
+            // The flags, width and precision, and then the conversion
+            //
+            string::size_type end = comment.find_first_not_of("-+ #0123456789.", i + 1);
+
+            if (end == string::npos || !strchr("sdiucx", comment[end]))
+                die("Unsupported conversion in the commentary of %s: %s", event.c_str(), comment.c_str());
+
+            piece.conversion = comment[end];
+            piece.spec = comment.substr(i, end - i + 1);
+            compiled.pieces.push_back(piece);
+
+            piece.text = piece.spec = "";
+            piece.conversion = 0;
+            i = end;
+        }
+        else
+            piece.text += comment[i];
+    }
+
+    compiled.pieces.push_back(piece);
+    return compiled;
+}
+
+
 // Initializes commentary data, reading it from the language.dat file
+// and compiling its lines
 //
 void commentary::init_commentary(string language_file)
 {
@@ -34,6 +132,14 @@ void commentary::init_commentary(string language_file)
     if (!infile)
         die("Failed to open language.dat");
 
+    map<string, comm_event> events;
+
+    for (int ev = 0; ev < NUM_COMM_EVENTS; ++ev)
+    {
+        events[event_names[ev]] = comm_event(ev);
+        comm_data[ev].clear();
+    }
+
     string line;
 
     // Read language.dat line by line, updating the
@@ -64,54 +170,90 @@ void commentary::init_commentary(string language_file)
 
         comment = line.substr(index1 + 1, index2 - index1 - 1);
 
-        // Add line to the commentary database 
+        // Add line to the commentary database (events that are
+        // never commented on are skipped)
         //
-        comm_data[event].push_back(comment);
-    }
-}
-
+        map<string, comm_event>::const_iterator ev = events.find(event);
 
-string commentary::rand_comment(const char* event, ...)
-{
-    va_list arglist;
-    va_start(arglist, event);
+        if (ev != events.end())
+            comm_data[ev->second].push_back(compile_comment(comment, event));
+    }
 
-    // How many commentary lines of this type are available ?
+    // Every event must have some commentary
     //
-    string str_event = event;
-    int num_of_choices = comm_data[str_event].size();
+    for (int ev = 0; ev < NUM_COMM_EVENTS; ++ev)
+    {
+        if (comm_data[ev].empty())
+            die("No commentary choices found for event %s in %s", event_names[ev], language_file.c_str());
+    }
+}
 
-    if (num_of_choices < 1)
-        die("No commentary choices found for event %s", event);
 
+void commentary::vappend_comment(string& out, rng_stream& rng, comm_event event, va_list args) const
+{
     // Pick one of the possible commentaries randomly
     //
-    int choice_num = rand() % num_of_choices;
-    string comm_format = comm_data[str_event][choice_num];
-
-    char* buf = new char[4096];
-    vsprintf(buf, comm_format.c_str(), arglist);
-
-    string ret;
-
-    // Convert the '\n's in the string into "real" newlines
-    // which are recognized by the printing functions
+    // (comm_data is only read, never modified, so matches
+    // running at the same time can share the commentary)
     //
-    char* s1 = buf;
+    const vector<comm_template>& choices = comm_data[event];
+    const comm_template& line = choices[rng.below(choices.size())];
 
-    for (; *s1; ++s1)
+    char buf[4096];
+
+    for (vector<comm_template::piece>::const_iterator piece = line.pieces.begin();
+         piece != line.pieces.end(); ++piece)
     {
-        if ((*s1 == '\\') && (*(s1+1) == 'n'))
+        out += piece->text;
+
+        switch (piece->conversion)
         {
-            ret += '\n';
-            ++s1;
+        case 0:
+            continue;
+        case 's':
+            {
+                const char* arg = va_arg(args, const char*);
+
+                if (piece->spec == "%s")
+                {
+                    out += arg;
+                    continue;
+                }
+
+                snprintf(buf, sizeof(buf), piece->spec.c_str(), arg);
+                break;
+            }
+        case 'u':
+        case 'x':
+            snprintf(buf, sizeof(buf), piece->spec.c_str(), va_arg(args, unsigned));
+            break;
+        default:
+            snprintf(buf, sizeof(buf), piece->spec.c_str(), va_arg(args, int));
+            break;
         }
-        else
-            ret += *s1;
+
+        out += buf;
     }
+}
 
-    delete [] buf;
-    return ret;
+
+void commentary::append_comment(string& out, rng_stream& rng, comm_event event, ...) const
+{
+    va_list args;
+    va_start(args, event);
+    vappend_comment(out, rng, event, args);
+    va_end(args);
 }
 
 
+string commentary::rand_comment(rng_stream& rng, comm_event event, ...) const
+{
+    string ret;
+
+    va_list args;
+    va_start(args, event);
+    vappend_comment(ret, rng, event, args);
+    va_end(args);
+
+    return ret;
+}
@@ -2,22 +2,106 @@
 // Copyright (C) <1998-2005>  Eli Bendersky
 //
 // This program is free software, licensed with the GPL (www.fsf.org)
-// 
+//
 #ifndef COMMENT_H
 #define COMMENT_H
 
 #include <map>
 #include <vector>
 #include <string>
+#include <cstdarg>
+
+#include "rng.h"
 
 using namespace std;
 
 
+// The events of language.dat. The name of an event in language.dat
+// is its name here without the EV_ prefix.
+//
+enum comm_event
+{
+    EV_ASSISTEDCHANCE,
+    EV_CHANCE,
+    EV_CHANGEPOSITION,
+    EV_CHANGETACTIC,
+    EV_COMM_FULLTIME,
+    EV_COMM_HALFTIME,
+    EV_COMM_INJURYTIME,
+    EV_COMM_KICKOFF,
+    EV_COMM_SCORE,
+    EV_COMM_SHOTSOFFTARGET,
+    EV_COMM_SHOTSONTARGET,
+    EV_COMM_STATISTICS,
+    EV_FOUL,
+    EV_GOAL,
+    EV_GOALCANCELLED,
+    EV_INJURY,
+    EV_NOSUBSLEFT,
+    EV_OFFTARGET,
+    EV_PENALTY,
+    EV_PENALTYSHOOTOUT,
+    EV_REDCARD,
+    EV_SAVE,
+    EV_SECONDYELLOWCARD,
+    EV_SHOT,
+    EV_SUB,
+    EV_TACKLE,
+    EV_WARNED,
+    EV_WONPENALTYSHOOTOUT,
+    EV_YELLOWCARD,
+    EV_UPDTR_END_INJURY,
+    EV_UPDTR_END_SUSPENSION,
+    EV_UPDTR_INJURY_1,
+    EV_UPDTR_INJURY_HARD,
+    EV_UPDTR_INJURY_LIGHT,
+    EV_UPDTR_INJURY_NONE,
+    EV_UPDTR_SKILL_DECREASE,
+    EV_UPDTR_SKILL_INCREASE,
+    EV_UPDTR_SUSPENDED_1,
+    EV_UPDTR_SUSPENDED_N,
+    NUM_COMM_EVENTS
+};
+
+
+// A commentary line of language.dat, compiled when it's loaded:
+// the text is split at the conversions (%s, %d, ...), and the \n
+// escapes of the text are already real newlines.
+//
+// The line is the text of pieces[0], the conversion of pieces[0],
+// the text of pieces[1], and so on.
+//
+struct comm_template
+{
+    struct piece
+    {
+        string text;
+
+        // The conversion after the text (s, d, i, u, c or x), or 0
+        // if there is none, and the whole conversion (like %2s)
+        //
+        char conversion;
+        string spec;
+    };
+
+    vector<piece> pieces;
+};
+
+
 class commentary
 {
     public:
 	void init_commentary(string language_file);
-	string rand_comment(const char* event, ...);
+
+	// Appends a random commentary line of the event to out. The
+	// arguments are those of the event's lines in language.dat.
+	//
+	void append_comment(string& out, rng_stream& rng, comm_event event, ...) const;
+	void vappend_comment(string& out, rng_stream& rng, comm_event event, va_list args) const;
+
+	// The same as append_comment, returning the line
+	//
+	string rand_comment(rng_stream& rng, comm_event event, ...) const;
 
 	friend commentary& the_commentary(void);
 
@@ -26,7 +110,9 @@ class commentary
 	commentary(const commentary& rhs);
 	commentary& operator= (const commentary& rhs);
 
-	map<string, vector<string> > comm_data;
+	// The lines of each event
+	//
+	vector<comm_template> comm_data[NUM_COMM_EVENTS];
 };
 
 commentary& the_commentary(void);
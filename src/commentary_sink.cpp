@@ -0,0 +1,86 @@
+// ESMS - Electronic Soccer Management Simulator
+// Copyright (C) <1998-2005>  Eli Bendersky
+//
+// This program is free software, licensed with the GPL (www.fsf.org)
+//
+#include "commentary_sink.h"
+
+#include <cerrno>
+
+#ifdef WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+
+void commentary_sink::print(const char* format, ...)
+{
+    va_list args;
+    va_start(args, format);
+    vprint(format, args);
+    va_end(args);
+}
+
+
+void file_commentary_sink::vprint(const char* format, va_list args)
+{
+    vfprintf(file, format, args);
+}
+
+
+void file_commentary_sink::write(const char* text)
+{
+    fputs(text, file);
+}
+
+
+void memory_commentary_sink::vprint(const char* format, va_list args)
+{
+    // The lines of the commentary are short - format_str (util.h)
+    // uses the same buffer size
+    //
+    char buf[4096];
+
+#ifdef WIN32
+    vsprintf_s(buf, 4095, format, args);
+#else
+    vsnprintf(buf, sizeof(buf), format, args);
+#endif
+
+    buffer += buf;
+}
+
+
+void memory_commentary_sink::write(const char* text)
+{
+    buffer += text;
+}
+
+
+bool memory_commentary_sink::write_to(int fd) const
+{
+    const char* data = buffer.data();
+    size_t left = buffer.size();
+
+    // A single write, unless it's interrupted or the
+    // descriptor takes less (like a full pipe)
+    //
+    while (left > 0)
+    {
+        long written = ::write(fd, data, left);
+
+        if (written < 0)
+        {
+            if (errno == EINTR)
+                continue;
+
+            return false;
+        }
+
+        data += written;
+        left -= written;
+    }
+
+    return true;
+}
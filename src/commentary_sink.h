@@ -0,0 +1,138 @@
+// ESMS - Electronic Soccer Management Simulator
+// Copyright (C) <1998-2005>  Eli Bendersky
+//
+// This program is free software, licensed with the GPL (www.fsf.org)
+//
+#ifndef COMMENTARY_SINK_H
+#define COMMENTARY_SINK_H
+
+
+#include <cstdio>
+#include <cstdarg>
+#include <string>
+
+
+using namespace std;
+
+
+///////////////////////
+//
+// commentary_sink
+//
+// Where the commentary of a match goes.
+//
+// The commentary has two parts: the play-by-play (the kickoff, the
+// chances, goals, cards and so on, all rendered from language.dat),
+// and the stats (the starting lineups and the final stats table).
+// A sink says which parts it wants, and the match doesn't produce
+// the parts it doesn't want at all - when the play-by-play isn't
+// wanted, rand_comment is never called for it.
+//
+// The parts are independent: the stats are the same whether the
+// play-by-play was produced or not (see simulate_match).
+//
+class commentary_sink
+{
+public:
+    commentary_sink(bool play_by_play, bool stats)
+        : play_by_play_wanted(play_by_play), stats_wanted(stats)
+    {}
+
+    virtual ~commentary_sink() {}
+
+    bool wants_play_by_play(void) const
+    {
+        return play_by_play_wanted;
+    }
+
+    bool wants_stats(void) const
+    {
+        return stats_wanted;
+    }
+
+    // Appends printf-formatted text to the commentary
+    //
+    void print(const char* format, ...);
+
+    virtual void vprint(const char* format, va_list args) = 0;
+
+    // Appends text to the commentary as it is
+    //
+    virtual void write(const char* text) = 0;
+
+private:
+    bool play_by_play_wanted;
+    bool stats_wanted;
+};
+
+
+// Writes the commentary to a file (the file isn't closed by the sink)
+//
+class file_commentary_sink : public commentary_sink
+{
+public:
+    explicit file_commentary_sink(FILE* file_, bool play_by_play = true)
+        : commentary_sink(play_by_play, true), file(file_)
+    {}
+
+    virtual void vprint(const char* format, va_list args);
+    virtual void write(const char* text);
+
+private:
+    FILE* file;
+};
+
+
+// Keeps the commentary in memory, to be written at once when the
+// match is over (so writing a commentary takes a single system call,
+// and no file has to be open while the match runs)
+//
+class memory_commentary_sink : public commentary_sink
+{
+public:
+    explicit memory_commentary_sink(bool play_by_play = true)
+        : commentary_sink(play_by_play, true)
+    {
+        // About the size of a full commentary
+        //
+        buffer.reserve(16384);
+    }
+
+    virtual void vprint(const char* format, va_list args);
+    virtual void write(const char* text);
+
+    const string& text(void) const
+    {
+        return buffer;
+    }
+
+    // Writes the commentary to the file descriptor fd. Returns
+    // false (with errno set) if the writing failed.
+    //
+    bool write_to(int fd) const;
+
+private:
+    string buffer;
+};
+
+
+// Wants nothing - for matches whose result is all that's needed
+// (a null sink has no state, so matches running at the same time
+// can share one)
+//
+class null_commentary_sink : public commentary_sink
+{
+public:
+    null_commentary_sink()
+        : commentary_sink(false, false)
+    {}
+
+    virtual void vprint(const char*, va_list)
+    {}
+
+    virtual void write(const char*)
+    {}
+};
+
+
+#endif // COMMENTARY_SINK_H
@@ -7,8 +7,18 @@
 #include "util.h"
 
 
-string cond::create(int team_num_, string line)
+cond::~cond()
 {
+    for (vector<cond_condition*>::iterator iter = conditions.begin(); iter != conditions.end(); ++iter)
+        delete *iter;
+
+    delete action;
+}
+
+
+string cond::create(match_context* ctx_, int team_num_, string line)
+{
+    ctx = ctx_;
     team_num = team_num_;
 
     str_index idx = line.find("IF");
@@ -43,17 +53,17 @@ string cond::create(int team_num_, string line)
     if (tok[0] == "TACTIC")
     {
         action = new cond_action_tactic;
-        msg = action->create(team_num, action_str);
+        msg = action->create(ctx, team_num, action_str);
     }
     else if (tok[0] == "SUB")
     {
         action = new cond_action_sub;
-        msg = action->create(team_num, action_str);
+        msg = action->create(ctx, team_num, action_str);
     }
     else if (tok[0] == "CHANGEPOS")
     {
         action = new cond_action_changepos;
-        msg = action->create(team_num, action_str);
+        msg = action->create(ctx, team_num, action_str);
     }
     else
     {
@@ -62,7 +72,10 @@ string cond::create(int team_num_, string line)
     }
 
     if (msg != "")
+    {
+        delete action;
         return msg;
+    }
 
     // If we're here, the action is legal, and we can set it
     // as this cond's action
@@ -89,27 +102,27 @@ string cond::create(int team_num_, string line)
         if (tok[0] == "MIN")
         {
             condition = new cond_condition_minute;
-            msg = condition->create(team_num, *cond_iter);
+            msg = condition->create(ctx, team_num, *cond_iter);
         }
         else if (tok[0] == "SCORE")
         {
             condition = new cond_condition_score;
-            msg = condition->create(team_num, *cond_iter);
+            msg = condition->create(ctx, team_num, *cond_iter);
         }
         else if (tok[0] == "YELLOW")
         {
             condition = new cond_condition_yellow;
-            msg = condition->create(team_num, *cond_iter);
+            msg = condition->create(ctx, team_num, *cond_iter);
         }
         else if (tok[0] == "RED")
         {
             condition = new cond_condition_red;
-            msg = condition->create(team_num, *cond_iter);
+            msg = condition->create(ctx, team_num, *cond_iter);
         }
         else if (tok[0] == "INJ")
         {
             condition = new cond_condition_inj;
-            msg = condition->create(team_num, *cond_iter);
+            msg = condition->create(ctx, team_num, *cond_iter);
         }
         else
         {
@@ -118,7 +131,10 @@ string cond::create(int team_num_, string line)
         }
 
         if (msg != "")
+        {
+            delete condition;
             return msg;
+        }
 
         // It looks OK, so add the condition to this cond
         //
@@ -15,6 +15,9 @@
 using namespace std;
 
 
+class match_context;
+
+
 /// An aggregate for conditionals.
 ///
 /// The conditonal instructions ("conds") are given in the
@@ -32,6 +35,9 @@ using namespace std;
 class cond
 {
 public:
+    cond() : action(0) {}
+    ~cond();
+
     /// Create a cond from a line.
     ///
     /// A line has the following structure:
@@ -44,7 +50,10 @@ public:
     /// Will create a cond with the action "TACTIC P"
     /// and two conditions: "SCORE >= 1" and "MIN >= 80"
     ///
-    string create(int team_num_, string line);
+    /// The cond (and its action and conditions) work on the
+    /// match in ctx_.
+    ///
+    string create(match_context* ctx_, int team_num_, string line);
 
     /// Executes the cond.
     ///
@@ -54,6 +63,13 @@ public:
     void test_and_execute(void);
 
 private:
+    cond(const cond& rhs);
+    cond& operator= (const cond& rhs);
+
+    /// The match on which the cond is defined.
+    ///
+    match_context* ctx;
+
     /// The team number on which the cond is defined.
     ///
     int team_num;
@@ -14,9 +14,6 @@
 using namespace std;
 
 
-extern struct teams team[2];
-
-
 // returns the number of the worst player
 //
 // if no players were on the given position at all, returns -1
@@ -31,8 +28,9 @@ int cond_action::worst_player_on_pos(string fullpos)
     //
     int worst_player_num = -1;
     double worst_player_skill = INT_MAX;
+    const struct teams* team = ctx->team;
 
-    for (int i = 1; i <= num_players; ++i)
+    for (int i = 1; i <= ctx->num_players; ++i)
     {
         string player_i_fullpos = pos_and_side2fullpos(team[team_num].player[i].pos,
                                   team[team_num].player[i].side);
@@ -40,7 +38,7 @@ int cond_action::worst_player_on_pos(string fullpos)
         // not interested in inactive players and players on other
         // positions
         //
-        if (team[team_num].player[i].active != 1 || fullpos != player_i_fullpos)
+        if (team[team_num].hot.active[i] != 1 || fullpos != player_i_fullpos)
             continue;
 
         if (position == "GK")
@@ -56,7 +54,7 @@ int cond_action::worst_player_on_pos(string fullpos)
             if (team[team_num].player[i].tk < worst_player_skill)
             {
                 worst_player_num = i;
-                worst_player_skill = team[team_num].player[i].tk_contrib;
+                worst_player_skill = team[team_num].hot.tk_contrib[i];
             }
         }
         else if (position == "MF")
@@ -64,7 +62,7 @@ int cond_action::worst_player_on_pos(string fullpos)
             if (team[team_num].player[i].ps < worst_player_skill)
             {
                 worst_player_num = i;
-                worst_player_skill = team[team_num].player[i].ps_contrib;
+                worst_player_skill = team[team_num].hot.ps_contrib[i];
             }
         }
         else if (position == "FW")
@@ -72,7 +70,7 @@ int cond_action::worst_player_on_pos(string fullpos)
             if (team[team_num].player[i].sh < worst_player_skill)
             {
                 worst_player_num = i;
-                worst_player_skill = team[team_num].player[i].sh_contrib;
+                worst_player_skill = team[team_num].hot.sh_contrib[i];
             }
         }
         else
@@ -90,8 +88,9 @@ int cond_action::worst_player_on_pos(string fullpos)
 
 
 
-string cond_action_tactic::create(int team_num_, string data)
+string cond_action_tactic::create(match_context* ctx_, int team_num_, string data)
 {
+    ctx = ctx_;
     team_num = team_num_;
 
     vector<string> tok = tokenize(data);
@@ -110,19 +109,20 @@ string cond_action_tactic::create(int team_num_, string data)
 
 void cond_action_tactic::execute(void)
 {
-    change_tactic(team_num, new_tactic.c_str());
+    ctx->change_tactic(team_num, new_tactic.c_str());
 }
 
 
 ///////////////////////////////////////////////////////////////////
 
 
-string cond_action_changepos::create(int team_num_, string data)
+string cond_action_changepos::create(match_context* ctx_, int team_num_, string data)
 {
     // Note: if a position is specified, it will be put in
     // player_pos. if a number is specified, "" will be put
     // in player_pos, and the number in player_number
     //
+    ctx = ctx_;
     team_num = team_num_;
 
     vector<string> tok = tokenize(data);
@@ -137,7 +137,7 @@ string cond_action_changepos::create(int team_num_, string data)
     }
     else
     {
-		player_number = action_str_to_player_number(team_num, tok[1]);
+		player_number = action_str_to_player_number(ctx, team_num, tok[1]);
 		
 		if (player_number < 0)
 			return "Invalid player name/number: " + tok[1];
@@ -167,12 +167,12 @@ void cond_action_changepos::execute(void)
         int num = worst_player_on_pos(player_pos);
 
         if (num != -1)
-            change_position(team_num, num, new_pos);
+            ctx->change_position(team_num, num, new_pos);
     }
     // If a number was specified, just changepos this player
     else
     {
-        change_position(team_num, player_number, new_pos);
+        ctx->change_position(team_num, player_number, new_pos);
     }
 }
 
@@ -180,12 +180,13 @@ void cond_action_changepos::execute(void)
 ///////////////////////////////////////////////////////////////////
 
 
-string cond_action_sub::create(int team_num_, string data)
+string cond_action_sub::create(match_context* ctx_, int team_num_, string data)
 {
     // Note: if a position is specified, it will be put in
     // player_out_pos. if a number is specified, "" will be put
     // in player_out_pos, and the number in player_out_number
     //
+    ctx = ctx_;
     team_num = team_num_;
 
     vector<string> tok = tokenize(data);
@@ -200,7 +201,7 @@ string cond_action_sub::create(int team_num_, string data)
     }
     else
     {
-		player_out_number = action_str_to_player_number(team_num, tok[1]);
+		player_out_number = action_str_to_player_number(ctx, team_num, tok[1]);
 		
 		if (player_out_number < 0)
 			return "Invalid player name/number : " + tok[1];
@@ -209,7 +210,7 @@ string cond_action_sub::create(int team_num_, string data)
     }
 
     // check and record the number of player_in
-    player_in_number = action_str_to_player_number(team_num, tok[2]);
+    player_in_number = action_str_to_player_number(ctx, team_num, tok[2]);
 
     if (player_in_number < 0)
         return "Invalid player name/number : " + tok[2];
@@ -236,12 +237,12 @@ void cond_action_sub::execute(void)
         int num = worst_player_on_pos(player_out_pos);
 
         if (num != -1)
-            substitute_player(team_num, num, player_in_number, new_pos);
+            ctx->substitute_player(team_num, num, player_in_number, new_pos);
     }
     // If a number was specified, just sub this player
     else
     {
-        substitute_player(team_num, player_out_number, player_in_number, new_pos);
+        ctx->substitute_player(team_num, player_out_number, player_in_number, new_pos);
     }
 }
 
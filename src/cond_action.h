@@ -11,14 +11,18 @@
 
 using namespace std;
 
+
+class match_context;
+
 ///////////////
 //
 // cond_action
 //
 // The action taken after fulfilled condition(s)
 //
-// create - creates the action. Returns "" upon success
-//          and an error string if the input is illegal
+// create - creates the action for a team in a match.
+//          Returns "" upon success and an error string if
+//          the input is illegal
 //
 // execute - executes the action (called when all conditions
 //           for this actions are satisfied)
@@ -32,7 +36,7 @@ using namespace std;
 class cond_action
 {
 public:
-    virtual string create(int team_num_, string data) = 0;
+    virtual string create(match_context* ctx_, int team_num_, string data) = 0;
     virtual void execute(void) = 0;
 
     virtual ~cond_action()
@@ -40,6 +44,9 @@ public:
 protected:
     int worst_player_on_pos(string fullpos);
 
+    // The match on which the action is executed
+    match_context* ctx;
+
 	int team_num;
 };
 
@@ -51,7 +58,7 @@ protected:
 class cond_action_tactic : public cond_action
 {
 public:
-    virtual string create(int team_num_, string data);
+    virtual string create(match_context* ctx_, int team_num_, string data);
     virtual void execute(void);
 
     virtual ~cond_action_tactic()
@@ -74,7 +81,7 @@ protected:
 class cond_action_changepos : public cond_action
 {
 public:
-    virtual string create(int team_num_, string data);
+    virtual string create(match_context* ctx_, int team_num_, string data);
     virtual void execute(void);
 
     virtual ~cond_action_changepos()
@@ -99,7 +106,7 @@ protected:
 class cond_action_sub : public cond_action
 {
 public:
-    virtual string create(int team_num_, string data);
+    virtual string create(match_context* ctx_, int team_num_, string data);
     virtual void execute(void);
 
     virtual ~cond_action_sub()
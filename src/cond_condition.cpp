@@ -15,8 +15,9 @@
 ///////////////////////////////////////////////////////////////////
 
 
-string cond_condition_minute::create(int team_num_, string data)
+string cond_condition_minute::create(match_context* ctx_, int team_num_, string data)
 {
+    ctx = ctx_;
     team_num = team_num_;
 
     vector<string> tok = tokenize(data);
@@ -46,17 +47,16 @@ string cond_condition_minute::create(int team_num_, string data)
 
 bool cond_condition_minute::is_true(void)
 {
-    extern int minute;  // from esms.cpp
-
-    return true_sign_expression(minute, cond_minute, sign);
+    return true_sign_expression(ctx->minute, cond_minute, sign);
 }
 
 
 ///////////////////////////////////////////////////////////////////
 
 
-string cond_condition_score::create(int team_num_, string data)
+string cond_condition_score::create(match_context* ctx_, int team_num_, string data)
 {
+    ctx = ctx_;
     team_num = team_num_;
 
     vector<string> tok = tokenize(data);
@@ -86,21 +86,20 @@ string cond_condition_score::create(int team_num_, string data)
 
 bool cond_condition_score::is_true(void)
 {
-    extern int score_diff;  // from esms.cpp
-
-    return true_sign_expression(score_diff, cond_score, sign);
+    return true_sign_expression(ctx->score_diff, cond_score, sign);
 }
 
 
 ///////////////////////////////////////////////////////////////////
 
 
-string cond_condition_yellow::create(int team_num_, string data)
+string cond_condition_yellow::create(match_context* ctx_, int team_num_, string data)
 {
     // Note: if a position is specified, it means any player
     // on that position. Otherwise, an exact player number is
     // given, and the player_pos is set to ""
     //
+    ctx = ctx_;
     team_num = team_num_;
 
     vector<string> tok = tokenize(data);
@@ -115,7 +114,7 @@ string cond_condition_yellow::create(int team_num_, string data)
     }
     else
     {
-		player_num = action_str_to_player_number(team_num, tok[1]);
+		player_num = action_str_to_player_number(ctx, team_num, tok[1]);
 		
 		if (player_num < 0)
 			return "Invalid player name/number: " + tok[1];
@@ -129,8 +128,8 @@ string cond_condition_yellow::create(int team_num_, string data)
 
 bool cond_condition_yellow::is_true(void)
 {
-    extern int yellow_carded[2];
-    extern struct teams team[2];
+    const int* yellow_carded = ctx->yellow_carded;
+    const struct teams* team = ctx->team;
 
     // Were any yellow cards given to our team on this minute ?
     if (yellow_carded[team_num] == -1)
@@ -155,12 +154,13 @@ bool cond_condition_yellow::is_true(void)
 ///////////////////////////////////////////////////////////////////
 
 
-string cond_condition_red::create(int team_num_, string data)
+string cond_condition_red::create(match_context* ctx_, int team_num_, string data)
 {
     // Note: if a position is specified, it means any player
     // on that position. Otherwise, an exact player number is
     // given, and the player_pos is set to ""
     //
+    ctx = ctx_;
     team_num = team_num_;
 
     vector<string> tok = tokenize(data);
@@ -175,7 +175,7 @@ string cond_condition_red::create(int team_num_, string data)
     }
     else
     {
-		player_num = action_str_to_player_number(team_num, tok[1]);
+		player_num = action_str_to_player_number(ctx, team_num, tok[1]);
 		
 		if (player_num < 0)
 			return "Invalid player name/number: " + tok[1];
@@ -189,8 +189,8 @@ string cond_condition_red::create(int team_num_, string data)
 
 bool cond_condition_red::is_true(void)
 {
-    extern int red_carded[2];
-    extern struct teams team[2];
+    const int* red_carded = ctx->red_carded;
+    const struct teams* team = ctx->team;
 
     // Were any red cards given to our team on this minute ?
     if (red_carded[team_num] == -1)
@@ -214,12 +214,13 @@ bool cond_condition_red::is_true(void)
 
 ///////////////////////////////////////////////////////////////////
 
-string cond_condition_inj::create(int team_num_, string data)
+string cond_condition_inj::create(match_context* ctx_, int team_num_, string data)
 {
     // Note: if a position is specified, it means any player
     // on that position. Otherwise, an exact player number is
     // given, and the player_pos is set to ""
     //
+    ctx = ctx_;
     team_num = team_num_;
 
     vector<string> tok = tokenize(data);
@@ -234,7 +235,7 @@ string cond_condition_inj::create(int team_num_, string data)
     }
     else
     {
-		player_num = action_str_to_player_number(team_num, tok[1]);
+		player_num = action_str_to_player_number(ctx, team_num, tok[1]);
 		
 		if (player_num < 0)
 			return "Invalid player name/number: " + tok[1];
@@ -248,8 +249,8 @@ string cond_condition_inj::create(int team_num_, string data)
 
 bool cond_condition_inj::is_true(void)
 {
-    extern int injured_ind[2];
-    extern struct teams team[2];
+    const int* injured_ind = ctx->injured_ind;
+    const struct teams* team = ctx->team;
 
     // Did anyone get injured on this minute ?
     if (injured_ind[team_num] == -1)
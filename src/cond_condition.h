@@ -12,14 +12,18 @@
 using namespace std;
 
 
+class match_context;
+
+
 ///////////////////////
 //
 // cond_condition
 //
 // A condition for some action to be taken
 //
-// create - creates the condition. Returns "" upon success
-//          and an error string if the input is illegal
+// create - creates the condition for a team in a match.
+//          Returns "" upon success and an error string if
+//          the input is illegal
 //
 // is_true - is the condition true ? ran on each minute by
 //           the game loop
@@ -27,13 +31,16 @@ using namespace std;
 class cond_condition
 {
 public:
-    virtual string create(int team_num_, string data) = 0;
+    virtual string create(match_context* ctx_, int team_num_, string data) = 0;
     virtual bool is_true(void) = 0;
 
     virtual ~cond_condition()
     {}
 protected:
 
+    // The match on which the condition is checked
+    match_context* ctx;
+
     int team_num;
 };
 
@@ -45,7 +52,7 @@ protected:
 class cond_condition_minute : public cond_condition
 {
 public:
-    virtual string create(int team_num_, string data);
+    virtual string create(match_context* ctx_, int team_num_, string data);
     virtual bool is_true(void);
 
     virtual ~cond_condition_minute()
@@ -63,7 +70,7 @@ protected:
 class cond_condition_score : public cond_condition
 {
 public:
-    virtual string create(int team_num_, string data);
+    virtual string create(match_context* ctx_, int team_num_, string data);
     virtual bool is_true(void);
 
     virtual ~cond_condition_score()
@@ -81,7 +88,7 @@ protected:
 class cond_condition_inj : public cond_condition
 {
 public:
-    virtual string create(int team_num_, string data);
+    virtual string create(match_context* ctx_, int team_num_, string data);
     virtual bool is_true(void);
 
     virtual ~cond_condition_inj()
@@ -99,7 +106,7 @@ protected:
 class cond_condition_yellow : public cond_condition
 {
 public:
-    virtual string create(int team_num_, string data);
+    virtual string create(match_context* ctx_, int team_num_, string data);
     virtual bool is_true(void);
 
     virtual ~cond_condition_yellow()
@@ -117,7 +124,7 @@ protected:
 class cond_condition_red : public cond_condition
 {
 public:
-    virtual string create(int team_num_, string data);
+    virtual string create(match_context* ctx_, int team_num_, string data);
     virtual bool is_true(void);
 
     virtual ~cond_condition_red()
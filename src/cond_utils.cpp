@@ -8,22 +8,18 @@
 #include "game.h"
 
 
-extern struct teams team[2];
+int player_name_to_number(const match_context* ctx, int team_num, string name)
+{
+    unsigned id = ctx->team[team_num].player_names.find(name);
 
+    if (id == name_index::NO_NAME)
+        return -1;
 
-int player_name_to_number(int team_num, string name)
-{
-    for (int i = 1; i <= num_players; ++i)
-    {
-		if (name == team[team_num].player[i].name)
-			return i;
-	}
-	
-	return -1;
+    return id + 1;
 }
 
 
-int action_str_to_player_number(int team_num, string str)
+int action_str_to_player_number(const match_context* ctx, int team_num, string str)
 {
 	char* ptr;
 	int player_number = strtol(str.c_str(), &ptr, 10);
@@ -32,14 +28,14 @@ int action_str_to_player_number(int team_num, string str)
 	//
 	if (!*ptr)
 	{
-		if (!is_legal_player_number(player_number))
+		if (!is_legal_player_number(ctx, player_number))
 			return -1;
 	}
 	// Not a number ? So it's probably a name
 	//
 	else
 	{
-		player_number = player_name_to_number(team_num, str);
+		player_number = player_name_to_number(ctx, team_num, str);
 		
 		if (player_number < 0)
 			return -1;
@@ -100,9 +96,9 @@ bool true_sign_expression(int a, int b, string sign)
 }
 
 
-bool is_legal_player_number(int num)
+bool is_legal_player_number(const match_context* ctx, int num)
 {
-    if (num >= 1 && num <= num_players)
+    if (num >= 1 && num <= ctx->num_players)
         return true;
 
     return false;
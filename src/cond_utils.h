@@ -12,10 +12,12 @@
 
 using namespace std;
 
-extern int num_players;
+
+class match_context;
+
 
 bool is_legal_side(char side);
-bool is_legal_player_number(int number);
+bool is_legal_player_number(const match_context* ctx, int number);
 bool is_legal_sign(string sign);
 bool is_legal_tactic(string tactic);
 bool is_legal_position(string position);
@@ -24,12 +26,12 @@ bool true_sign_expression(int a, int b, string sign);
 /// Returns a player number, given his name, or -1 if no
 /// such player.
 ///
-int player_name_to_number(int team_num, string name);
+int player_name_to_number(const match_context* ctx, int team_num, string name);
 
 /// Returns a player number from a string with either a number or
 /// or a name, or -1 if no such player.
 ///
-int action_str_to_player_number(int team_num, string str);
+int action_str_to_player_number(const match_context* ctx, int team_num, string str);
 
 string fullpos2position(string fullpos);
 char fullpos2side(string fullpos);
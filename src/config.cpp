@@ -100,20 +100,40 @@ void config::set_config_value(string key, string value)
 }
 
 
-string config::get_config_value(string key)
+// The getters only look the map up (never insert into it), so
+// they are safe to call from several threads once the config
+// file was loaded
+//
+string config::get_config_value(string key) const
 {
-    if (config_map.find(key) == config_map.end())
+    map<string, string>::const_iterator iter = config_map.find(key);
+
+    if (iter == config_map.end())
         return "";
     else
-        return config_map[key];
+        return iter->second;
 }
 
 
-int config::get_int_config(string key, int dflt)
+int config::get_int_config(string key, int dflt) const
 {
-    if (config_map.find(key) == config_map.end())
+    map<string, string>::const_iterator iter = config_map.find(key);
+
+    if (iter == config_map.end())
         return dflt;
     else
-        return atoi(config_map[key].c_str());
+        return atoi(iter->second.c_str());
+}
+
+
+string config::find_abbreviation(string fullname) const
+{
+    for (map<string, string>::const_iterator iter = config_map.begin(); iter != config_map.end(); ++iter)
+    {
+        if (iter->first.compare(0, 5, "abbr_") == 0 && iter->second == fullname)
+            return iter->first.substr(5);
+    }
+
+    return "";
 }
 
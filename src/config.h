@@ -34,13 +34,18 @@ using namespace std;
 // get_int_config - returns an integer value associated with
 //                  a key (must have numeric value), or a
 //                  default if the key doesn't exist
+//
+// find_abbreviation - returns the abbreviation of a team's full
+//                     name (as listed in the Abbreviations section),
+//                     or "" if there's no such full name
 class config
 {
 public:
     void load_config_file(string filename);
-    string get_config_value(string key);
+    string get_config_value(string key) const;
     void set_config_value(string key, string value);
-    int get_int_config(string key, int dflt);
+    int get_int_config(string key, int dflt) const;
+    string find_abbreviation(string fullname) const;
 
     friend config& the_config();
 private:
@@ -0,0 +1,286 @@
+// ESMS - Electronic Soccer Management Simulator
+// Copyright (C) <1998-2005>  Eli Bendersky
+//
+// This program is free software, licensed with the GPL (www.fsf.org)
+//
+////////////////////////////////////////////////////////////////////////////
+//
+// esms_round runs all the games of one week of fixtures.txt (as
+// generated by the fixtures program) in a single process.
+//
+// The data files (league.dat, tactics.dat, language.dat) are loaded
+// once, the teamsheets and rosters of all the games are read, and
+// then the games are simulated on a pool of worker threads. Each game
+// has its own commentary file, exactly like esms does.
+//
+// The commentaries are kept in memory, and the commentary files (and
+// the event files, with --events) are written, and stats.dir and
+// reports.txt appended, only after all the games are over, in the
+// order of the games in fixtures.txt, so the output doesn't depend
+// on the amount of threads.
+//
+// The teams in fixtures.txt are given either by their abbreviation
+// or by their full name (as listed in the Abbreviations section of
+// league.dat). The teamsheet of a team is <abbreviation>sht.txt
+//
+// The random stream of each game is created from the league seed
+// (--set_rnd_seed, or LEAGUE_SEED in league.dat, or the time), the
+// week and the number of the game in the week (from 1), so a round
+// plays the same whatever the amount of threads. The commentary file
+// ends with these three numbers - the game can be replayed with
+// esms --set_rnd_seed <seed> --week <week> --fixture <fixture>
+//
+////////////////////////////////////////////////////////////////////////////
+
+#include "game.h"
+#include "config.h"
+#include "tactics.h"
+#include "util.h"
+#include "anyoption.h"
+#include "comment.h"
+#include "thread_pool.h"
+#include "fixture_list.h"
+
+#include <string>
+#include <iostream>
+#include <fstream>
+#include <fcntl.h>
+
+#ifdef WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+
+using namespace std;
+
+
+bool waitflag = true;
+
+
+// One game of the round
+//
+struct round_game
+{
+    round_game()
+        : comm_sink(0), ctx(0)
+    {}
+
+    string home, away;
+    match_inputs inputs;
+    string comm_file_name;
+    memory_commentary_sink* comm_sink;
+    match_context* ctx;
+    string error;
+};
+
+
+static void play_game(unsigned game_num, void* data)
+{
+    round_game* game = &((round_game*) data)[game_num];
+
+    game->error = simulate_match(*game->ctx, game->inputs);
+}
+
+
+int main(int argc, char* argv[])
+{
+    cout << "ESMS v2.7.3 - round runner\n\n";
+
+    // handling/parsing command line arguments
+    //
+    AnyOption* opt = new AnyOption();
+    opt->noPOSIX();
+
+    opt->setOption("work_dir");
+    opt->setFlag("no_wait_on_exit");
+    opt->setOption("set_rnd_seed");
+    opt->setOption("fixtures_file");
+    opt->setOption("week");
+    opt->setOption("threads");
+    opt->setOption("penalty_diff");
+    opt->setOption("penalty_score");
+    opt->setFlag("stats_only");
+    opt->setOption("events");
+
+    opt->processCommandArgs(argc, argv);
+
+    string work_dir;
+
+    if (opt->getValue("work_dir"))
+        work_dir = opt->getValue("work_dir");
+
+    if (opt->getFlag("no_wait_on_exit"))
+        waitflag = false;
+
+    if (!opt->getValue("week"))
+        die("Usage: esms_round --week <n> [--fixtures_file <file>] [--threads <n>] [--set_rnd_seed <seed>] [--stats_only] [--events bin|json]");
+
+    int week = atoi(opt->getValue("week"));
+
+    string fixtures_filename = work_dir + "fixtures.txt";
+
+    if (opt->getValue("fixtures_file"))
+        fixtures_filename = work_dir + opt->getValue("fixtures_file");
+
+    unsigned num_threads = num_processors();
+
+    if (opt->getValue("threads"))
+        num_threads = atoi(opt->getValue("threads"));
+
+    // initialize the data shared by all games
+    //
+    the_config().load_config_file(work_dir + "league.dat");
+    tact_manager().init(work_dir + "tactics.dat");
+    the_commentary().init_commentary(work_dir + "language.dat");
+
+    // See the penalty shootout options of esms. Asking the user
+    // is not possible when the games run together, so with CUP = 1
+    // one of the command line options must be given
+    //
+    shootout_policy shootout = SHOOTOUT_NEVER;
+    string shootout_score;
+    int shootout_diff = 0;
+
+    if (opt->getValue("penalty_score"))
+    {
+        shootout = SHOOTOUT_ON_SCORE;
+        shootout_score = opt->getValue("penalty_score");
+    }
+    else if (opt->getValue("penalty_diff"))
+    {
+        shootout = SHOOTOUT_ON_DIFF;
+        shootout_diff = atol(opt->getValue("penalty_diff"));
+    }
+    else
+    {
+        int cup_flag = the_config().get_int_config("CUP", 0);
+
+        if (cup_flag == 1)
+            die("With CUP = 1 in league.dat, give esms_round --penalty_score or --penalty_diff");
+        else if (cup_flag == 2)
+            shootout = SHOOTOUT_ALWAYS;
+    }
+
+    unsigned league_seed = time(NULL);
+
+    if (opt->getValue("set_rnd_seed"))
+        league_seed = strtoul(opt->getValue("set_rnd_seed"), 0, 10);
+    else if (the_config().get_config_value("LEAGUE_SEED") != "")
+        league_seed = strtoul(the_config().get_config_value("LEAGUE_SEED").c_str(), 0, 10);
+
+    // See --stats_only of esms
+    //
+    bool stats_only = opt->getFlag("stats_only");
+
+    // See --events of esms
+    //
+    string events_format = opt->getValue("events") ? opt->getValue("events") : "";
+
+    if (events_format != "" && events_format != "bin" && events_format != "json")
+        die("--events must be bin or json");
+
+    week_fixtures fixtures = read_week_fixtures(fixtures_filename, week);
+
+    if (fixtures.empty())
+        die("No games for week %d in %s", week, fixtures_filename.c_str());
+
+    // Read the teamsheets and rosters of all the games
+    //
+    unsigned num_games = fixtures.size();
+    round_game* games = new round_game[num_games];
+
+    for (unsigned i = 0; i < num_games; ++i)
+    {
+        round_game& game = games[i];
+
+        game.home = fixtures[i].first;
+        game.away = fixtures[i].second;
+
+        string home_teamsheetname = work_dir + team_abbreviation(game.home) + "sht.txt";
+        string away_teamsheetname = work_dir + team_abbreviation(game.away) + "sht.txt";
+
+        string msg = read_match_inputs(game.inputs, work_dir, home_teamsheetname, away_teamsheetname);
+
+        if (msg != "")
+            die("%s - %s: %s", game.home.c_str(), game.away.c_str(), msg.c_str());
+
+        game.inputs.rng = rng_stream(league_seed, week, i + 1);
+        game.inputs.shootout = shootout;
+        game.inputs.shootout_score = shootout_score;
+        game.inputs.shootout_diff = shootout_diff;
+
+        game.comm_file_name = work_dir + game.inputs.team_name[0] + "_" + game.inputs.team_name[1] + ".txt";
+        game.comm_sink = new memory_commentary_sink(!stats_only);
+        game.inputs.comm = game.comm_sink;
+        game.inputs.record_events = events_format != "";
+
+        game.ctx = new match_context;
+    }
+
+    printf("Running %u games of week %d on %u threads\n\n", num_games, week, num_threads);
+
+    run_parallel(num_games, num_threads, play_game, games);
+
+    // Report illegal teamsheets before writing anything to the
+    // shared files, so a fixed round can simply be rerun
+    //
+    bool failed = false;
+
+    for (unsigned i = 0; i < num_games; ++i)
+    {
+        if (games[i].error != "")
+        {
+            fprintf(stderr, "Error in %s - %s: %s\n", games[i].home.c_str(), games[i].away.c_str(),
+                    games[i].error.c_str());
+            failed = true;
+        }
+    }
+
+    if (failed)
+        die("The round wasn't run, stats.dir and reports.txt weren't changed");
+
+    // stats.dir, reports.txt and the files of the games, in the order
+    // of the fixtures
+    //
+    for (unsigned i = 0; i < num_games; ++i)
+    {
+        match_context* ctx = games[i].ctx;
+
+        ctx->create_stats_file(work_dir);
+        ctx->update_reports_file(work_dir);
+
+        if (events_format != "")
+            ctx->write_events_file(work_dir, events_format);
+
+        printf("%s %d - %d %s\n", ctx->team[0].fullname, ctx->team[0].score,
+               ctx->team[1].score, ctx->team[1].fullname);
+
+        games[i].comm_sink->print("\n\n\n%u %d %u\n", league_seed, week, i + 1);
+
+        int comm_fd = open(games[i].comm_file_name.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0666);
+
+        if (comm_fd < 0 || !games[i].comm_sink->write_to(comm_fd))
+            die("Can't write %s: %s", games[i].comm_file_name.c_str(), strerror(errno));
+
+        close(comm_fd);
+
+        // With the commentary it goes with (see get_players_game_stats
+        // of updtr)
+        //
+        ctx->write_stats_record(work_dir, games[i].comm_sink->text());
+        delete games[i].comm_sink;
+
+        delete ctx;
+    }
+
+    delete [] games;
+
+    printf("\nRound finished successfully\n");
+
+    MY_EXIT(0);
+
+    // not reachable
+    return 0;
+}
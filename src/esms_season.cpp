@@ -0,0 +1,329 @@
+// ESMS - Electronic Soccer Management Simulator
+// Copyright (C) <1998-2005>  Eli Bendersky
+//
+// This program is free software, licensed with the GPL (www.fsf.org)
+//
+////////////////////////////////////////////////////////////////////////////
+//
+// esms_season plays a whole season of fixtures.txt in a single
+// process, without any files between the weeks: the rosters of the
+// teams in teams.dir are read once, and then each week the teamsheets
+// are made like tsc makes them (all with the formation of
+// --formation, 442N by default), the games are played on a pool of
+// worker threads, the rosters are updated like updtr 8 updates them
+// and the results are added to the table (see season.h). The season
+// starts from an empty table.
+//
+// The random streams are those esms_round and updtr would use with
+// the league seed (--set_rnd_seed, or LEAGUE_SEED in league.dat, or
+// the time) - game i of week w plays like esms --week w --fixture i
+// with the same teamsheets and rosters.
+//
+// The final table is printed. The text files are written only where
+// asked for:
+//
+// --commentary  the commentary of each game, to week<w>_<home>_<away>.txt
+// --reports     the results of each week appended to reports.txt, and
+//               table.txt updated from it, like updtr does (the season
+//               starts from an empty table, so there must be no
+//               reports.txt, table.txt or table.txt.checkpoint yet -
+//               the table made from them would be another one)
+// --summaries   the updtr summary of each week, to updtr_summary_week<w>.txt
+// --save        the rosters after the season, and the table (to
+//               table.txt, unless --reports keeps it)
+//
+// With --project <n>, esms_season projects the end of a season that's
+// under way instead: the rest of the season is played n times from
+// table.txt (with the head-to-head results of its checkpoint) and the
+// rosters, and the chances of each team to finish in each place, and
+// its expected points, are printed (see season_projection.h). The
+// seasons are played without commentary, each on one thread. The
+// rest of the season is the weeks of --from_week on, or, by default,
+// the weeks after those whose games the table already has. Nothing is
+// written.
+//
+////////////////////////////////////////////////////////////////////////////
+
+#include "season.h"
+#include "season_projection.h"
+#include "config.h"
+#include "tactics.h"
+#include "util.h"
+#include "anyoption.h"
+#include "comment.h"
+#include "league_store.h"
+#include "thread_pool.h"
+
+#include <string>
+#include <iostream>
+#include <fstream>
+#include <fcntl.h>
+
+#ifdef WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+
+using namespace std;
+
+
+bool waitflag = true;
+
+
+// Writes what the games of the week left, and the summary of the
+// roster updates, as the options ask
+//
+static void write_week_outputs(season& league, string work_dir, unsigned seed, int week,
+                               bool commentary, bool reports, bool summaries)
+{
+    for (unsigned i = 0; i < league.num_games; ++i)
+    {
+        season_game& game = league.games[i];
+
+        if (reports)
+            game.ctx->update_reports_file(work_dir);
+
+        if (commentary)
+        {
+            string comm_file_name = work_dir + format_str("week%d_", week) + game.inputs.team_name[0] + "_" +
+                                    game.inputs.team_name[1] + ".txt";
+
+            game.comm_sink->print("\n\n\n%u %d %u\n", seed, week, i + 1);
+
+            int comm_fd = open(comm_file_name.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0666);
+
+            if (comm_fd < 0 || !game.comm_sink->write_to(comm_fd))
+                die("Can't write %s: %s", comm_file_name.c_str(), strerror(errno));
+
+            close(comm_fd);
+        }
+    }
+
+    if (reports)
+    {
+        string table_text;
+        string msg = update_league_table_file(work_dir + "table.txt", work_dir + "reports.txt",
+                                              the_config().get_config_value("TABLE_TIE_BREAKS"), table_text);
+
+        if (msg != "")
+            die("Something went wrong updating %stable.txt: %s", work_dir.c_str(), msg.c_str());
+    }
+
+    if (summaries)
+    {
+        vector<string> table_report;
+        table_report.push_back(league.table.dump_league_table());
+
+        string summary_name = work_dir + format_str("updtr_summary_week%d.txt", week);
+        ofstream sf(summary_name.c_str());
+
+        if (!sf)
+            die("Can't write %s", summary_name.c_str());
+
+        league.updates.print_summary(sf, table_report);
+    }
+}
+
+
+// Projects the rest of the season from the table and the rosters of
+// league, --project
+//
+static void project_season(season& league, map<int, week_fixtures> weeks, string work_dir, unsigned seed,
+                           unsigned num_seasons, int from_week)
+{
+    league.table.read_league_table_file(work_dir + "table.txt");
+
+    if (from_week)
+        weeks.erase(weeks.begin(), weeks.lower_bound(from_week));
+    else
+    {
+        // The weeks the table has (if they were played in order)
+        //
+        unsigned games_in_table = league.table.num_games();
+
+        while (!weeks.empty() && weeks.begin()->second.size() <= games_in_table)
+        {
+            games_in_table -= weeks.begin()->second.size();
+            weeks.erase(weeks.begin());
+        }
+    }
+
+    if (weeks.empty())
+        die("No weeks left to play in the season");
+
+    printf("Projecting the season from week %d (%u weeks left) with %u seasons on %u threads\n\n",
+           weeks.begin()->first, (unsigned) weeks.size(), num_seasons, league.threads);
+
+    season_projection result;
+    string msg = run_season_projection(league, weeks, seed, num_seasons, league.threads, result);
+
+    if (msg != "")
+        die("%s", msg.c_str());
+
+    print_season_projection(stdout, result);
+}
+
+
+int main(int argc, char* argv[])
+{
+    cout << "ESMS v2.7.3 - season runner\n\n";
+
+    // handling/parsing command line arguments
+    //
+    AnyOption* opt = new AnyOption();
+    opt->noPOSIX();
+
+    opt->setOption("work_dir");
+    opt->setFlag("no_wait_on_exit");
+    opt->setOption("set_rnd_seed");
+    opt->setOption("fixtures_file");
+    opt->setOption("threads");
+    opt->setOption("formation");
+    opt->setFlag("commentary");
+    opt->setFlag("reports");
+    opt->setFlag("summaries");
+    opt->setFlag("save");
+    opt->setOption("project");
+    opt->setOption("from_week");
+
+    opt->processCommandArgs(argc, argv);
+
+    string work_dir;
+
+    if (opt->getValue("work_dir"))
+        work_dir = opt->getValue("work_dir");
+
+    if (opt->getFlag("no_wait_on_exit"))
+        waitflag = false;
+
+    string fixtures_filename = work_dir + "fixtures.txt";
+
+    if (opt->getValue("fixtures_file"))
+        fixtures_filename = work_dir + opt->getValue("fixtures_file");
+
+    // The formation of the teamsheets - like that of tsc, <DFs><MFs><FWs><tactic>
+    //
+    string formation = opt->getValue("formation") ? opt->getValue("formation") : "442N";
+
+    if (formation.length() != 4 || formation[0] < '1' || formation[0] > '8' || formation[1] < '1' ||
+        formation[1] > '8' || formation[2] < '1' || formation[2] > '8' ||
+        (formation[0] - '0') + (formation[1] - '0') + (formation[2] - '0') != 10)
+        die("Usage: esms_season [--formation <formation & tactic, like 442N>] [--fixtures_file <file>] "
+            "[--threads <n>] [--set_rnd_seed <seed>] [--commentary] [--reports] [--summaries] [--save] "
+            "[--project <seasons> [--from_week <n>]]");
+
+    // initialize the data shared by all games
+    //
+    the_config().load_config_file(work_dir + "league.dat");
+    tact_manager().init(work_dir + "tactics.dat");
+    the_commentary().init_commentary(work_dir + "language.dat");
+
+    unsigned league_seed = time(NULL);
+
+    if (opt->getValue("set_rnd_seed"))
+        league_seed = strtoul(opt->getValue("set_rnd_seed"), 0, 10);
+    else if (the_config().get_config_value("LEAGUE_SEED") != "")
+        league_seed = strtoul(the_config().get_config_value("LEAGUE_SEED").c_str(), 0, 10);
+
+    bool commentary = opt->getFlag("commentary");
+    bool reports = opt->getFlag("reports");
+    bool summaries = opt->getFlag("summaries");
+
+    season league;
+
+    league.dfs = formation[0] - '0';
+    league.mfs = formation[1] - '0';
+    league.fws = formation[2] - '0';
+    league.tactic = formation[3];
+    league.threads = num_processors();
+
+    if (opt->getValue("threads"))
+        league.threads = atoi(opt->getValue("threads"));
+
+    league.with_commentary = commentary;
+    league.with_leaders = summaries;
+
+    string msg = league.read_league(work_dir);
+
+    if (msg != "")
+        die("%s", msg.c_str());
+
+    map<int, week_fixtures> weeks = read_all_fixtures(fixtures_filename);
+
+    if (weeks.empty())
+        die("No games in %s", fixtures_filename.c_str());
+
+    if (opt->getValue("project"))
+    {
+        if (commentary || reports || summaries || opt->getFlag("save"))
+            die("--project writes nothing, it can't be given with --commentary, --reports, --summaries or --save");
+
+        int num_seasons = atoi(opt->getValue("project"));
+        int from_week = opt->getValue("from_week") ? atoi(opt->getValue("from_week")) : 0;
+
+        if (num_seasons <= 0)
+            die("--project must be given the number of seasons to play");
+
+        project_season(league, weeks, work_dir, league_seed, num_seasons, from_week);
+
+        MY_EXIT(0);
+    }
+
+    if (reports)
+    {
+        const char* league_files[] = {"reports.txt", "table.txt", "table.txt.checkpoint"};
+
+        for (unsigned i = 0; i < sizeof(league_files) / sizeof(league_files[0]); ++i)
+        {
+            string text;
+
+            if (read_league_file(work_dir + league_files[i], text))
+                die("--reports starts a new table, but there's already %s%s (remove it first)",
+                    work_dir.c_str(), league_files[i]);
+        }
+    }
+
+    printf("Playing %u weeks of %u teams on %u threads\n\n", (unsigned) weeks.size(),
+           (unsigned) league.team_names.size(), league.threads);
+
+    for (map<int, week_fixtures>::const_iterator week = weeks.begin(); week != weeks.end(); ++week)
+    {
+        msg = league.play_week(week->second, league_seed, week->first);
+
+        if (msg != "")
+            die("%s", msg.c_str());
+
+        write_week_outputs(league, work_dir, league_seed, week->first, commentary, reports, summaries);
+        printf("Week %d played\n", week->first);
+    }
+
+    string table_text = league.table.dump_league_table();
+
+    if (opt->getFlag("save"))
+    {
+        for (vector<string>::const_iterator team = league.team_names.begin(); team != league.team_names.end(); ++team)
+        {
+            msg = write_roster_players(work_dir + *team + ".txt", league.rosters[*team]);
+
+            if (msg != "")
+                die("%s", msg.c_str());
+        }
+
+        if (!reports)
+        {
+            msg = write_league_file(work_dir + "table.txt", table_text + "\n");
+
+            if (msg != "")
+                die("Can't write %stable.txt: %s", work_dir.c_str(), msg.c_str());
+        }
+    }
+
+    printf("\n%s\nSeason finished successfully\n", table_text.c_str());
+
+    MY_EXIT(0);
+
+    // not reachable
+    return 0;
+}
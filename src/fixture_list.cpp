@@ -0,0 +1,109 @@
+// ESMS - Electronic Soccer Management Simulator
+// Copyright (C) <1998-2005>  Eli Bendersky
+//
+// This program is free software, licensed with the GPL (www.fsf.org)
+//
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+
+#include "fixture_list.h"
+#include "config.h"
+#include "util.h"
+
+
+// Reads the games of a fixtures file into weeks, by the number of
+// their week - all of them, or only those of only_week (when it's not
+// 0), whose lines are the only ones parsed then
+//
+static void read_fixtures(string fixtures_filename, int only_week, map<int, week_fixtures>& weeks)
+{
+    ifstream infile(fixtures_filename.c_str());
+
+    if (!infile)
+        die("Can't open %s", fixtures_filename.c_str());
+
+    int week = 0;
+    string line;
+
+    while (getline(infile, line))
+    {
+        if (is_only_whitespace(line))
+            continue;
+
+        vector<string> tokens = tokenize(line);
+
+        // A week header - "<n>."
+        //
+        if (tokens.size() == 1 && tokens[0][tokens[0].length() - 1] == '.')
+        {
+            if (only_week && week == only_week)
+                break;
+
+            week = atoi(tokens[0].c_str());
+            continue;
+        }
+
+        if (only_week && week != only_week)
+            continue;
+
+        str_index sep = line.find(" - ");
+
+        if (sep == string::npos)
+            die("Illegal line in %s: %s", fixtures_filename.c_str(), line.c_str());
+
+        vector<string> home_tokens = tokenize(line.substr(0, sep));
+        vector<string> away_tokens = tokenize(line.substr(sep + 3));
+
+        if (home_tokens.empty() || away_tokens.empty())
+            die("Illegal line in %s: %s", fixtures_filename.c_str(), line.c_str());
+
+        string home = home_tokens[0], away = away_tokens[0];
+
+        for (unsigned i = 1; i < home_tokens.size(); ++i)
+            home += " " + home_tokens[i];
+
+        for (unsigned i = 1; i < away_tokens.size(); ++i)
+            away += " " + away_tokens[i];
+
+        weeks[week].push_back(make_pair(home, away));
+    }
+}
+
+
+week_fixtures read_week_fixtures(string fixtures_filename, int week)
+{
+    map<int, week_fixtures> weeks;
+
+    read_fixtures(fixtures_filename, week, weeks);
+    return weeks[week];
+}
+
+
+map<int, week_fixtures> read_all_fixtures(string fixtures_filename)
+{
+    map<int, week_fixtures> weeks;
+
+    read_fixtures(fixtures_filename, 0, weeks);
+    return weeks;
+}
+
+
+string team_abbreviation(string team)
+{
+    if (the_config().get_config_value("abbr_" + team) != "")
+        return team;
+
+    string abbr = the_config().find_abbreviation(team);
+
+    if (abbr == "")
+    {
+        // Full names in league.dat have underscores instead of spaces
+        //
+        string underscored = team;
+        replace(underscored.begin(), underscored.end(), ' ', '_');
+        abbr = the_config().find_abbreviation(underscored);
+    }
+
+    return abbr == "" ? team : abbr;
+}
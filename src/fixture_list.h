@@ -0,0 +1,42 @@
+// ESMS - Electronic Soccer Management Simulator
+// Copyright (C) <1998-2005>  Eli Bendersky
+//
+// This program is free software, licensed with the GPL (www.fsf.org)
+//
+#ifndef FIXTURE_LIST_H
+#define FIXTURE_LIST_H
+
+
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+
+using namespace std;
+
+
+// The games of a week of fixtures.txt (as generated by the fixtures
+// program), each a pair of the home and away team names
+//
+typedef vector<pair<string, string> > week_fixtures;
+
+
+// Reads the games of the given week from a fixtures file. A file that
+// can't be read, or an illegal line in the week, is fatal.
+//
+week_fixtures read_week_fixtures(string fixtures_filename, int week);
+
+// Reads all the weeks of a fixtures file, by their number. A file
+// that can't be read, or an illegal line, is fatal.
+//
+map<int, week_fixtures> read_all_fixtures(string fixtures_filename);
+
+// Finds the abbreviation of a team as given in fixtures.txt - either
+// its abbreviation or its full name (as listed in the Abbreviations
+// section of league.dat, with spaces or underscores)
+//
+string team_abbreviation(string team);
+
+
+#endif // FIXTURE_LIST_H
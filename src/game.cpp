@@ -0,0 +1,2269 @@
+// ESMS - Electronic Soccer Management Simulator
+// Copyright (C) <1998-2005>  Eli Bendersky
+//
+// This program is free software, licensed with the GPL (www.fsf.org)
+// 
+#include "game.h"
+#include "config.h"
+#include "tactics.h"
+#include "report_event.h"
+#include "teamsheet_reader.h"
+#include "cond.h"
+#include "util.h"
+#include "cond_utils.h"
+#include "comment.h"
+#include "league_store.h"
+
+#include <iomanip>
+#include <cassert>
+#include <algorithm>
+#include <string>
+#include <vector>
+#include <sstream>
+#include <iostream>
+
+
+using namespace std;
+
+
+// The children of the match stream used for the play-by-play
+// commentary and for the final stats
+//
+const unsigned COMMENTARY_STREAM = 0;
+const unsigned STATS_STREAM = 1;
+
+// The sink of the matches played without a sink
+//
+static null_commentary_sink no_commentary;
+
+
+match_context::match_context()
+{
+    reset();
+}
+
+
+match_context::~match_context()
+{
+    reset();
+}
+
+
+void match_context::reset(void)
+{
+    for (int i = 0; i <= 1; ++i)
+    {
+        for (vector<cond*>::iterator cnd = team[i].conds.begin(); cnd != team[i].conds.end(); ++cnd)
+            delete *cnd;
+
+        // A value-initialized teams is all zeros, just like the global
+        // teams of a fresh process
+        //
+        team[i] = teams();
+    }
+
+    for (vector<report_event*>::iterator event = report_vec.begin(); event != report_vec.end(); ++event)
+        delete *event;
+
+    report_vec.clear();
+
+    record_events = false;
+    events.clear();
+
+    num_players = 0;
+    home_bonus = score_diff = 0;
+    comm = 0;
+    play_by_play = false;
+    team_stats_total_enabled = false;
+    memset(teamStatsTotal, 0, sizeof(teamStatsTotal));
+    minute = formal_minute = 0;
+    inj_time_substitutions = inj_time_injuries = inj_time_fouls = 0;
+    memset(PenaltyTaker, 0, sizeof(PenaltyTaker));
+    memset(PenaltyTakerNum, 0, sizeof(PenaltyTakerNum));
+    KickTakers[0] = KickTakers[1] = 0;
+    PenScore[0] = PenScore[1] = 0;
+    rng = comm_rng = stats_rng = rng_stream();
+
+    clean_inj_card_indicators();
+}
+
+
+string read_match_inputs(match_inputs& inputs, string work_dir,
+                         string home_teamsheetname, string away_teamsheetname)
+{
+    string msg = inputs.teamsheet[0].read_teamsheet(home_teamsheetname);
+    if (msg != "") return msg;
+
+    msg = inputs.teamsheet[1].read_teamsheet(away_teamsheetname);
+    if (msg != "") return msg;
+
+    // Read teams' names from the top of the teamsheets, and then
+    // their rosters
+    //
+    for (int i = 0; i <= 1; ++i)
+    {
+        char name[CHAR_BUF_LEN] = "";
+        sscanf(inputs.teamsheet[i].grab_line().c_str(), "%s", name);
+        inputs.team_name[i] = name;
+
+        inputs.roster[i].clear();
+        msg = read_roster_players(work_dir + inputs.team_name[i] + ".txt", inputs.roster[i]);
+
+        if (msg != "")
+            return msg;
+    }
+
+    return "";
+}
+
+
+string simulate_match(match_context& ctx, const match_inputs& inputs)
+{
+    ctx.reset();
+
+    ctx.rng = inputs.rng;
+    ctx.comm_rng = inputs.rng.split(COMMENTARY_STREAM);
+    ctx.stats_rng = inputs.rng.split(STATS_STREAM);
+
+    for (int i = 0; i <= 1; ++i)
+    {
+        strncpy(ctx.team[i].name, inputs.team_name[i].c_str(), CHAR_BUF_LEN - 1);
+
+        // Look in the configuration file for the teams' full name
+        //
+        string key = "abbr_" + string(ctx.team[i].name);
+        string fullname = the_config().get_config_value(key);
+
+        if (fullname == "")
+            strncpy(ctx.team[i].fullname, ctx.team[i].name, CHAR_BUF_LEN);
+        else
+        {
+            replace(fullname.begin(), fullname.end(), '_', ' ');
+            strncpy(ctx.team[i].fullname, fullname.c_str(), CHAR_BUF_LEN);
+        }
+
+        ctx.team[i].roster_players = inputs.roster[i];
+    }
+
+    ctx.team_stats_total_enabled = the_config().get_int_config("TEAM_STATS_TOTAL", 0) == 1 ? true : false;
+
+    // find out how many players should be listed in a teamsheet
+    //
+    int num_subs = the_config().get_int_config("NUM_SUBS", 7);
+
+    if (num_subs < 1 || num_subs > 13)
+        return "The number of subs specified in league.dat must be between 1 and 13";
+
+    ctx.num_players = 11 + num_subs;
+
+    string msg = ctx.init_teams_data(inputs);
+
+    if (msg != "")
+        return msg;
+
+    ctx.home_bonus = the_config().get_int_config("HOME_BONUS", 0);
+    ctx.comm = inputs.comm ? inputs.comm : &no_commentary;
+    ctx.play_by_play = ctx.comm->wants_play_by_play();
+    ctx.record_events = inputs.record_events;
+
+    ctx.print_starting_tactics();
+    ctx.record_lineups();
+
+    if (ctx.play_by_play)
+        ctx.comm->print("\n\n%s", ctx.comment(ctx.comm_rng, EV_COMM_KICKOFF));
+
+    //--------------------------------------------
+    //---------- The game running loop -----------
+    //--------------------------------------------
+    //
+    // The timing logic is as follows:
+    //
+    // The game is divided to two structurally identical
+    // halves. The difference between the halves is their
+    // start times.
+    //
+    // For each half, an injury time is added. This time
+    // goes into the minute counter, but not into the
+    // formal_minute counter (that is needed for reports)
+    //
+
+    const int half_length = 45;
+
+    // For each half
+    //
+    for (int half_start = 1; half_start < 2*half_length; half_start += half_length)
+    {
+        int half = half_start == 1 ? 1 : 2;
+        int last_minute_of_half = half_start + half_length - 1;
+        bool in_inj_time = false;
+
+        // Play the game minutes of this half
+        //
+        // last_minute_of_half will be increased by inj_time_length in
+        // the end of the half
+        //
+        for (ctx.minute = ctx.formal_minute = half_start; ctx.minute <= last_minute_of_half; ++ctx.minute)
+        {
+            ctx.clean_inj_card_indicators();
+            ctx.recalculate_teams_data();
+
+            // For each team
+            //
+            for (int j = 0; j <= 1; j++)
+            {
+                // Calculate different events
+                //
+                ctx.if_shot(j);
+                ctx.if_foul(j);
+                ctx.random_injury(j);
+
+                ctx.score_diff = ctx.team[j].score - ctx.team[!j].score;
+                ctx.check_conditionals(j);
+            }
+
+            // fixme ?
+            if (ctx.team_stats_total_enabled)
+                if (ctx.minute == 1 || ctx.minute%10 == 0)
+                    ctx.add_team_stats_total();
+
+            if (!in_inj_time)
+            {
+                ++ctx.formal_minute;
+
+                ctx.update_players_minute_count();
+            }
+
+            if (ctx.minute == last_minute_of_half && !in_inj_time)
+            {
+                in_inj_time = true;
+
+                // shouldn't have been increased, but we only know about
+                // this now
+                --ctx.formal_minute;
+
+                int inj_time_length = ctx.how_much_inj_time();
+                last_minute_of_half += inj_time_length;
+
+                char buf[2000];
+                sprintf(buf, "%d", inj_time_length);
+                if (ctx.play_by_play)
+                    ctx.comm->print("\n%s\n", ctx.comment(ctx.comm_rng, EV_COMM_INJURYTIME, buf));
+            }
+        }
+
+        in_inj_time = false;
+
+        if (ctx.play_by_play)
+        {
+            if (half == 1)
+                ctx.comm->print("\n%s\n", ctx.comment(ctx.comm_rng, EV_COMM_HALFTIME));
+            else if (half == 2)
+                ctx.comm->print("\n%s\n", ctx.comment(ctx.comm_rng, EV_COMM_FULLTIME));
+        }
+    }
+
+    ctx.calc_ability();
+
+    // Whether a penalty shootout is run is decided by the
+    // shootout policy of the inputs
+    //
+    switch (inputs.shootout)
+    {
+    case SHOOTOUT_NEVER:
+        break;
+    case SHOOTOUT_ALWAYS:
+        ctx.RunPenaltyShootout();
+        break;
+    case SHOOTOUT_ON_SCORE:
+        if (inputs.shootout_score == format_str("%d-%d", ctx.team[0].score, ctx.team[1].score))
+            ctx.RunPenaltyShootout();
+        break;
+    case SHOOTOUT_ON_DIFF:
+        if (inputs.shootout_diff == ctx.team[0].score - ctx.team[1].score)
+            ctx.RunPenaltyShootout();
+        break;
+    case SHOOTOUT_ASK:
+        printf("\nScore: %s %d-%d %s", ctx.team[0].name, ctx.team[0].score,
+               ctx.team[1].score, ctx.team[1].name);
+        printf("\nWould you like to run a penalty shootout ? (y/n) ");
+
+        if (getchar() == 'y')
+            ctx.RunPenaltyShootout();
+        else
+            printf("\n");
+        break;
+    }
+
+    ctx.print_final_stats();
+
+    return "";
+}
+
+
+string match_context::minute_str()
+{
+    return format_str("%2d", minute);
+}
+
+
+string match_context::formal_minute_str()
+{
+    return format_str("%2d", formal_minute);
+}
+
+
+// Renders a random commentary line of the event (see
+// commentary::append_comment) into comm_line, which all the
+// lines of the match reuse, and returns it
+//
+const char* match_context::comment(rng_stream& line_rng, comm_event event, ...)
+{
+    comm_line.clear();
+
+    va_list args;
+    va_start(args, event);
+    the_commentary().vappend_comment(comm_line, line_rng, event, args);
+    va_end(args);
+
+    return comm_line.c_str();
+}
+
+
+// Records an event of player of team a (see match_event_type for
+// the meaning of other and value) on this minute
+//
+void match_context::add_event(match_event_type type, int a, int player, int other, int value)
+{
+    if (!record_events)
+        return;
+
+    match_event event;
+    event.type = type;
+    event.team = a;
+    event.minute = minute;
+    event.formal_minute = formal_minute;
+    event.player = player;
+    event.other = other;
+    event.value = value;
+
+    events.push_back(event);
+}
+
+
+// Records the starting lineups and tactics of the teams
+//
+void match_context::record_lineups(void)
+{
+    if (!record_events)
+        return;
+
+    for (int j = 0; j <= 1; ++j)
+    {
+        add_event(MEV_TACTIC, j, 0, 0, pack_code(team[j].tactic));
+
+        for (int i = 1; i <= num_players; ++i)
+            add_event(MEV_LINEUP, j, i, team[j].hot.active[i],
+                      pack_code(strcmp(team[j].player[i].pos, "GK") ?
+                                pos_and_side2fullpos(team[j].player[i].pos, team[j].player[i].side) : "GK"));
+    }
+}
+
+
+// Fills record with the teams, players and events of the match
+// (which must have been played with record_events set)
+//
+void match_context::fill_match_record(match_record& record)
+{
+    for (int j = 0; j <= 1; ++j)
+    {
+        record.team_name[j] = team[j].name;
+        record.score[j] = team[j].score;
+        record.players[j].assign(num_players + 1, match_player());
+
+        for (int i = 1; i <= num_players; ++i)
+        {
+            match_player& player = record.players[j][i];
+
+            player.name = team[j].player[i].name;
+            player.minutes = team[j].player[i].minutes;
+            player.st_ab = team[j].player[i].st_ab;
+            player.tk_ab = team[j].player[i].tk_ab;
+            player.ps_ab = team[j].player[i].ps_ab;
+            player.sh_ab = team[j].player[i].sh_ab;
+            player.fitness = int(team[j].hot.fatigue[i] * 100.0);
+        }
+    }
+
+    record.events = events;
+
+    // The stats derived from the events must be those the match
+    // counted while it was played
+    //
+    vector<match_player_stats> stats[2];
+    derive_final_stats(record, stats);
+
+    for (int j = 0; j <= 1; ++j)
+    {
+        for (int i = 1; i <= num_players; ++i)
+        {
+            const playerstruct& p = team[j].player[i];
+            const match_player_stats& s = stats[j][i];
+
+            assert(s.saves == p.saves && s.tackles == p.tackles && s.keypasses == p.keypasses);
+            assert(s.assists == p.assists && s.shots == p.shots && s.goals == p.goals);
+            assert(s.yellowcards == p.yellowcards && s.redcards == p.redcards);
+            assert(s.injured == p.injured && s.fouls == p.fouls && s.conceded == p.conceded);
+            assert(s.shots_on == p.shots_on && s.shots_off == p.shots_off);
+            // (a GK keeps the side of the position he played before)
+            //
+            assert(s.pos == (strcmp(p.pos, "GK") ? pos_and_side2fullpos(p.pos, p.side) : string("GK")));
+        }
+    }
+}
+
+
+/// Calculates how much injury time to add.
+///
+/// Takes into account substitutions, injuries and fouls (by both teams)
+///
+int match_context::how_much_inj_time(void)
+{
+    // Each time this function is called, it subtracts the last
+    // totals it had, because the stats accumulate and don't
+    // annulize between halves
+    //
+    inj_time_substitutions = team[0].substitutions + team[1].substitutions - inj_time_substitutions;
+    inj_time_injuries = team[0].injuries + team[1].injuries - inj_time_injuries;
+    inj_time_fouls = team[0].finalfouls + team[1].finalfouls - inj_time_fouls;
+
+    double calc = ceil(inj_time_substitutions * 0.5 + inj_time_injuries * 0.5 + inj_time_fouls * 0.5);
+
+    return int(calc);
+}
+
+
+void match_context::add_team_stats_total()
+{
+    int index, i;
+
+    /* Define the correct index for the array */
+    if (minute == 1)
+        index = 0;
+    else
+        index = minute/10;
+
+    for (i = 0; i <= 1; ++i)
+    {
+        teamStatsTotal[i][index][0] = team[i].team_tackling;
+        teamStatsTotal[i][index][1] = team[i].team_passing;
+        teamStatsTotal[i][index][2] = team[i].team_shooting;
+    }
+}
+
+
+// Sets up the teams from the teamsheets and the rosters.
+//
+// Returns "" on success, and an error message if something is
+// wrong with the teamsheets.
+//
+string match_context::init_teams_data(const match_inputs& inputs)
+{
+    int i, j, l;
+
+    // The teamsheets are consumed line by line, so work on copies
+    //
+    teamsheet_reader teamsheet[2];
+    teamsheet[0] = inputs.teamsheet[0];
+    teamsheet[1] = inputs.teamsheet[1];
+
+    for (l = 0; l <= 1; l++)
+    {
+        name_index roster_names;
+        vector<unsigned> roster_player_of_name = index_roster_names(team[l].roster_players, roster_names);
+
+        sscanf(teamsheet[l].grab_line().c_str(), "%s", team[l].tactic);
+
+        if (!tact_manager().tactic_exists(string(team[l].tactic)))
+            return format_str("Invalid tactic %s in %s's teamsheet", team[l].tactic, team[l].name);
+
+        team[l].tactic_id = tact_manager().tactic_id(team[l].tactic);
+
+        for (i = 1; i <= num_players; i++)
+        {
+            char full_pos[CHAR_BUF_LEN];
+
+            /* Read players's position and name */
+            sscanf(teamsheet[l].grab_line().c_str(), "%s %s", full_pos, team[l].player[i].name);
+
+            if (strcmp(full_pos, "GK") && !is_legal_position(string(full_pos)))
+                return format_str("Illegal position %s of %s in %s's teamsheet", full_pos,
+                    team[l].player[i].name, team[l].name);
+
+            set_position(l, i, full_pos);
+
+
+            /* The first specified player must be a GK */
+            if (i == 1 && strcmp(team[l].player[i].pos, "GK"))
+                return format_str("The first player in %s's teamsheet must be a GK", team[l].name);
+
+            if (!strcmp(team[l].player[i].pos, "PK:"))
+                return format_str("PK: where player %d was expected (%s)", i, team[l].name);
+
+			// Look this player up in the roster, and when found assign his info
+			// to the player structure.
+			//
+            unsigned name_id = roster_names.find(team[l].player[i].name);
+
+            if (name_id == name_index::NO_NAME)
+                return format_str("Player %s (%s) doesn't exist in the roster file",
+                    team[l].player[i].name, team[l].name);
+
+			const RosterPlayer* player = &team[l].roster_players[roster_player_of_name[name_id]];
+
+			// Check if the player is available for the game
+			//
+			if (player->injury > 0)
+				return format_str("Player %s (%s) is injured",
+					player->name.c_str(), team[l].name);
+
+			if (player->suspension > 0)
+				return format_str("Player %s (%s) is suspended",
+					player->name.c_str(), team[l].name);
+
+			strncpy(team[l].player[i].pref_side, player->pref_side.c_str(), CHAR_BUF_LEN);
+
+			team[l].player[i].likes_left = false;
+			team[l].player[i].likes_right = false;
+			team[l].player[i].likes_center = false;
+
+			if (strchr(team[l].player[i].pref_side, 'L'))
+				team[l].player[i].likes_left = true;
+
+			if (strchr(team[l].player[i].pref_side, 'R'))
+				team[l].player[i].likes_right = true;
+
+			if (strchr(team[l].player[i].pref_side, 'C'))
+				team[l].player[i].likes_center = true;
+
+			team[l].player[i].st = player->st;
+			team[l].player[i].tk = player->tk;
+			team[l].player[i].ps = player->ps;
+			team[l].player[i].sh = player->sh;
+			team[l].player[i].stamina = player->stamina;
+
+			// Each player has a nominal_fatigue_per_minute rating that's
+			// calculated once, based on his stamina.
+			//
+			// I'd like the average rating be 0.031 - so that an average player
+			// (stamina = 50) will lose 30 fitness points during a full game.
+			//
+			// The range is approximately 50 - 10 points, and the stamina range
+			// is 1-99. So, first the ratio is normalized and then subtracted
+			// from the average 0.031 (which, times 90 minutes, is 0.279).
+			// The formula for each player is:
+			//
+			// fatigue            stamina - 50
+			// ------- = 0.0031 - ------------  * 0.0022
+			//  minute                 50
+			//
+			//
+			// This gives (approximately) 30 lost fitness points for average players,
+			// 50 for the worse stamina and 10 for the best stamina.
+			//
+			// A small random factor is added each minute, so the exact numbers are
+			// not deterministic.
+			//
+			double normalized_stamina_ratio = double(team[l].player[i].stamina - 50) / 50.0;
+			team[l].hot.nominal_fatigue_per_minute[i] = 0.0031 - normalized_stamina_ratio * 0.0022;
+
+			team[l].player[i].ag = player->ag;
+			team[l].hot.fatigue[i] = double(player->fitness) / 100.0;
+        }
+
+        // Index the names of the players (for the PK taker and the
+        // conditionals, which name players)
+        //
+        team[l].player_names.clear();
+
+        for (i = 1; i <= num_players; i++)
+            team[l].player_names.intern(team[l].player[i].name);
+
+		// There's an optional "PK: <Name>" line.
+		// If it exists, the <Name> must be listed in the teamsheet.
+		//
+		string pk_line = teamsheet[l].peek_line();
+		vector<string> pk_lines_tokens = tokenize(pk_line);
+		
+		if (pk_lines_tokens.size() == 2 && pk_lines_tokens[0] == "PK:")
+		{
+			// now really remove this line
+			teamsheet[l].grab_line();
+			int i = player_name_to_number(this, l, pk_lines_tokens[1]);
+
+			if (i > 0)
+				team[l].penalty_taker = i;
+			else
+				return format_str("Error in penalty kick taker of %s, player %s not listed", team[l].name, pk_lines_tokens[1].c_str());
+		}
+		else
+		{
+			team[l].penalty_taker = -1;
+		}
+    }
+
+    string msg = ensure_no_duplicate_names();
+
+    if (msg != "")
+        return msg;
+
+    msg = read_conditionals(teamsheet);
+
+    if (msg != "")
+        return msg;
+
+    // Set active flags
+    for (j = 0; j <= 1; j++)
+    {
+        team[j].substitutions = 0;
+        team[j].injuries = 0;
+
+        for (i=1; i <= num_players; i++)
+        {
+            if (i <= 11)
+                team[j].hot.active[i] = 1;
+            else
+                team[j].hot.active[i] = 2;
+        }
+    }
+
+    /* In the beginning, player n.1 is always the GK */
+    team[0].current_gk = team[1].current_gk = 1;
+
+    lineup_changed(0);
+    lineup_changed(1);
+
+    /* Data initialization */
+    for (j = 0; j <= 1; j++)
+    {
+        team[j].score = team[j].finalshots_on = team[j].finalshots_off = 0;
+        team[j].finalfouls = 0;
+        team[j].team_tackling=team[j].team_passing=team[j].team_shooting = 0;
+
+        for (i = 1; i <= num_players; i++)
+        {
+            team[j].hot.tk_contrib[i] = team[j].hot.ps_contrib[i] =
+                                               team[j].hot.sh_contrib[i] = 0;
+
+            team[j].player[i].yellowcards = 0;
+            team[j].player[i].redcards = 0;
+            team[j].player[i].injured = 0;
+            team[j].player[i].tk_ab = 0;
+            team[j].player[i].ps_ab = 0;
+            team[j].player[i].sh_ab = 0;
+            team[j].player[i].st_ab = 0;
+
+            // final stats initialization
+            team[j].player[i].minutes = team[j].player[i].shots = 0;
+            team[j].player[i].goals = team[j].player[i].saves = 0;
+            team[j].player[i].assists = team[j].player[i].tackles = 0;
+            team[j].player[i].keypasses = team[j].player[i].fouls = 0;
+            team[j].player[i].redcards = team[j].player[i].yellowcards = 0;
+            team[j].player[i].conceded = team[j].player[i].shots_on = 0;
+            team[j].player[i].shots_off = 0;
+        }
+    }
+
+    return "";
+}
+
+
+
+/// Goes over both teams and checks that there are no duplicate player
+/// names. If there are, returns an error message.
+///
+string match_context::ensure_no_duplicate_names(void)
+{
+    for (int j = 0; j <= 1; j++)
+    {
+        const name_index& names = team[j].player_names;
+
+        if (int(names.size()) == num_players)
+            continue;
+
+        // The error is about the first player whose name is repeated
+        //
+        vector<int> count(names.size(), 0);
+
+        for (int i = 1; i <= num_players; i++)
+            ++count[names.find(team[j].player[i].name)];
+
+        for (int i = 1; i <= num_players; i++)
+        {
+            if (count[names.find(team[j].player[i].name)] > 1)
+                return format_str("Player %s (%s) is named twice in the team sheet",
+                    team[j].player[i].name, team[j].name);
+        }
+    }
+
+    return "";
+}
+
+
+/// Prints the starting tactics & formation
+/// of each team to the commentary file.
+///
+void match_context::print_starting_tactics(void)
+{
+    int i, j;
+
+    if (!comm->wants_stats())
+        return;
+
+    /* Initialize formation counters */
+
+    comm->print("Home                           Away\n");
+    comm->print("----                           ----\n\n");
+    comm->print("%-30s %-30s\n\n", team[0].fullname, team[1].fullname);
+
+    for (i = 1; i <= 11; i++)
+    {
+        comm->print("%-3s %-26s %-3s %-26s\n",
+                pos_and_side2fullpos(team[0].player[i].pos, team[0].player[i].side).c_str(),
+                team[0].player[i].name,
+                pos_and_side2fullpos(team[1].player[i].pos, team[1].player[i].side).c_str(),
+                team[1].player[i].name);
+
+    }
+
+    comm->print("\n");
+
+    // For each team, count the amount of players on each
+    // position
+    //
+    for (j = 0; j <= 1; j++)
+    {
+        int numDF = 0, numDM = 0, numMF = 0, numAM = 0, numFW = 0;
+
+        for (i = 1; i <= 11; i++)
+        {
+            if (!strcmp(team[j].player[i].pos, "DF"))
+                numDF++;
+            if (!strcmp(team[j].player[i].pos, "DM"))
+                numDM++;
+            if (!strcmp(team[j].player[i].pos, "MF"))
+                numMF++;
+            if (!strcmp(team[j].player[i].pos, "AM"))
+                numAM++;
+            if (!strcmp(team[j].player[i].pos, "FW"))
+                numFW++;
+        }
+
+        ostringstream os;
+
+        os << numDF << "-";
+
+        if (numDM > 0)
+            os << numDM << "-";
+
+        os << numMF << "-";
+
+        if (numAM > 0)
+            os << numAM << "-";
+
+        os << numFW;
+
+        string infa = os.str() + " " + tact_manager().get_tactic_full_name(team[j].tactic);
+
+        comm->print("%-30s ", infa.c_str());
+    }
+}
+
+
+// Reads the conditionals from both teamsheets
+//
+// Returns "" on success, and an error message (naming the team and
+// the line) if some conditional is illegal.
+//
+string match_context::read_conditionals(teamsheet_reader teamsheet[2])
+{
+    // For each team
+    //
+    for (int team_num = 0; team_num <= 1; ++team_num)
+    {
+        // Keep track of line number, for error messages
+        int line_num = 1;
+
+        // Process all lines in the teamsheet until the end (we're already
+        // positioned after the PK: line, so we're ready to read conditionals)
+        //
+        while (!teamsheet[team_num].end_of_teamsheet())
+        {
+            string line = teamsheet[team_num].grab_line();
+
+            cond* cnd = new cond;
+            team[team_num].conds.push_back(cnd);
+
+            string msg = cnd->create(this, team_num, line);
+
+            if (msg != "")
+                return format_str("In conditionals of %s (line %d)\nReason: %s\n",
+                                  team[team_num].name, line_num, msg.c_str());
+
+            ++line_num;
+        }
+    }
+
+    return "";
+}
+
+
+void match_context::change_tactic(int a, const char* newtct)
+{
+    if (strcmp(newtct, team[a].tactic))
+    {
+        strcpy(team[a].tactic, newtct);
+        team[a].tactic_id = tact_manager().tactic_id(newtct);
+
+        // The multipliers of both teams depend on both tactics
+        //
+        lineup_changed(a);
+        lineup_changed(!a);
+
+        add_event(MEV_TACTIC, a, 0, 0, pack_code(newtct));
+
+        if (play_by_play)
+            comm->write(comment(comm_rng, EV_CHANGETACTIC, 
+                        minute_str().c_str(),
+                        team[a].name, team[a].name,
+                        team[a].tactic));
+    }
+}
+
+
+// Puts player b of team a on a position, given in full (with the
+// side, like DMR) or GK. A GK has no side.
+//
+void match_context::set_position(int a, int b, string fullpos)
+{
+    if (fullpos == "GK")
+        strncpy(team[a].player[b].pos, "GK", 2);
+    else
+    {
+        strncpy(team[a].player[b].pos, fullpos2position(fullpos).c_str(), 2);
+        team[a].player[b].side = fullpos2side(fullpos);
+    }
+
+    team[a].player[b].pos_id = tact_manager().position_id(team[a].player[b].pos);
+    lineup_changed(a);
+}
+
+
+// Substitutite player in for player out in team a, he'll play
+// position newpos
+//
+void match_context::substitute_player(int a, int out, int in, string newpos)
+{
+    int max_substitutions = the_config().get_int_config("SUBSTITUTIONS", 3);
+
+    if (team[a].hot.active[out] == 1 && team[a].hot.active[in] == 2
+            && team[a].substitutions < max_substitutions)
+    {
+        team[a].hot.active[out] = 0;
+        team[a].hot.active[in] = 1;
+        lineup_changed(a);
+
+        set_position(a, in, newpos);
+
+        if (out == team[a].current_gk)
+            team[a].current_gk = in;
+
+        team[a].substitutions++;
+
+        add_event(MEV_SUB, a, in, out, pack_code(newpos));
+
+        if (play_by_play)
+            comm->write(comment(comm_rng, EV_SUB, minute_str().c_str(), team[a].name,
+                    team[a].player[in].name,
+                    team[a].player[out].name,
+                    newpos.c_str()));
+    }
+}
+
+
+void match_context::change_position(int a, int b, string newpos)
+{
+    // Can't reposition a GK or an inactive player
+    if (b != team[a].current_gk && team[a].hot.active[b] == 1)
+    {
+        // If he plays on this position anyway, don't change it
+        if (pos_and_side2fullpos(team[a].player[b].pos, team[a].player[b].side) != newpos)
+        {
+            if (play_by_play)
+                comm->write(comment(comm_rng, EV_CHANGEPOSITION, minute_str().c_str(),
+                        team[a].name,
+                        team[a].player[b].name,
+                        newpos.c_str()));
+
+            // (an injured GK is replaced by an outfield player
+            // when no subs are left)
+            //
+            set_position(a, b, newpos);
+
+            add_event(MEV_POSITION_CHANGE, a, b, 0, pack_code(newpos));
+        }
+    }
+}
+
+
+/* This function controls the random injuries occurance. */
+/* The CHANCE of a player to get injured depends on a    */
+/* constant factor + total aggression of the rival team. */
+/* The function will find who was injured and substitute */
+/* him for player on his position.                       */
+void match_context::random_injury(int a)
+{
+    int injured, b, found = 0;
+
+    if (randomp((1500 + team[!a].aggression)/50)) /* If someone got injured */
+    {
+        ++team[a].injuries;
+
+        do        /* The inj_player can't be n.0 and must be playing */
+        {
+            injured = my_random(num_players + 1);
+        }
+        while (injured == 0 || team[a].hot.active[injured] != 1);
+
+        add_event(MEV_INJURY, a, injured);
+
+        if (play_by_play)
+            comm->write(comment(comm_rng, EV_INJURY, minute_str().c_str(), team[a].name,
+                        team[a].player[injured].name));
+
+        report_event* an_event = new report_event_injury(team[a].player[injured].name,
+                                 team[a].name, formal_minute_str().c_str());
+        report_vec.push_back(an_event);
+
+        injured_ind[a] = injured;
+
+        /* Only 3 substitutions are allowed per team per game */
+        if (team[a].substitutions >= 3) /* No substitutions left */
+        {
+            team[a].hot.active[injured] = 0;
+            if (play_by_play)
+                comm->write(comment(comm_rng, EV_NOSUBSLEFT));
+
+            if (!strcmp(team[a].player[injured].pos, "GK"))
+            {
+                int n = 11;
+
+                while(team[a].hot.active[n] != 1)  /* Sub him for another player */
+                    n--;
+
+                change_position(a, n, string("GK"));
+                team[a].current_gk = n;
+            }
+        }
+        else
+        {
+            b = 12;
+
+            while (!found && b <= num_players) /* Look for subs on the same position */
+            {
+                if (!strcmp(team[a].player[injured].pos, team[a].player[b].pos)
+                        && team[a].hot.active[b] == 2)
+                {
+                    substitute_player(a, injured, b,
+                                      pos_and_side2fullpos(team[a].player[injured].pos, team[a].player[injured].side));
+
+                    if (injured == team[a].current_gk)
+                        team[a].current_gk = b;
+
+                    found = 1;
+                }
+                else
+                    b++;
+            }
+
+            if (!found)          /* If there are no subs on his position */
+            {
+                /* Then, sub him for any other player on the bench who is not a   */
+                /* goalkeeper. If a GK will be injured, he will be subbed for the */
+                /* GK on the bench by the previous loop, if there won't be any    */
+                /* GK on the bench, he will be subbed for another player          */
+                b = 12;
+
+                while (!found && b <= num_players)
+                {
+
+                    if (strcmp(team[a].player[b].pos, "GK")
+                            && team[a].hot.active[b] == 2)
+                    {
+                        substitute_player(a, injured, b,
+                                          pos_and_side2fullpos(team[a].player[injured].pos, team[a].player[injured].side));
+                        found = 1;
+
+                        if (injured == team[a].current_gk)
+                            team[a].current_gk = b;
+                    }
+                    else
+                        b++;
+                } // while (!found && b <= num_players)
+            } // if (!found)
+        } // if (team[a].substitutions >= 3)
+
+        team[a].player[injured].injured = 1;
+        team[a].hot.active[injured] = 0;
+        lineup_changed(a);
+
+    } // if (randomp((1500 + team[!a].aggression)/50))
+}
+
+
+// Calculates the lineup factors of player b of team a - his
+// contributions before fatigue and side balance are applied.
+// These only change when the lineup changes.
+//
+void match_context::calc_player_lineup_factors(int a, int b)
+{
+    if (team[a].hot.active[b] == 1 && team[a].current_gk != b)
+    {
+        const tactics_manager& tactics = tact_manager();
+        int pos_id = team[a].player[b].pos_id;
+
+        double tk_mult = tactics.get_mult(team[a].tactic_id, team[!a].tactic_id, pos_id, SKILL_TK);
+        double ps_mult = tactics.get_mult(team[a].tactic_id, team[!a].tactic_id, pos_id, SKILL_PS);
+        double sh_mult = tactics.get_mult(team[a].tactic_id, team[!a].tactic_id, pos_id, SKILL_SH);
+
+        double side_factor;
+
+        if ((team[a].player[b].side == 'R' && team[a].player[b].likes_right) ||
+                (team[a].player[b].side == 'L' && team[a].player[b].likes_left) ||
+                (team[a].player[b].side == 'C' && team[a].player[b].likes_center))
+        {
+            side_factor = 1.0;
+        }
+        else
+        {
+            side_factor = 0.75;
+        }
+
+        team[a].hot.tk_lineup[b] = tk_mult * side_factor * team[a].player[b].tk;
+        team[a].hot.ps_lineup[b] = ps_mult * side_factor * team[a].player[b].ps;
+        team[a].hot.sh_lineup[b] = sh_mult * side_factor * team[a].player[b].sh;
+    }
+    // The contributions of an inactive player or of a GK are 0
+    //
+    else
+    {
+        team[a].hot.tk_lineup[b] = 0;
+        team[a].hot.ps_lineup[b] = 0;
+        team[a].hot.sh_lineup[b] = 0;
+    }
+}
+
+
+// Applies the fatigue of this minute (the fatigue noise must be
+// drawn already) to the active players of team a, and calculates the
+// contributions of all its players from their lineup factors, fatigue
+// and side balance.
+//
+// The loop has no branches and no calls, so it's vectorized. The
+// contributions of an inactive player are 0 because his lineup factors
+// are 0, and multiplying by a side balance multiplier of 1 is exact,
+// so the results are the same as computing player by player.
+//
+void match_context::calc_fatigue_and_contributions(int a)
+{
+    players_hot_data& hot = team[a].hot;
+
+    for (int b = 2; b <= num_players; b++)
+    {
+        double fatigue = hot.fatigue[b] - (hot.nominal_fatigue_per_minute[b] + hot.fatigue_noise[b]);
+
+        if (fatigue < 0.10)
+            fatigue = 0.10;
+
+        hot.fatigue[b] = hot.active[b] == 1 ? fatigue : hot.fatigue[b];
+
+        hot.tk_contrib[b] = hot.tk_lineup[b] * hot.fatigue[b] * hot.side_balance_mult[b];
+        hot.ps_contrib[b] = hot.ps_lineup[b] * hot.fatigue[b] * hot.side_balance_mult[b];
+        hot.sh_contrib[b] = hot.sh_lineup[b] * hot.fatigue[b] * hot.side_balance_mult[b];
+    }
+}
+
+
+// Calculates the side balance multipliers of the players - a
+// player's contributions are penalized when the side balance on
+// his position is bad
+//
+void match_context::calc_side_balance(int a)
+{
+    // The side balance:
+    // For each position (w/o side), count the number of players
+    // playing R, L, C on this position
+    //
+    int num_positions = tact_manager().get_positions_names().size();
+    vector<int> on_right(num_positions, 0), on_left(num_positions, 0), on_center(num_positions, 0);
+
+    // Go over the team's players and record on what side they play,
+    // updating the side balance
+    //
+    for (int b = 2; b <= num_players; b++)
+    {
+        if (team[a].hot.active[b] == 1 && team[a].player[b].pos_id >= 0)
+        {
+            if (team[a].player[b].side == 'R')
+                on_right[team[a].player[b].pos_id]++;
+            else if (team[a].player[b].side == 'L')
+                on_left[team[a].player[b].pos_id]++;
+            else if (team[a].player[b].side == 'C')
+                on_center[team[a].player[b].pos_id]++;
+            else
+                assert(0);
+        }
+    }
+
+    // For all positions, check if the side balance is equal for R and L
+    // If it isn't, penalize the contributions of the players on those positions
+    //
+    // Additionally, penalize teams who play with more than 3 C players on
+    // some position without R and L
+    //
+    vector<double> taxed_multiplier(num_positions, 1);
+
+    for (int pos = 0; pos < num_positions; ++pos)
+    {
+        if (on_left[pos] != on_right[pos])
+        {
+            double tax_ratio = 0.25 * double(abs(on_right[pos] - on_left[pos])) / (on_right[pos] + on_left[pos]);
+            taxed_multiplier[pos] = 1 - tax_ratio;
+        }
+        else if (on_left[pos] == 0 && on_right[pos] == 0 && on_center[pos] > 3)
+        {
+            taxed_multiplier[pos] = 0.87;
+        }
+    }
+
+    for (int b = 2; b <= num_players; b++)
+    {
+        if (team[a].hot.active[b] == 1 && team[a].player[b].pos_id >= 0)
+            team[a].hot.side_balance_mult[b] = taxed_multiplier[team[a].player[b].pos_id];
+        else
+            team[a].hot.side_balance_mult[b] = 1;
+    }
+}
+
+
+// Marks the lineup of team a as changed (by a substitution, a
+// tactic or position change, an injury or a red card), so that
+// recalculate_teams_data recalculates what depends on it
+//
+void match_context::lineup_changed(int a)
+{
+    team[a].lineup_changed = true;
+}
+
+
+void match_context::calc_shotprob(int a)
+{
+    // Note: 1.0 is added to tackling, to avoid singularity when the
+    // team tackling is 0
+    //
+    team[a].shot_prob = (double)1.8*(team[a].aggression/50.0 + 800.0 *
+                                     (double) pow(((1.0/3.0*team[a].team_shooting + 2.0/3.0*team[a].team_passing)
+                                                   / (team[!(a)].team_tackling + 1.0)), 2));
+
+    // If it is the home team, add home bonus
+    //
+    if (a == 0)
+        team[a].shot_prob += home_bonus;
+}
+
+
+// This function is called by the game running loop in the
+// beginning of each minute of the game.
+// It applies the fatigue of the minute, and recalculates player
+// contributions, team total contributions and shotprob. Aggression,
+// the players' lineup factors and the side balance are recalculated
+// only for a team whose lineup has changed.
+//
+void match_context::recalculate_teams_data(void)
+{
+    int a, b;
+
+    for(a = 0; a <= 1; a++)
+    {
+        team[a].team_tackling = team[a].team_passing=team[a].team_shooting = 0;
+
+        if (team[a].lineup_changed)
+            calc_aggression(a);
+
+        // The random part of the fatigue of the active players - drawn
+        // in the order of the players, apart from the vectorized loop
+        //
+        for (b = 2; b <= num_players; b++)
+        {
+            if (team[a].hot.active[b] == 1)
+            {
+                int mrnd = my_random(100);
+                team[a].hot.fatigue_noise[b] = double(mrnd - 50) / 50.0 * 0.003;
+            }
+            else
+                team[a].hot.fatigue_noise[b] = 0;
+        }
+
+        if (team[a].lineup_changed)
+        {
+            for (b = 2; b <= num_players; b++)
+                calc_player_lineup_factors(a, b);
+
+            calc_side_balance(a);
+            team[a].lineup_changed = false;
+        }
+
+        calc_fatigue_and_contributions(a);
+        calc_team_contributions_total(a);
+        invalidate_did_it_tables(a);
+    }
+
+    for (a = 0; a <= 1; a++)
+        calc_shotprob(a);
+}
+
+
+void match_context::calc_team_contributions_total(int a)
+{
+    for (int b = 2; b <= num_players; b++)
+        if (team[a].hot.active[b] == 1)
+        {
+            team[a].team_tackling += team[a].hot.tk_contrib[b];
+            team[a].team_passing  += team[a].hot.ps_contrib[b];
+            team[a].team_shooting += team[a].hot.sh_contrib[b];
+        }
+}
+
+
+// This function sets the aggression of all inactive players to 0
+// and then adds up all aggressions in the team total aggression
+void match_context::calc_aggression(int a)
+{
+    team[a].aggression = 0;
+
+    for (int i = 1;i <= num_players; ++i)
+    {
+        if (team[a].hot.active[i] != 1)
+            team[a].player[i].ag = 0;
+
+        team[a].aggression += team[a].player[i].ag;
+    }
+}
+
+
+// Called on each minute to handle a scoring chance of team
+// a for this minute.
+//
+void match_context::if_shot(int a)
+{
+    int shooter, assister, tackler;
+    int chance_tackled;
+    int chance_assisted = 0;
+
+    // Did a scoring chance occur ?
+    //
+    if (randomp((int) team[a].shot_prob))
+    {
+        // There's a 0.75 probability that a chance was assisted, and
+        // 0.25 that it's a solo
+        //
+        if (randomp(7500))
+        {
+            assister = who_did_it(a, DID_ASSIST);
+            chance_assisted = 1;
+
+            shooter = who_got_assist(a, assister);
+
+            add_event(MEV_CHANCE, a, shooter, assister);
+
+            if (play_by_play)
+                comm->write(comment(comm_rng, EV_ASSISTEDCHANCE, minute_str().c_str(),
+                        team[a].name, team[a].player[assister].name,
+                        team[a].player[shooter].name));
+            team[a].player[assister].keypasses++;
+        }
+        else
+        {
+            shooter = who_did_it(a, DID_SHOT);
+
+            chance_assisted = 0;
+            assister = 0;
+
+            add_event(MEV_CHANCE, a, shooter);
+            if (play_by_play)
+                comm->write(comment(comm_rng, EV_CHANCE, minute_str().c_str(), team[a].name,
+                        team[a].player[shooter].name));
+        }
+
+        chance_tackled = (int) (4000.0*((team[!a].team_tackling*3.0)/(team[a].team_passing*2.0+team[a].team_shooting)));
+
+        /* If the chance was tackled */
+        if (randomp(chance_tackled))
+        {
+            tackler = who_did_it(!a, DID_TACKLE);
+            team[!a].player[tackler].tackles++;
+
+            add_event(MEV_TACKLE, !a, tackler, shooter);
+
+            if (play_by_play)
+                comm->write(comment(comm_rng, EV_TACKLE, team[!a].player[tackler].name));
+        }
+        else /* Chance was not tackled, it will be a shot on goal */
+        {
+            if (play_by_play)
+                comm->write(comment(comm_rng, EV_SHOT, team[a].player[shooter].name));
+            team[a].player[shooter].shots++;
+
+            add_event(MEV_SHOT, a, shooter);
+
+            if (if_ontarget(a, shooter))
+            {
+                team[a].finalshots_on++;
+                team[a].player[shooter].shots_on++;
+
+                if (if_goal(a, shooter))
+                {
+                    if (play_by_play)
+                        comm->write(comment(comm_rng, EV_GOAL));
+
+                    if (is_goal_cancelled())
+                        add_event(MEV_GOAL_CANCELLED, a, shooter);
+                    else
+                    {
+                        team[a].score++;
+
+                        // If the assister was the shooter, there was no
+                        // assist, but a simple goal.
+                        //
+                        bool assisted = chance_assisted && (assister != shooter);
+
+                        if (assisted)
+                            team[a].player[assister].assists++; /* For final stats */
+
+                        add_event(MEV_GOAL, a, shooter, assisted ? assister : 0, team[!a].current_gk);
+
+                        team[a].player[shooter].goals++;
+                        team[!a].player[team[!a].current_gk].conceded++;
+
+                        if (play_by_play)
+                            comm->print("\n          ...  %s %d-%d %s ...",
+                                    team[0].name,
+                                    team[0].score,
+                                    team[1].score,
+                                    team[1].name);
+
+                        report_event* an_event = new report_event_goal(team[a].player[shooter].name,
+                                                 team[a].name, formal_minute_str().c_str());
+
+                        report_vec.push_back(an_event);
+                    }
+                }
+                else
+                {
+                    if (play_by_play)
+                        comm->write(comment(comm_rng, EV_SAVE,
+                                team[!a].player[team[!a].current_gk].name));
+                    team[!a].player[team[!a].current_gk].saves++;
+
+                    add_event(MEV_SAVE, !a, team[!a].current_gk, shooter);
+                }
+            }
+            else
+            {
+                team[a].player[shooter].shots_off++;
+
+                add_event(MEV_OFF_TARGET, a, shooter);
+                if (play_by_play)
+                    comm->write(comment(comm_rng, EV_OFFTARGET));
+                team[a].finalshots_off++;
+            }
+        }
+    }
+}
+
+
+// Given a team and an event (eg. SHOT)
+// picks one player at (weighted) random
+// that performed this event.
+//
+// For example, for SHOT, pick a player
+// at weighted random according to his
+// shooting skill
+//
+int match_context::who_did_it(int a, DID_WHAT event)
+{
+    // Employs the weighted random algorithm
+    // A player's chance to DO_IT is his
+    // contribution relative to the team's total
+    // contribution
+    //
+    double total;
+
+    switch(event)
+    {
+    case DID_SHOT:
+        total = team[a].team_shooting * 100.0;
+        break;
+    case DID_FOUL:
+        total = team[a].aggression;
+        break;
+    case DID_TACKLE:
+        total = team[a].team_tackling * 100.0;
+        break;
+    default:
+        total = team[a].team_passing * 100.0;
+        break;
+    }
+
+    if (!team[a].did_it_table_valid[event])
+        build_did_it_table(a, event);
+
+    unsigned rand_value = my_random((int) total);
+
+    // The first player (from player 2) whose cumulative weight is
+    // above rand_value. The table is non-decreasing, so a binary
+    // search finds him.
+    //
+    const double* table = team[a].did_it_table[event];
+    const double* found = upper_bound(table + 2, table + num_players + 1, double(rand_value));
+
+    // The total is the team's total rounded down, so there always
+    // is such a player - but the sums may be rounded differently
+    //
+    if (found == table + num_players + 1)
+        return num_players;
+
+    return found - table;
+}
+
+
+// Builds the table who_did_it picks players for the event from
+//
+void match_context::build_did_it_table(int a, DID_WHAT event)
+{
+    const double* contrib;
+
+    switch(event)
+    {
+    case DID_SHOT:
+        contrib = team[a].hot.sh_contrib;
+        break;
+    case DID_TACKLE:
+        contrib = team[a].hot.tk_contrib;
+        break;
+    case DID_ASSIST:
+        contrib = team[a].hot.ps_contrib;
+        break;
+    default:
+        contrib = 0;
+        break;
+    }
+
+    double* table = team[a].did_it_table[event];
+    double weight = 0;
+
+    for (int k = 1; k <= num_players; ++k)
+    {
+        if (event == DID_FOUL)
+            weight += team[a].player[k].ag;
+        else
+            weight += contrib[k] * 100.0;
+
+        table[k] = weight;
+
+        // Keep the table non-decreasing. The first player whose entry
+        // is above a value is the same as with the plain sums.
+        //
+        if (k > 2 && table[k] < table[k - 1])
+            table[k] = table[k - 1];
+    }
+
+    team[a].did_it_table_valid[event] = true;
+}
+
+
+void match_context::invalidate_did_it_tables(int a)
+{
+    for (int event = 0; event < NUM_DID_WHAT; ++event)
+        team[a].did_it_table_valid[event] = false;
+}
+
+
+// When a chance was generated for the team and assisted by the
+// assister, who got the assist ?
+//
+// This is almost like who_did_it, but it also takes
+// into account the side of the assister - a player on his side
+// has a higher chance to get the assist.
+//
+// How it's done: if the side of the shooter (picked by who_did_it)
+// is different from the side of the asssiter, who_did_it is run
+// once again - but this happens only once. This increases the
+// chance of the player on the same side to be picked, but leaves
+// a possibility for other sides as well.
+//
+int match_context::who_got_assist(int a, int assister)
+{
+    int shooter = assister;
+
+    // Shooter and assister must be different, so re-run each time the same
+    // one is generated
+    //
+    while (shooter == assister)
+    {
+        shooter = who_did_it(a, DID_SHOT);
+
+        // if the side is different, re-run once
+        //
+        if (team[a].player[shooter].side != team[a].player[assister].side)
+        {
+            shooter = who_did_it(a, DID_SHOT);
+        }
+    }
+
+    return shooter;
+}
+
+
+/* Whether the shot is on target. */
+int match_context::if_ontarget(int a, int b)
+{
+    if (randomp((int) (5800.0*team[a].hot.fatigue[b])))
+        return 1;
+    else
+        return 0;
+}
+
+
+// Given a shot on target (team a shot on team b's goal),
+// was it a goal ?
+//
+int match_context::if_goal(int a, int b)
+{
+    // Factors taken into account:
+    // The shooter's Sh and fatigue against the GK's St
+    //
+    // The "median" is 0.35
+    // Lower and upper bounds are 0.1 and 0.9 respectively
+    //
+    double temp = team[a].player[b].sh*team[a].hot.fatigue[b]*200 -
+                  team[!a].player[team[!a].current_gk].st*200 + 3500;
+
+    if (temp > 9000)
+        temp = 9000;
+    if (temp < 1000)
+        temp = 1000;
+
+    if (randomp((int)temp))
+        return 1;
+    else
+        return 0;
+}
+
+
+int match_context::is_goal_cancelled(void)
+{
+    if (randomp(500))
+    {
+        if (play_by_play)
+            comm->write(comment(comm_rng, EV_GOALCANCELLED));
+        return 1;
+    }
+
+    return 0;
+}
+
+
+// Handle fouls (called on each minute with for each team)
+//
+void match_context::if_foul(int a)
+{
+    int fouler;
+
+    if (randomp((int)team[a].aggression*3/4))
+    {
+        fouler = who_did_it(a, DID_FOUL);
+
+        add_event(MEV_FOUL, a, fouler);
+        if (play_by_play)
+            comm->write(comment(comm_rng, EV_FOUL, minute_str().c_str(), team[a].name,
+                    team[a].player[fouler].name));
+
+        team[a].finalfouls++;         /* For final stats */
+        team[a].player[fouler].fouls++;
+
+        /* The chance of the foul to result in a yellow or red card */
+        if (randomp(6000))
+            bookings(a, fouler, YELLOW);
+        else if (randomp(400))
+            bookings(a, fouler, RED);
+        else
+            if (play_by_play)
+                comm->write(comment(comm_rng, EV_WARNED));
+
+        /* Condition for a penalty to occur (if GK fouled, or random) */
+        if ((fouler == team[a].current_gk) || (randomp(500)))
+        {
+            // If the nominated PK taker isn't active, choose the
+            // best shooter to take the PK
+            //
+            if (team[!a].hot.active[team[!a].penalty_taker] != 1 || team[!a].penalty_taker == -1)
+            {
+                double max = -1;
+                int max_index = 1;
+
+                for (int i = 1; i <= num_players; ++i)
+                {
+                    if (team[!a].hot.active[i] == 1 && team[!a].player[i].sh * team[!a].hot.fatigue[i] > max)
+                    {
+                        max = team[!a].player[i].sh * team[!a].hot.fatigue[i];
+                        max_index = i;
+                    }
+                }
+
+                team[!a].penalty_taker = max_index;
+            }
+
+            if (play_by_play)
+                comm->write(comment(comm_rng, EV_PENALTY,
+                        team[!a].player[team[!a].penalty_taker].name));
+
+            /* If Penalty... Goal ? */
+            if (randomp(8000 + team[!a].player[team[!a].penalty_taker].sh*100 -
+                        team[a].player[team[a].current_gk].st*100))
+            {
+                if (play_by_play)
+                    comm->write(comment(comm_rng, EV_GOAL));
+                team[!a].score++;
+                team[!a].player[team[!a].penalty_taker].goals++;
+                team[a].player[team[a].current_gk].conceded++;
+
+                add_event(MEV_PENALTY, !a, team[!a].penalty_taker, team[a].current_gk, PEN_SCORED);
+                if (play_by_play)
+                    comm->print("\n          ...  %s %d-%d %s...", team[0].name, team[0].score,
+                            team[1].score,  team[1].name);
+
+                report_event* an_event = new report_event_penalty(team[!a].player[team[!a].penalty_taker].name,
+                                         team[!a].name, formal_minute_str().c_str());
+                report_vec.push_back(an_event);
+
+            }
+            else /* If the penalty taker didn't score */
+            {
+                // Either it was saved, or it went off-target
+                //
+                if (randomp(7500))
+                {
+                    add_event(MEV_PENALTY, !a, team[!a].penalty_taker, team[a].current_gk, PEN_SAVED);
+
+                    if (play_by_play)
+                        comm->write(comment(comm_rng, EV_SAVE,
+                                team[a].player[team[a].current_gk].name));
+                }
+                else  /* Or it went off-target */
+                {
+                    add_event(MEV_PENALTY, !a, team[!a].penalty_taker, team[a].current_gk, PEN_OFF_TARGET);
+
+                    if (play_by_play)
+                        comm->write(comment(comm_rng, EV_OFFTARGET));
+                }
+            }
+        }
+    }
+}
+
+
+// Deals with yellow and red cards
+//
+void match_context::bookings(int a, int b, int card_color)
+{
+    if (card_color == YELLOW)
+    {
+        if (play_by_play)
+            comm->write(comment(comm_rng, EV_YELLOWCARD));
+        team[a].player[b].yellowcards++;
+
+        add_event(MEV_YELLOW_CARD, a, b);
+
+        // A second yellow card is equal to a red card
+        //
+        if (team[a].player[b].yellowcards == 2)
+        {
+            if (play_by_play)
+                comm->write(comment(comm_rng, EV_SECONDYELLOWCARD));
+            send_off(a, b);
+
+            report_event* an_event = new report_event_red_card(team[a].player[b].name,
+                                     team[a].name, formal_minute_str().c_str());
+            report_vec.push_back(an_event);
+
+            red_carded[a] = b;
+        }
+        else
+            yellow_carded[a] = b;
+    }
+    else if (card_color == RED)
+    {
+        if (play_by_play)
+            comm->write(comment(comm_rng, EV_REDCARD));
+        send_off(a, b);
+
+        report_event* an_event = new report_event_red_card(team[a].player[b].name,
+                                 team[a].name, formal_minute_str().c_str());
+        report_vec.push_back(an_event);
+
+        red_carded[a] = b;
+    }
+}
+
+
+void match_context::send_off(int a, int b)
+{
+    add_event(MEV_RED_CARD, a, b, 0, team[a].player[b].yellowcards == 2);
+
+    team[a].player[b].yellowcards = 0;
+    team[a].player[b].redcards++;
+    team[a].hot.active[b] = 0;
+    lineup_changed(a);
+
+    if (team[a].current_gk == b)  /* If a GK was sent off */
+    {
+        int i = 12, found = 0;
+
+        if (team[a].substitutions < 3)
+        {
+            while (!found && i <= num_players)  /* Look for a keeper on the bench */
+            {
+                /* If found a keeper */
+                if (!strcmp(team[a].player[i].pos, "GK") && team[a].hot.active[i] == 2)
+                {
+                    int n = 11;
+
+                    found = 1;
+
+                    while(team[a].hot.active[n] != 1)  /* Sub him for another player */
+                        n--;
+                    substitute_player(a, n, i, "GK");
+                    team[a].current_gk = i;
+                }
+                else
+                {
+                    found = 0;
+                    i++;
+                }
+            }
+
+            if (!found)         /*  If there was no keeper on the bench   */
+            {                   /*  Change the position of another player */
+                int n = 11;       /*  (who is on the field) to GK           */
+
+                while(team[a].hot.active[n] != 1)
+                    n--;
+
+                change_position(a, n, string("GK"));
+                team[a].current_gk = n;
+            }
+        }
+        else      /* If substitutions >= 3 */
+        {
+            int n = 11;
+
+            while(team[a].hot.active[n] != 1)
+                n--;
+            change_position(a, n, string("GK"));
+            team[a].current_gk = n;
+        }
+    }
+}
+
+
+/* This function uses the constants contained in league.dat */
+/* to calculate the ability change of each player.          */
+void match_context::calc_ability(void)
+{
+    int i, j;
+
+    // Initialization of ab bonuses
+    //
+    int ab_goal       = the_config().get_int_config("AB_GOAL", 0);
+    int ab_assist     = the_config().get_int_config("AB_ASSIST", 0);
+    int ab_victory    = the_config().get_int_config("AB_VICTORY_RANDOM", 0);
+    int ab_defeat     = the_config().get_int_config("AB_DEFEAT_RANDOM", 0);
+    int ab_cleansheet = the_config().get_int_config("AB_CLEAN_SHEET", 0);
+    int ab_ktk        = the_config().get_int_config("AB_KTK", 0);
+    int ab_kps        = the_config().get_int_config("AB_KPS", 0);
+    int ab_sht_on     = the_config().get_int_config("AB_SHT_ON", 0);
+    int ab_sht_off    = the_config().get_int_config("AB_SHT_OFF", 0);
+    int ab_sav        = the_config().get_int_config("AB_SAV", 0);
+    int ab_concede    = the_config().get_int_config("AB_CONCDE", 0);
+    int ab_yellow     = the_config().get_int_config("AB_YELLOW", 0);
+    int ab_red        = the_config().get_int_config("AB_RED", 0);
+
+    for (j = 0; j <= 1; ++j)
+    {
+        // Add simple bonuses
+        //
+        for (i = 1; i <= num_players; ++i)
+        {
+            team[j].player[i].sh_ab += ab_goal * team[j].player[i].goals;
+            team[j].player[i].ps_ab += ab_assist * team[j].player[i].assists;
+            team[j].player[i].tk_ab += ab_ktk * team[j].player[i].tackles;
+            team[j].player[i].ps_ab += ab_kps * team[j].player[i].keypasses;
+            team[j].player[i].sh_ab += ab_sht_on * team[j].player[i].shots_on;
+            team[j].player[i].sh_ab += ab_sht_off * team[j].player[i].shots_off;
+            team[j].player[i].st_ab += ab_sav * team[j].player[i].saves;
+            team[j].player[i].st_ab += ab_concede * team[j].player[i].conceded;
+
+            // For cards, all abilities are decreased (only St for a GK)
+            //
+            if (!strcmp(team[j].player[i].pos, "GK"))
+            {
+                team[j].player[i].st_ab += ab_yellow * team[j].player[i].yellowcards;
+                team[j].player[i].st_ab += ab_red * team[j].player[i].redcards;
+            }
+            else
+            {
+                team[j].player[i].tk_ab += ab_yellow * team[j].player[i].yellowcards;
+                team[j].player[i].ps_ab += ab_yellow * team[j].player[i].yellowcards;
+                team[j].player[i].sh_ab += ab_yellow * team[j].player[i].yellowcards;
+
+                team[j].player[i].tk_ab += ab_red * team[j].player[i].redcards;
+                team[j].player[i].ps_ab += ab_red * team[j].player[i].redcards;
+                team[j].player[i].sh_ab += ab_red * team[j].player[i].redcards;
+            }
+        }
+
+        // Add random-victory bonuses
+        //
+        if (team[j].score > team[!j].score)
+        {
+            int num = 0, k, n;
+
+            for (k = 1; k <= 2; k++)
+            {
+                //
+                // Find a player to get the increase
+                //
+                do
+                {
+                    n = my_random(num_players) + 1;
+
+                }
+                while(!team[j].player[n].minutes || n == num);
+
+                //
+                // Decide the ability which gets the increase
+                //
+                if (!strcmp(team[j].player[n].pos, "GK"))
+                    team[j].player[n].st_ab += ab_victory;
+                else
+                {
+                    team[j].player[n].tk_ab += ab_victory;
+                    team[j].player[n].ps_ab += ab_victory;
+                    team[j].player[n].sh_ab += ab_victory;
+                }
+
+                num = n;
+            }
+        }
+
+        //
+        // Decrease random-defeat bonuses
+        //
+        if (team[j].score < team[!j].score)
+        {
+            int num = 0, k, n;
+
+            for (k = 1; k <= 2; k++)
+            {
+
+                //
+                // Decide the player to get the decrease
+                //
+                do
+                {
+                    n = my_random(num_players) + 1;
+
+                }
+                while(!team[j].player[n].minutes || n == num);
+
+                //
+                // Decide the ability which gets the decrease
+                //
+                if (!strcmp(team[j].player[n].pos, "GK"))
+                    team[j].player[n].st_ab += ab_defeat;
+                else
+                {
+                    team[j].player[n].tk_ab += ab_defeat;
+                    team[j].player[n].ps_ab += ab_defeat;
+                    team[j].player[n].sh_ab += ab_defeat;
+                }
+
+                num = n;
+            }
+        }
+
+        //
+        // Add clean sheet bonus
+        //
+        if (team[!j].score == 0)
+        {
+            int n = 0;
+
+            do
+            {
+                n++;
+
+                if (n >= num_players)
+                    break;
+
+            }
+            while(team[j].player[n].minutes < 46 || (strcmp(team[j].player[n].pos,"GK")));
+
+            if (n >= num_players)
+                n = 1;
+
+            team[j].player[n].st_ab += ab_cleansheet;
+
+            do
+            {
+                n = my_random(num_players) + 1;
+
+            }
+            while(!team[j].player[n].minutes || (strcmp(team[j].player[n].pos,"DF")));
+
+            team[j].player[n].tk_ab += ab_cleansheet;
+        }
+    }
+}
+
+
+// Prints after-game statistics into the commentary file. The shots on/off
+// of each team, final score, stats (tackles, assists etc) for each player,
+// etc.
+//
+void match_context::print_final_stats(void)
+{
+    int i;
+
+    if (!comm->wants_stats())
+        return;
+
+    // Print shots on/off target and final score
+    comm->print("\n\n%-22s: %s %2d %s %d", comment(stats_rng, EV_COMM_SHOTSOFFTARGET),
+            team[0].name,
+            team[0].finalshots_off,
+            team[1].name,
+            team[1].finalshots_off);
+
+    comm->print("%-22s: %s %2d %s %d", comment(stats_rng, EV_COMM_SHOTSONTARGET),
+            team[0].name,
+            team[0].finalshots_on,
+            team[1].name,
+            team[1].finalshots_on);
+
+    comm->print("\n%-22s: %s %2d %s %d\n",  comment(stats_rng, EV_COMM_SCORE),
+            team[0].name,
+            team[0].score,
+            team[1].name,
+            team[1].score);
+
+    // Print final stats for players
+
+    for (int j = 0; j <= 1; j++)
+    {
+        comm->print("\n\n<<< %s >>>\n", comment(stats_rng, EV_COMM_STATISTICS, team[j].fullname));
+        comm->print("\nName          Pos Prs St Tk Ps Sh Sm | Min Sav Ktk Kps Ass Sht Gls Yel Red Inj KAb TAb PAb SAb Fit");
+        comm->print("\n--------------------------------------------------------------------------------------------------");
+        // Totals
+        int t_saves = 0, t_tackles = 0, t_keypasses = 0, t_assists = 0,
+                                     t_shots = 0, t_goals = 0, t_yellowcards = 0, t_redcards = 0, t_injured = 0;
+        ;
+
+        // Print stats for each player and collect totals
+        for (i = 1; i <= num_players; i++)
+        {
+            comm->print("\n%-13s %3s %3s%3d%3d%3d%3d%3d | %3d %3d %3d %3d %3d %3d %3d %3d %3d %3d %3d %3d %3d %3d %3d",
+                    team[j].player[i].name,
+                    pos_and_side2fullpos(team[j].player[i].pos, team[j].player[i].side).c_str(),
+                    team[j].player[i].pref_side,
+                    team[j].player[i].st, team[j].player[i].tk,
+                    team[j].player[i].ps, team[j].player[i].sh,
+                    team[j].player[i].stamina,
+                    team[j].player[i].minutes,
+                    team[j].player[i].saves, team[j].player[i].tackles,
+                    team[j].player[i].keypasses, team[j].player[i].assists,
+                    team[j].player[i].shots, team[j].player[i].goals,
+                    team[j].player[i].yellowcards,
+                    team[j].player[i].redcards,
+                    team[j].player[i].injured,
+                    team[j].player[i].st_ab,
+                    team[j].player[i].tk_ab,
+                    team[j].player[i].ps_ab,
+                    team[j].player[i].sh_ab,
+                    int(team[j].hot.fatigue[i] * 100.0));
+
+            t_saves += team[j].player[i].saves;
+            t_tackles += team[j].player[i].tackles;
+            t_keypasses += team[j].player[i].keypasses;
+            t_assists += team[j].player[i].assists;
+            t_shots += team[j].player[i].shots;
+            t_goals += team[j].player[i].goals;
+            t_injured += team[j].player[i].injured;
+            t_yellowcards += team[j].player[i].yellowcards;
+            t_redcards += team[j].player[i].redcards;
+        }
+
+        comm->print("\n-- Total --");
+        comm->print("                                %3d %3d %3d %3d %3d %3d %3d %3d %3d\n",
+                t_saves, t_tackles, t_keypasses, t_assists, t_shots, t_goals, t_yellowcards, t_redcards, t_injured);
+    }
+
+
+    if (team_stats_total_enabled)
+    {
+        comm->print("\n\nTeam totals");
+        comm->print("\nTeam  Min        Tk       Ps       Sh");
+        comm->print("\n-------------------------------------");
+
+        for (i = 0; i < 10; ++i)
+        {
+            comm->print("\n%s    %2d    %6.2f   %6.2f   %6.2f",
+                    team[0].name, i*10,
+                    teamStatsTotal[0][i][0],
+                    teamStatsTotal[0][i][1],
+                    teamStatsTotal[0][i][2]);
+
+            comm->print("\n%s    %2d    %6.2f   %6.2f   %6.2f",
+                    team[1].name, i*10,
+                    teamStatsTotal[1][i][0],
+                    teamStatsTotal[1][i][1],
+                    teamStatsTotal[1][i][2]);
+        }
+    }
+}
+
+
+// Updates the game reports file with info
+// about the current game
+//
+void match_context::update_reports_file(string work_dir)
+{
+    string reports_filename = work_dir + "reports.txt";
+
+    // Add the game score
+    //
+    string report = format_str("\n%s %d - %d %s\n", team[0].fullname, team[0].score,
+                               team[1].score, team[1].fullname);
+
+    // Add info about the goals scored
+    //
+    for (unsigned i = 0; i < report_vec.size(); i++)
+        report += report_vec[i]->get_event();
+
+    report += "\n";
+
+    string msg = append_league_file(reports_filename, report);
+
+    if (msg != "")
+        die("Can't update reports.txt: %s", msg.c_str());
+}
+
+
+// Create stats.dir
+//
+void match_context::create_stats_file(string work_dir)
+{
+    FILE *statsdirfile;
+
+    string stats_file_name_no_dir = string(team[0].name) + "_" + string(team[1].name) + ".txt";
+    string stats_file_name = work_dir + stats_file_name_no_dir;
+    string stats_dir_file_name = work_dir + "stats.dir";
+
+    statsdirfile = fopen(stats_dir_file_name.c_str(), "a");
+    fprintf(statsdirfile, "%s\n", stats_file_name_no_dir.c_str());
+
+    fclose(statsdirfile);
+}
+
+
+// Writes the events of the match to <home>_<away>.evt (format
+// "bin") or <home>_<away>.jsonl (format "json")
+//
+void match_context::write_events_file(string work_dir, string format)
+{
+    match_record record;
+    fill_match_record(record);
+
+    string events_file_name = work_dir + string(team[0].name) + "_" + string(team[1].name) +
+                              (format == "json" ? ".jsonl" : ".evt");
+
+    FILE* events_file = fopen(events_file_name.c_str(), format == "json" ? "w" : "wb");
+
+    if (!events_file)
+        die("Can't open %s: %s", events_file_name.c_str(), strerror(errno));
+
+    bool ok = format == "json" ? write_match_record_json(events_file, record)
+                               : write_match_record_binary(events_file, record);
+
+    if (!ok)
+        die("Can't write %s: %s", events_file_name.c_str(), strerror(errno));
+
+    fclose(events_file);
+}
+
+
+// Fills stats with the final stats of the players, as they're printed
+// in the final stats table (see print_final_stats)
+//
+void match_context::fill_final_stats(vector<match_player_stats> stats[2])
+{
+    for (int j = 0; j <= 1; ++j)
+    {
+        stats[j].assign(num_players + 1, match_player_stats());
+
+        for (int i = 1; i <= num_players; ++i)
+        {
+            const playerstruct& p = team[j].player[i];
+            match_player_stats& s = stats[j][i];
+
+            s.name = p.name;
+            s.pos = pos_and_side2fullpos(p.pos, p.side).c_str();
+            s.minutes = p.minutes;
+            s.saves = p.saves;
+            s.tackles = p.tackles;
+            s.keypasses = p.keypasses;
+            s.assists = p.assists;
+            s.shots = p.shots;
+            s.goals = p.goals;
+            s.yellowcards = p.yellowcards;
+            s.redcards = p.redcards;
+            s.injured = p.injured;
+            s.fouls = p.fouls;
+            s.shots_on = p.shots_on;
+            s.shots_off = p.shots_off;
+            s.conceded = p.conceded;
+            s.st_ab = p.st_ab;
+            s.tk_ab = p.tk_ab;
+            s.ps_ab = p.ps_ab;
+            s.sh_ab = p.sh_ab;
+            s.fitness = int(team[j].hot.fatigue[i] * 100.0);
+        }
+    }
+}
+
+
+// Writes the final stats of the match to <home>_<away>.sts, next to
+// the commentary file listed in stats.dir. updtr reads the stats from
+// there instead of from the commentary (see get_players_game_stats),
+// as long as the commentary is still the one given here.
+//
+void match_context::write_stats_record(string work_dir, const string& commentary)
+{
+    vector<match_player_stats> stats[2];
+    fill_final_stats(stats);
+
+    string team_name[2] = {team[0].name, team[1].name};
+    string stats_record_name = work_dir + team_name[0] + "_" + team_name[1] + ".sts";
+
+    FILE* stats_record = fopen(stats_record_name.c_str(), "wb");
+
+    if (!stats_record)
+        die("Can't open %s: %s", stats_record_name.c_str(), strerror(errno));
+
+    if (!write_match_stats_binary(stats_record, team_name, stats, commentary))
+        die("Can't write %s: %s", stats_record_name.c_str(), strerror(errno));
+
+    fclose(stats_record);
+}
+
+
+// Generate a random number up to 10000. If the given p is
+// less than the generated number, return 1, otherwise return 0
+//
+// Used to "throw dice" and check if an event with some probability
+// happened. p is 0..10000 - for example 2000 means probability 0.2
+// So when 2000 is given, this function simulates an event with
+// probability 0.2 and tells if it happened (naturally it has
+// a prob. of 0.2 to happen)
+//
+// This is my_random(10000) < p, but instead of finding the bucket
+// of the random number (see rng_stream::below) it's compared with
+// the lower bound of bucket p - a single integer compare.
+//
+int match_context::randomp(int p)
+{
+    const unsigned bucket = 0xffffffffu / 10000;
+    const unsigned limit = bucket * 10000;
+    unsigned r;
+
+    do
+    {
+        r = rng.next();
+    }
+    while (r >= limit);
+
+    if (p <= 0)
+        return 0;
+    else if (p >= 10000)
+        return 1;
+    else
+        return r < (unsigned) p * bucket ? 1 : 0;
+}
+
+
+// Returns a pseudo-random integer between 0 and N-1
+//
+unsigned match_context::my_random(int n)
+{
+    return rng.below(n);
+}
+
+
+/// Adds one minute to the "minutes played" stats of all currently active
+/// players in both teams.
+///
+void match_context::update_players_minute_count(void)
+{
+    int i, j;
+
+    for (j = 0; j <= 1; j++)
+        for (i = 1; i <= num_players; i++)
+        {
+            if (team[j].hot.active[i] == 1)
+                team[j].player[i].minutes++;
+        }
+}
+
+
+/// Checks whether the conds of a team should be activated.
+///
+/// Ran for each team on every minute by the main loop.
+///
+void match_context::check_conditionals(int team_num)
+{
+    vector<cond*>::iterator iter;
+
+    for (iter = team[team_num].conds.begin(); iter != team[team_num].conds.end(); ++iter)
+        (*iter)->test_and_execute();
+}
+
+
+/// Called in the beginning of every minute to clean the indicators
+/// of injuries, yellow and red cards (that are used by conditionals).
+///
+void match_context::clean_inj_card_indicators(void)
+{
+    injured_ind[0] = injured_ind[1] = -1;
+    yellow_carded[0] = yellow_carded[1] = red_carded[0] = red_carded[1] = -1;
+}
+
@@ -2,7 +2,7 @@
 // Copyright (C) <1998-2005>  Eli Bendersky
 //
 // This program is free software, licensed with the GPL (www.fsf.org)
-// 
+//
 #ifndef GAME_H
 #define GAME_H
 
@@ -17,16 +17,19 @@
 #include <cstring>
 #include <cerrno>
 #include <climits>
+#include <vector>
 
 using namespace std;
 
 
 #include "rosterplayer.h"
 #include "teamsheet_reader.h"
+#include "report_event.h"
 #include "cond.h"
-
-
-extern int num_players;
+#include "rng.h"
+#include "commentary_sink.h"
+#include "comment.h"
+#include "match_events.h"
 
 
 /* Bookings control */
@@ -35,6 +38,11 @@ extern int num_players;
 
 const unsigned CHAR_BUF_LEN = 256;
 
+// The size of the player arrays of a team (players are numbered
+// from 1, as in the teamsheet)
+//
+const int MAX_TEAM_PLAYERS = 25;
+
 
 // Represents a player during the simulation
 //
@@ -48,6 +56,9 @@ struct playerstruct
 	// 1-char side (L, R, C)
 	char side;
 
+	// pos as a tactics_manager position id (-1 for a GK)
+	int pos_id;
+
 	char pref_side[CHAR_BUF_LEN];
 	int st;
 	int tk;
@@ -63,16 +74,11 @@ struct playerstruct
 	bool likes_right;
 	bool likes_center;
 
-	// These are used only in the game running phase
-	double tk_contrib;
-	double ps_contrib;
-	double sh_contrib;
-	double nominal_fatigue_per_minute;
-	double fatigue;
+	// These are used only in the game running phase (see also
+	// players_hot_data)
+	//
 	int injured;     // 0 - no; 1 - yes (For the updater)
 
-	int active;      // Status: 0 - unavailable; 1 - playing  2 - available for substitution
-
 	// final stats
 	int minutes;
 	int shots;
@@ -98,6 +104,48 @@ struct playerstruct
 };
 
 
+// The data of the players of a team that the game running loop
+// reads or writes every minute, as arrays indexed by the number of
+// the player. It's kept apart from playerstruct (whose names and
+// stats are needed only on events), so a minute touches a few cache
+// lines per team, and the fatigue and contributions of all the
+// players are computed in one loop that the compiler can vectorize.
+//
+struct players_hot_data
+{
+	// Status: 0 - unavailable; 1 - playing  2 - available for substitution
+	//
+	int active[MAX_TEAM_PLAYERS];
+
+	double fatigue[MAX_TEAM_PLAYERS];
+	double nominal_fatigue_per_minute[MAX_TEAM_PLAYERS];
+
+	// The random part of the fatigue of this minute
+	//
+	double fatigue_noise[MAX_TEAM_PLAYERS];
+
+	// The contributions without fatigue and side balance, which
+	// change only when the lineup of the team changes
+	//
+	double tk_lineup[MAX_TEAM_PLAYERS];
+	double ps_lineup[MAX_TEAM_PLAYERS];
+	double sh_lineup[MAX_TEAM_PLAYERS];
+
+	// The side balance penalty of the player's position (1 for none)
+	//
+	double side_balance_mult[MAX_TEAM_PLAYERS];
+
+	double tk_contrib[MAX_TEAM_PLAYERS];
+	double ps_contrib[MAX_TEAM_PLAYERS];
+	double sh_contrib[MAX_TEAM_PLAYERS];
+};
+
+
+// For the who_did_it function
+//
+enum DID_WHAT {DID_SHOT, DID_FOUL, DID_TACKLE, DID_ASSIST, NUM_DID_WHAT};
+
+
 // Represents a team during simulation
 //
 struct teams
@@ -117,69 +165,296 @@ struct teams
 	char fullname[CHAR_BUF_LEN];
 	char tactic[2];
 
+	// tactic as a tactics_manager tactic id
+	int tactic_id;
+
+	// Set when a substitution, a tactic or position change, an injury
+	// or a red card changes the lineup - the lineup factors, the side
+	// balance and the aggression of the team are recalculated then
+	//
+	bool lineup_changed;
+
 	// If this is -1, the team has no preselected PK taker (the best shooter will
-	// take the penalties). Otherwise, this is the number of the PK taker as 
+	// take the penalties). Otherwise, this is the number of the PK taker as
 	// specified in the teamsheet.
 	//
 	int penalty_taker;
-	
-	int current_gk;         
-	struct playerstruct player[25];      
-	
+
+	int current_gk;
+	struct playerstruct player[MAX_TEAM_PLAYERS];
+	struct players_hot_data hot;
+
+	// The tables who_did_it picks players from, one for each kind of
+	// event: did_it_table[event][k] (k >= 2) is the largest sum of the
+	// weights of players 1..j for j = 2..k. They're built on first use
+	// after the contributions or the aggression of the team change.
+	//
+	double did_it_table[NUM_DID_WHAT][MAX_TEAM_PLAYERS];
+	bool did_it_table_valid[NUM_DID_WHAT];
+
 	RosterPlayerArray roster_players;
 
+	// The names of the players in the teamsheet - player n has the
+	// id n - 1 (once ensure_no_duplicate_names passed)
+	//
+	name_index player_names;
+
 	vector<cond*> conds;
 };
 
 
-/**** Declaration of functions in use (from file esms.cpp) ***
-*/
-void init_teams_data(teamsheet_reader teamsheet[2]);
-void ensure_no_duplicate_names(void);
-void read_conditionals(teamsheet_reader teamsheet[2]);
-void print_starting_tactics(void);
-void calc_team_contributions_total(int a);
-void calc_aggression(int a);
-void calc_player_contributions(int a,int b);
-void recalculate_teams_data(void);
-void substitute_player(int a, int out, int in, string newpos);
-void change_tactic(int a, const char* newtct);
-void change_position(int a, int b, string newpos);
-void calc_shotprob(int a);
-void random_injury(int a);
-void if_shot(int a);
-int  if_ontarget(int a, int b);
-int  if_goal(int a, int b);
-int  is_goal_cancelled(void);
-void if_foul(int a);
-void bookings(int a, int b, int card_color);
-void send_off(int a, int b);
-void calc_ability(void);
-int  randomp(int p);
-unsigned  my_random(int n);
-void clean_inj_card_indicators(void);
-void update_players_minute_count(void);
-void add_team_stats_total(void);
-void print_final_stats(void);      
-void create_stats_file(string);   
-void update_reports_file(string); 
-void cond_error(int team_num, int line, string msg);
-void check_conditionals(int team_num);
-
-int who_got_assist(int team, int assister);
+// How to decide whether a penalty shootout is run after the
+// game (see simulate_match)
+//
+enum shootout_policy
+{
+    SHOOTOUT_NEVER,     // never
+    SHOOTOUT_ALWAYS,    // always
+    SHOOTOUT_ON_SCORE,  // if the score is shootout_score ("2-2")
+    SHOOTOUT_ON_DIFF,   // if the home - away difference is shootout_diff
+    SHOOTOUT_ASK        // ask the user on the console
+};
 
-// For the who_did_it function
+
+// Everything a match needs to be simulated.
+//
+// The teamsheets are positioned after the team name line (their
+// names are in team_name), and the rosters are the full rosters
+// of the teams. The shared data (league.dat, tactics.dat and
+// language.dat) is not included - it's loaded once per process
+// into the_config(), tact_manager() and the_commentary().
+//
+struct match_inputs
+{
+    match_inputs()
+        : comm(0), record_events(false), shootout(SHOOTOUT_NEVER), shootout_diff(0)
+    {}
+
+    string team_name[2];
+    teamsheet_reader teamsheet[2];
+    RosterPlayerArray roster[2];
+
+    // The random stream of the match - usually created from the
+    // league seed, the week and the fixture (see rng.h)
+    //
+    rng_stream rng;
+
+    // Where the commentary goes (see commentary_sink). When this
+    // is 0, the match is played without any commentary (and the
+    // final stats aren't printed), which is much faster
+    //
+    commentary_sink* comm;
+
+    // Whether the events of the match are recorded (see
+    // match_context::events)
+    //
+    bool record_events;
+
+    shootout_policy shootout;
+    string shootout_score;
+    int shootout_diff;
+};
+
+
+// The complete state of one match being simulated.
 //
-enum DID_WHAT {DID_SHOT, DID_FOUL, DID_TACKLE, DID_ASSIST};
+// Nothing about a match is kept outside its context, so a process
+// can simulate any number of matches, one after another (reusing
+// a context) or at the same time (each in its own context, possibly
+// on its own thread).
+//
+// The conditionals of the teams keep a pointer to the context they
+// were created in, so a match_context can't be copied.
+//
+class match_context
+{
+public:
+    match_context();
+    ~match_context();
+
+    // Brings the context back to its freshly constructed state,
+    // releasing the conditionals and report events of a previous
+    // match
+    //
+    void reset(void);
+
+    string init_teams_data(const match_inputs& inputs);
+    string ensure_no_duplicate_names(void);
+    string read_conditionals(teamsheet_reader teamsheet[2]);
+    void print_starting_tactics(void);
+    void calc_team_contributions_total(int a);
+    void calc_aggression(int a);
+    void calc_player_lineup_factors(int a, int b);
+    void calc_fatigue_and_contributions(int a);
+    void calc_side_balance(int a);
+    void lineup_changed(int a);
+    void recalculate_teams_data(void);
+    void set_position(int a, int b, string fullpos);
+    void substitute_player(int a, int out, int in, string newpos);
+    void change_tactic(int a, const char* newtct);
+    void change_position(int a, int b, string newpos);
+    void calc_shotprob(int a);
+    void random_injury(int a);
+    void if_shot(int a);
+    int  if_ontarget(int a, int b);
+    int  if_goal(int a, int b);
+    int  is_goal_cancelled(void);
+    void if_foul(int a);
+    void bookings(int a, int b, int card_color);
+    void send_off(int a, int b);
+    void calc_ability(void);
+    int  randomp(int p);
+    unsigned  my_random(int n);
+    void clean_inj_card_indicators(void);
+    void update_players_minute_count(void);
+    void add_team_stats_total(void);
+    int how_much_inj_time(void);
+    void print_final_stats(void);
+    void create_stats_file(string work_dir);
+    void write_events_file(string work_dir, string format);
+    void fill_final_stats(vector<match_player_stats> stats[2]);
+    void write_stats_record(string work_dir, const string& commentary);
+    void update_reports_file(string work_dir);
+    void check_conditionals(int team_num);
+    string minute_str(void);
+    string formal_minute_str(void);
+    const char* comment(rng_stream& line_rng, comm_event event, ...);
+    void add_event(match_event_type type, int a, int player, int other = 0, int value = 0);
+    void record_lineups(void);
+    void fill_match_record(match_record& record);
+
+    int who_got_assist(int team, int assister);
+    int who_did_it(int team, DID_WHAT event);
+    void build_did_it_table(int a, DID_WHAT event);
+    void invalidate_did_it_tables(int a);
+
+    /* Implemented in penalty.cpp
+    */
+    int GoalDiff(void);
+    void RunPenaltyShootout(void);
+    void AssignPenaltyTakers(void);
+    void TakePenalty(int, int);
+
+    struct teams team[2];
+
+    // Num of players in a teamsheet (the amount of subs can
+    // be set in league.dat)
+    //
+    int num_players;
+
+    int home_bonus;
+
+    // The score difference of the team whose conditionals are
+    // being checked (used by SCORE conditionals)
+    //
+    int score_diff;
+
+    commentary_sink* comm;
+
+    // Whether comm wants the play-by-play commentary
+    //
+    bool play_by_play;
+
+    // The commentary line being printed (see comment)
+    //
+    string comm_line;
+
+    vector<report_event*> report_vec;
+
+    // The events of the match, in the order they happened, when
+    // record_events is set. Recording events doesn't change how the
+    // match is played.
+    //
+    bool record_events;
+    vector<match_event> events;
+
+    // This array is used to store the teams' total stats on
+    // various minutes during the game
+    // teamStatsTotal[x][y][z]
+    // x: team (0/1)
+    // y: minute (1-90 in steps of 10)
+    // z: 0 = total tackling, 1 = total passing, 2 = total shooting
+    //
+    double teamStatsTotal[2][10][3];
+    bool team_stats_total_enabled;
+
+    // These indicators are used for INJ, RED and YELLOW conditionals
+    //
+    // each is an array, [0] for team 0, [1] for team 1 and contains
+    // the number of the player that was injured or got a card on that
+    // minute, or -1 if there is no such player
+    //
+    int yellow_carded[2];
+    int red_carded[2];
+    int injured_ind[2];
+
+    /// "Gross" game minute.
+    ///
+    /// From 1 to 45 + extra time in the first half, and from
+    /// 46 to 90 + extra time in the second half. Includes the
+    /// "extra time" added by the referee at the end of each
+    /// half on account of injuries/delays.
+    ///
+    int minute;
+
+    /// "Net" game minute.
+    ///
+    /// From 1 to 45 in the first half, from 46 to 90 in the
+    /// second half - used for game / player statistics.
+    ///
+    int formal_minute;
+
+    // The totals of substitutions, injuries and fouls at the end
+    // of the previous half (see how_much_inj_time)
+    //
+    double inj_time_substitutions;
+    double inj_time_injuries;
+    double inj_time_fouls;
+
+    // Penalty shootout state
+    //
+    // maximum of 11 PK takers is possible for each team
+    struct playerstruct PenaltyTaker[2][11];
+    int PenaltyTakerNum[2][11]; /* the numbers of the PK takers in their teams */
+    int KickTakers[2]; /* num of penalty kick takers available for each team */
+    int PenScore[2];   /* penalties scored by teams 0 and 1 */
+
+    // The random stream of this match, and streams split from it
+    // for choosing the play-by-play commentary lines and the lines
+    // of the final stats. The commentary has its own streams so a
+    // match plays the same with or without commentary, and the stats
+    // are the same with or without the play-by-play.
+    //
+    rng_stream rng;
+    rng_stream comm_rng;
+    rng_stream stats_rng;
+
+private:
+    match_context(const match_context& rhs);
+    match_context& operator= (const match_context& rhs);
+};
+
 
-int who_did_it(int team, DID_WHAT event);
+// Reads the teamsheets and the rosters of a match into inputs.
+// The teamsheet names are given with their full path, the rosters
+// are looked for in work_dir.
+//
+// Returns "" on success, and an error message if something went wrong.
+//
+string read_match_inputs(match_inputs& inputs, string work_dir,
+                         string home_teamsheetname, string away_teamsheetname);
 
-/* Functions implemented in penalty.cpp
-*/
-int GoalDiff(void);
-void RunPenaltyShootout(void);
-void AssignPenaltyTakers(void);
-void TakePenalty(int, int);
+// Simulates a match, from the kickoff to the final stats (and the
+// penalty shootout, if there is one).
+//
+// ctx is reset first, so a context can be reused for many matches.
+// When this returns, ctx holds the final state of the match (the
+// score, player stats, report events, etc.)
+//
+// Returns "" on success, and an error message if the inputs are
+// illegal (an injured player in the teamsheet, bad conditionals, etc.)
+//
+string simulate_match(match_context& ctx, const match_inputs& inputs);
 
 
 #endif /* GAME_H */
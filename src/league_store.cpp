@@ -0,0 +1,886 @@
+// ESMS - Electronic Soccer Management Simulator
+// Copyright (C) <1998-2005>  Eli Bendersky
+//
+// This program is free software, licensed with the GPL (www.fsf.org)
+//
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <sys/stat.h>
+
+#ifdef WIN32
+#include <fcntl.h>
+#include <io.h>
+#include <process.h>
+#include <sys/locking.h>
+#else
+#include <fcntl.h>
+#include <sys/file.h>
+#include <unistd.h>
+#endif
+
+#include "league_store.h"
+#include "binary_file.h"
+#include "util.h"
+
+
+// The format of league.db (all the numbers are little-endian):
+//
+// The header: "ESMSLDB" and a version byte (LEAGUE_STORE_VERSION),
+// a u32 generation and a reserved u32 zero. The generation changes
+// each time the store is compacted, so a process that has the store
+// open knows it has to scan it again.
+//
+// Then the records, one after the other:
+//
+// u32     the size of the body
+// u32     the FNV-1a hash of the body
+// body:
+//   u8    the kind of the record (record_kind)
+//   u8    a reserved zero
+//   u16   the size of the key
+//   chars the key - a team, or the name of a text
+//   ...   the data - a roster in binary form (see
+//         encode_roster_players), or text
+//
+// A record that's cut short, or whose hash is wrong, ends the file -
+// it was being written when the writer died, and is dropped (and cut
+// off by the next append, which is sure of it: the writers hold an
+// exclusive lock, so no record is being written then).
+//
+static const char LEAGUE_STORE_MAGIC[] = "ESMSLDB";
+static const unsigned char LEAGUE_STORE_VERSION = 1;
+static const size_t LEAGUE_STORE_HEADER_SIZE = 16;
+static const size_t RECORD_HEADER_SIZE = 8;
+static const size_t RECORD_BODY_HEADER_SIZE = 4;
+
+// The store is compacted by itself once the records that don't count
+// are more than this, and more than the records that do
+//
+static const size_t AUTO_COMPACT_DEAD_BYTES = 1 << 20;
+
+
+enum record_kind
+{
+    REC_ROSTER = 1,
+    REC_TEXT,
+    REC_TEXT_APPEND,
+    REC_ROSTER_REMOVED,
+    REC_TEXT_REMOVED
+};
+
+
+static unsigned load_u16(const unsigned char* p)
+{
+    return p[0] | (p[1] << 8);
+}
+
+
+static string store_header(unsigned generation)
+{
+    string out(LEAGUE_STORE_MAGIC);
+    put_u8(out, LEAGUE_STORE_VERSION);
+    put_u32(out, generation);
+    put_u32(out, 0);
+
+    return out;
+}
+
+
+// Cuts the file to size (to drop a record that was cut short)
+//
+static bool truncate_file(string filename, size_t size)
+{
+#ifdef WIN32
+    FILE* file = fopen(filename.c_str(), "r+b");
+
+    if (!file)
+        return false;
+
+    bool ok = _chsize(_fileno(file), (long) size) == 0;
+    fclose(file);
+    return ok;
+#else
+    return truncate(filename.c_str(), (off_t) size) == 0;
+#endif
+}
+
+
+// Writes data to a temporary file next to filename, and renames it
+// to filename
+//
+static string replace_file(string filename, const string& data)
+{
+    string temp_name = format_str("%s.%d", filename.c_str(), (int) getpid());
+
+    FILE* file = fopen(temp_name.c_str(), "wb");
+
+    if (!file)
+        return format_str("Failed to open %s: %s", temp_name.c_str(), strerror(errno));
+
+    bool ok = fwrite(data.data(), 1, data.size(), file) == data.size();
+    ok = fclose(file) == 0 && ok;
+
+#ifdef WIN32
+    // (rename doesn't replace an existing file on Windows)
+    //
+    if (ok)
+        remove(filename.c_str());
+#endif
+
+    if (!ok || rename(temp_name.c_str(), filename.c_str()) != 0)
+    {
+        remove(temp_name.c_str());
+        return format_str("Failed to write %s", filename.c_str());
+    }
+
+    return "";
+}
+
+
+league_store::league_store()
+    : generation(0), scanned_size(0), live_bytes(0), players_indexed(false),
+      lock_fd(-1), lock_depth(0), lock_exclusive(false)
+{
+}
+
+
+// Holds a lock of a store for a scope (msg is the error of the lock,
+// "" if it's held)
+//
+class store_lock
+{
+public:
+    store_lock(league_store& store_, bool exclusive)
+        : store(store_)
+    {
+        msg = store.lock(exclusive);
+    }
+
+    ~store_lock()
+    {
+        if (msg == "")
+            store.unlock();
+    }
+
+    string msg;
+
+private:
+    store_lock(const store_lock& rhs);
+    store_lock& operator= (const store_lock& rhs);
+
+    league_store& store;
+};
+
+
+string league_store::lock(bool exclusive)
+{
+    if (lock_depth > 0 && (lock_exclusive || !exclusive))
+    {
+        lock_depth++;
+        return "";
+    }
+
+    string lock_name = filename + ".lock";
+
+    if (lock_depth == 0)
+    {
+#ifdef WIN32
+        lock_fd = _open(lock_name.c_str(), _O_RDWR | _O_CREAT, _S_IREAD | _S_IWRITE);
+#else
+        lock_fd = ::open(lock_name.c_str(), O_RDWR | O_CREAT, 0666);
+#endif
+
+        if (lock_fd < 0)
+            return format_str("Failed to open %s: %s", lock_name.c_str(), strerror(errno));
+    }
+
+#ifdef WIN32
+    // (there are no shared locks here, so every lock is exclusive -
+    // and _locking gives up after 10 seconds)
+    //
+    _lseek(lock_fd, 0, SEEK_SET);
+    int rc = _locking(lock_fd, _LK_LOCK, 1);
+    exclusive = true;
+#else
+    // (a shared lock that's made exclusive is let go of first, so the
+    // store is refreshed again after it)
+    //
+    int rc;
+
+    do
+        rc = flock(lock_fd, exclusive ? LOCK_EX : LOCK_SH);
+    while (rc != 0 && errno == EINTR);
+#endif
+
+    if (rc != 0)
+    {
+        string msg = format_str("Failed to lock %s: %s", lock_name.c_str(), strerror(errno));
+
+        if (lock_depth == 0)
+        {
+            close(lock_fd);
+            lock_fd = -1;
+        }
+
+        return msg;
+    }
+
+    lock_exclusive = exclusive;
+    lock_depth++;
+    return "";
+}
+
+
+void league_store::unlock(void)
+{
+    if (lock_depth == 0 || --lock_depth > 0)
+        return;
+
+#ifdef WIN32
+    _lseek(lock_fd, 0, SEEK_SET);
+    _locking(lock_fd, _LK_UNLCK, 1);
+#endif
+
+    // (closing the file lets go of the lock)
+    //
+    close(lock_fd);
+    lock_fd = -1;
+    lock_exclusive = false;
+}
+
+
+string league_store::create(string filename)
+{
+    return replace_file(filename, store_header(0));
+}
+
+
+string league_store::open(string filename_)
+{
+    filename = filename_;
+    scanned_size = 0;
+
+    store_lock lock(*this, false);
+
+    if (lock.msg != "")
+        return lock.msg;
+
+    return refresh();
+}
+
+
+// Brings the index up to date with the file: scans what other
+// processes appended to it since it was last scanned, or all of it
+// if it was compacted since. The store must be locked.
+//
+string league_store::refresh(void)
+{
+    struct stat st;
+
+    if (stat(filename.c_str(), &st) != 0)
+        return format_str("Failed to open league store %s", filename.c_str());
+
+    size_t size = st.st_size;
+
+    // The header is read even when the size is the one scanned: the
+    // store could have been compacted and appended to since, to the
+    // same size by chance, and only its generation tells
+    //
+    FILE* file = fopen(filename.c_str(), "rb");
+
+    if (!file)
+        return format_str("Failed to open league store %s", filename.c_str());
+
+    unsigned char header[LEAGUE_STORE_HEADER_SIZE];
+    bool header_ok = fread(header, 1, sizeof(header), file) == sizeof(header);
+    fclose(file);
+
+    if (!header_ok || memcmp(header, LEAGUE_STORE_MAGIC, strlen(LEAGUE_STORE_MAGIC)) != 0)
+        return format_str("%s isn't a league store", filename.c_str());
+
+    if (header[7] != LEAGUE_STORE_VERSION)
+        return format_str("League store %s is of version %d (must be %d)", filename.c_str(),
+                          header[7], LEAGUE_STORE_VERSION);
+
+    unsigned file_generation = load_u32(header + 8);
+
+    if (scanned_size != 0 && file_generation == generation && size == scanned_size)
+        return "";
+
+    if (scanned_size == 0 || file_generation != generation || size < scanned_size)
+    {
+        generation = file_generation;
+        rosters.clear();
+        text_chunks.clear();
+        player_index.clear();
+        players_indexed = false;
+        live_bytes = LEAGUE_STORE_HEADER_SIZE;
+
+        return scan(LEAGUE_STORE_HEADER_SIZE);
+    }
+
+    return scan(scanned_size);
+}
+
+
+string league_store::scan(size_t from)
+{
+    mapped_file file;
+
+    if (!file.map_file(filename))
+        return format_str("Failed to open league store %s", filename.c_str());
+
+    size_t pos = from;
+
+    while (pos + RECORD_HEADER_SIZE + RECORD_BODY_HEADER_SIZE <= file.size)
+    {
+        const unsigned char* rec = file.data + pos;
+        size_t body_size = load_u32(rec);
+
+        if (body_size < RECORD_BODY_HEADER_SIZE || body_size > file.size - pos - RECORD_HEADER_SIZE)
+            break;
+
+        const unsigned char* body = rec + RECORD_HEADER_SIZE;
+
+        if (fnv1a_hash(body, body_size) != load_u32(rec + 4))
+            break;
+
+        size_t key_size = load_u16(body + 2);
+
+        if (key_size > body_size - RECORD_BODY_HEADER_SIZE)
+            break;
+
+        string key((const char*) body + RECORD_BODY_HEADER_SIZE, key_size);
+        size_t data_offset = pos + RECORD_HEADER_SIZE + RECORD_BODY_HEADER_SIZE + key_size;
+
+        apply_record(body[0], key, data_offset, body_size - RECORD_BODY_HEADER_SIZE - key_size);
+
+        pos += RECORD_HEADER_SIZE + body_size;
+    }
+
+    scanned_size = pos;
+    return "";
+}
+
+
+// Updates the index with a record (the size of the record is the
+// size of its data plus the headers and the key)
+//
+void league_store::apply_record(int kind, const string& key, size_t offset, size_t size)
+{
+    size_t overhead = RECORD_HEADER_SIZE + RECORD_BODY_HEADER_SIZE + key.size();
+
+    map<string, vector<chunk> >* entries = 0;
+
+    if (kind == REC_ROSTER || kind == REC_ROSTER_REMOVED)
+        entries = &rosters;
+    else if (kind == REC_TEXT || kind == REC_TEXT_APPEND || kind == REC_TEXT_REMOVED)
+        entries = &text_chunks;
+    else
+        return;
+
+    map<string, vector<chunk> >::iterator found = entries->find(key);
+
+    if (found != entries->end() && kind != REC_TEXT_APPEND)
+    {
+        for (vector<chunk>::const_iterator c = found->second.begin(); c != found->second.end(); ++c)
+            live_bytes -= c->size + overhead;
+
+        entries->erase(found);
+    }
+
+    // The player index is remade the next time it's needed (except
+    // for the rosters written by this process - see write_roster)
+    //
+    if (entries == &rosters)
+        players_indexed = false;
+
+    if (kind == REC_ROSTER_REMOVED || kind == REC_TEXT_REMOVED)
+        return;
+
+    chunk c = {offset, size};
+    (*entries)[key].push_back(c);
+    live_bytes += size + overhead;
+}
+
+
+string league_store::append_record(int kind, const string& key, const string& data)
+{
+    store_lock lock(*this, true);
+
+    if (lock.msg != "")
+        return lock.msg;
+
+    string msg = refresh();
+
+    if (msg != "")
+        return msg;
+
+    // A record cut short at the end is cut off first, so the new one
+    // isn't lost after it. The file was just scanned to its end with
+    // the lock held, so what's after the records that were scanned is
+    // such a record, and not one another process is appending.
+    //
+    struct stat st;
+
+    if (stat(filename.c_str(), &st) == 0 && (size_t) st.st_size > scanned_size)
+        if (!truncate_file(filename, scanned_size))
+            return format_str("Failed to repair league store %s", filename.c_str());
+
+    string body;
+    put_u8(body, kind);
+    put_u8(body, 0);
+    put_u16(body, key.size());
+    body += key;
+    body += data;
+
+    string record;
+    put_u32(record, body.size());
+    put_u32(record, fnv1a_hash((const unsigned char*) body.data(), body.size()));
+    record += body;
+
+    FILE* file = fopen(filename.c_str(), "ab");
+
+    if (!file)
+        return format_str("Failed to open league store %s: %s", filename.c_str(), strerror(errno));
+
+    bool ok = fwrite(record.data(), 1, record.size(), file) == record.size();
+    ok = fclose(file) == 0 && ok;
+
+    if (!ok)
+        return format_str("Failed to write league store %s", filename.c_str());
+
+    apply_record(kind, key, scanned_size + RECORD_HEADER_SIZE + RECORD_BODY_HEADER_SIZE + key.size(),
+                 data.size());
+    scanned_size += record.size();
+
+    if (scanned_size - live_bytes > AUTO_COMPACT_DEAD_BYTES && scanned_size - live_bytes > live_bytes)
+        return compact();
+
+    return "";
+}
+
+
+string league_store::read_chunks(const vector<chunk>& chunks, string& data)
+{
+    FILE* file = fopen(filename.c_str(), "rb");
+
+    if (!file)
+        return format_str("Failed to open league store %s", filename.c_str());
+
+    for (vector<chunk>::const_iterator c = chunks.begin(); c != chunks.end(); ++c)
+    {
+        size_t first = data.size();
+        data.resize(first + c->size);
+
+        if (c->size > 0 && (fseek(file, (long) c->offset, SEEK_SET) != 0
+                            || fread(&data[first], 1, c->size, file) != c->size))
+        {
+            fclose(file);
+            return format_str("Failed to read league store %s", filename.c_str());
+        }
+    }
+
+    fclose(file);
+    return "";
+}
+
+
+vector<string> league_store::teams(void)
+{
+    store_lock lock(*this, false);
+    refresh();
+
+    vector<string> names;
+
+    for (map<string, vector<chunk> >::const_iterator i = rosters.begin(); i != rosters.end(); ++i)
+        names.push_back(i->first);
+
+    return names;
+}
+
+
+bool league_store::has_roster(string team)
+{
+    store_lock lock(*this, false);
+    refresh();
+    return rosters.find(team) != rosters.end();
+}
+
+
+string league_store::read_roster(string team, RosterPlayerArray& players_arr)
+{
+    store_lock lock(*this, false);
+
+    if (lock.msg != "")
+        return lock.msg;
+
+    string msg = refresh();
+
+    if (msg != "")
+        return msg;
+
+    map<string, vector<chunk> >::const_iterator found = rosters.find(team);
+
+    if (found == rosters.end())
+        return format_str("No roster of %s in league store %s", team.c_str(), filename.c_str());
+
+    string data;
+    msg = read_chunks(found->second, data);
+
+    if (msg != "")
+        return msg;
+
+    if (!decode_roster_players((const unsigned char*) data.data(), data.size(), players_arr))
+        return format_str("The roster of %s in league store %s is broken", team.c_str(), filename.c_str());
+
+    return "";
+}
+
+
+string league_store::write_roster(string team, const RosterPlayerArray& players_arr)
+{
+    store_lock lock(*this, true);
+
+    if (lock.msg != "")
+        return lock.msg;
+
+    RosterPlayerArray old_players;
+    bool was_indexed = players_indexed;
+
+    if (was_indexed && has_roster(team))
+        read_roster(team, old_players);
+
+    string msg = append_record(REC_ROSTER, team, encode_roster_players(players_arr.begin(), players_arr.end()));
+
+    if (msg != "")
+        return msg;
+
+    // The index is kept up to date instead of being remade (unless the
+    // store was compacted, or another process wrote it)
+    //
+    if (was_indexed && !players_indexed)
+    {
+        players_indexed = true;
+        index_roster(team, old_players, false);
+        index_roster(team, players_arr, true);
+    }
+
+    return "";
+}
+
+
+string league_store::remove_roster(string team)
+{
+    store_lock lock(*this, true);
+
+    if (lock.msg != "")
+        return lock.msg;
+
+    if (!has_roster(team))
+        return "";
+
+    return append_record(REC_ROSTER_REMOVED, team, "");
+}
+
+
+void league_store::index_roster(string team, const RosterPlayerArray& players_arr, bool add)
+{
+    for (RosterPlayerConstIterator player = players_arr.begin(); player != players_arr.end(); ++player)
+    {
+        vector<string>& player_teams = player_index[player->name];
+        vector<string>::iterator pos = lower_bound(player_teams.begin(), player_teams.end(), team);
+        bool found = pos != player_teams.end() && *pos == team;
+
+        if (add && !found)
+            player_teams.insert(pos, team);
+        else if (!add && found)
+            player_teams.erase(pos);
+
+        if (player_teams.empty())
+            player_index.erase(player->name);
+    }
+}
+
+
+vector<string> league_store::player_teams(string name)
+{
+    store_lock lock(*this, false);
+    refresh();
+
+    if (!players_indexed)
+    {
+        player_index.clear();
+
+        for (map<string, vector<chunk> >::const_iterator i = rosters.begin(); i != rosters.end(); ++i)
+        {
+            RosterPlayerArray players;
+
+            if (read_roster(i->first, players) == "")
+                index_roster(i->first, players, true);
+        }
+
+        players_indexed = true;
+    }
+
+    map<string, vector<string> >::const_iterator found = player_index.find(name);
+
+    return found == player_index.end() ? vector<string>() : found->second;
+}
+
+
+vector<string> league_store::texts(void)
+{
+    store_lock lock(*this, false);
+    refresh();
+
+    vector<string> names;
+
+    for (map<string, vector<chunk> >::const_iterator i = text_chunks.begin(); i != text_chunks.end(); ++i)
+        names.push_back(i->first);
+
+    return names;
+}
+
+
+bool league_store::has_text(string name)
+{
+    store_lock lock(*this, false);
+    refresh();
+    return text_chunks.find(name) != text_chunks.end();
+}
+
+
+string league_store::read_text(string name, string& text)
+{
+    store_lock lock(*this, false);
+
+    if (lock.msg != "")
+        return lock.msg;
+
+    string msg = refresh();
+
+    if (msg != "")
+        return msg;
+
+    map<string, vector<chunk> >::const_iterator found = text_chunks.find(name);
+
+    if (found == text_chunks.end())
+        return format_str("No %s in league store %s", name.c_str(), filename.c_str());
+
+    text.clear();
+    return read_chunks(found->second, text);
+}
+
+
+string league_store::write_text(string name, const string& text)
+{
+    return append_record(REC_TEXT, name, text);
+}
+
+
+// The text is added as a piece of its own, so appending to a long
+// text (like reports.txt) costs only the size of the appended part
+//
+string league_store::append_text(string name, const string& text)
+{
+    store_lock lock(*this, true);
+
+    if (lock.msg != "")
+        return lock.msg;
+
+    return append_record(has_text(name) ? REC_TEXT_APPEND : REC_TEXT, name, text);
+}
+
+
+string league_store::remove_text(string name)
+{
+    store_lock lock(*this, true);
+
+    if (lock.msg != "")
+        return lock.msg;
+
+    if (!has_text(name))
+        return "";
+
+    return append_record(REC_TEXT_REMOVED, name, "");
+}
+
+
+// The lock is held until the new file is in place, so nothing is
+// appended to the old one after it was read
+//
+string league_store::compact(void)
+{
+    store_lock lock(*this, true);
+
+    if (lock.msg != "")
+        return lock.msg;
+
+    string msg = refresh();
+
+    if (msg != "")
+        return msg;
+
+    string out = store_header(generation + 1);
+
+    for (int pass = 0; pass < 2; ++pass)
+    {
+        const map<string, vector<chunk> >& entries = pass == 0 ? rosters : text_chunks;
+
+        for (map<string, vector<chunk> >::const_iterator i = entries.begin(); i != entries.end(); ++i)
+        {
+            string body;
+            put_u8(body, pass == 0 ? REC_ROSTER : REC_TEXT);
+            put_u8(body, 0);
+            put_u16(body, i->first.size());
+            body += i->first;
+
+            msg = read_chunks(i->second, body);
+
+            if (msg != "")
+                return msg;
+
+            put_u32(out, body.size());
+            put_u32(out, fnv1a_hash((const unsigned char*) body.data(), body.size()));
+            out += body;
+        }
+    }
+
+    msg = replace_file(filename, out);
+
+    if (msg != "")
+        return msg;
+
+    // The index is made again from the new file
+    //
+    scanned_size = 0;
+    return refresh();
+}
+
+
+size_t league_store::file_size(void)
+{
+    store_lock lock(*this, false);
+    refresh();
+    return scanned_size;
+}
+
+
+size_t league_store::live_size(void)
+{
+    store_lock lock(*this, false);
+    refresh();
+    return live_bytes;
+}
+
+
+league_store* league_store_of(string dir)
+{
+    static map<string, league_store*> stores;
+
+    map<string, league_store*>::const_iterator found = stores.find(dir);
+
+    if (found != stores.end())
+        return found->second;
+
+    string filename = dir + LEAGUE_STORE_FILENAME;
+    struct stat st;
+
+    if (stat(filename.c_str(), &st) != 0)
+        return 0;
+
+    league_store* store = new league_store;
+    string msg = store->open(filename);
+
+    if (msg != "")
+        die("%s", msg.c_str());
+
+    stores[dir] = store;
+    return store;
+}
+
+
+string league_file_dir(string filename)
+{
+    str_index sep = filename.find_last_of("/\\");
+
+    return sep == string::npos ? "" : filename.substr(0, sep + 1);
+}
+
+
+string league_file_name(string filename)
+{
+    return filename.substr(league_file_dir(filename).size());
+}
+
+
+string league_file_key(string filename)
+{
+    string name = league_file_name(filename);
+
+    return name.substr(0, name.find_last_of("."));
+}
+
+
+bool read_league_file(string filename, string& text)
+{
+    league_store* store = league_store_of(league_file_dir(filename));
+
+    if (store)
+        return store->has_text(league_file_name(filename))
+               && store->read_text(league_file_name(filename), text) == "";
+
+    ifstream file(filename.c_str());
+
+    if (!file)
+        return false;
+
+    ostringstream contents;
+    contents << file.rdbuf();
+    text = contents.str();
+
+    return true;
+}
+
+
+string write_league_file(string filename, const string& text)
+{
+    league_store* store = league_store_of(league_file_dir(filename));
+
+    if (store)
+        return store->write_text(league_file_name(filename), text);
+
+    FILE* file = fopen(filename.c_str(), "w");
+
+    if (!file)
+        return format_str("Failed to open %s: %s", filename.c_str(), strerror(errno));
+
+    bool ok = fwrite(text.data(), 1, text.size(), file) == text.size();
+    ok = fclose(file) == 0 && ok;
+
+    return ok ? "" : format_str("Failed to write %s", filename.c_str());
+}
+
+
+string append_league_file(string filename, const string& text)
+{
+    league_store* store = league_store_of(league_file_dir(filename));
+
+    if (store)
+        return store->append_text(league_file_name(filename), text);
+
+    FILE* file = fopen(filename.c_str(), "a");
+
+    if (!file)
+        return format_str("Failed to open %s: %s", filename.c_str(), strerror(errno));
+
+    bool ok = fwrite(text.data(), 1, text.size(), file) == text.size();
+    ok = fclose(file) == 0 && ok;
+
+    return ok ? "" : format_str("Failed to write %s", filename.c_str());
+}
@@ -0,0 +1,178 @@
+// ESMS - Electronic Soccer Management Simulator
+// Copyright (C) <1998-2005>  Eli Bendersky
+//
+// This program is free software, licensed with the GPL (www.fsf.org)
+//
+#ifndef LEAGUE_STORE_H
+#define LEAGUE_STORE_H
+
+
+#include <cstddef>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "rosterplayer.h"
+
+
+using namespace std;
+
+
+// The league store - an optional single file (league.db, in the
+// directory of the league) that holds the rosters of the teams and
+// the league files (table.txt and reports.txt), instead of a text
+// file for each.
+//
+// When a league directory has a league.db, read_roster_players and
+// write_roster_players, and the league file functions below, go to
+// the store instead of the text files, so the tools work on it
+// without knowing it's there. lgstore imports a league from its text
+// files into a store, and exports it back.
+//
+// The file is a log of records, each appended to its end: a roster,
+// a text, a piece of text appended to a text, or the removal of
+// one. The latest record of a roster or a text is the one that
+// counts, so writing never rewrites the file. The records a store
+// doesn't need anymore are dropped by compact() (which runs by
+// itself when they're most of the file).
+//
+// Several processes can use a store at the same time (like esms_round
+// and esms appending to reports.txt): each change of the file, and
+// compact(), holds an exclusive lock of it, and each read a shared
+// one (see lock). A store isn't thread-safe, though - the tools use a
+// store from one thread (updtr, which reads and writes the rosters
+// on its worker threads, doesn't when there's a store).
+//
+class league_store
+{
+public:
+    league_store();
+
+    // Opens the store in filename. Returns "" on success, and an
+    // error message if something went wrong.
+    //
+    string open(string filename);
+
+    // Creates a new empty store in filename (replacing the file, if
+    // there's one). Returns "" on success, and an error message if
+    // something went wrong.
+    //
+    static string create(string filename);
+
+    // The teams with rosters in the store, sorted
+    //
+    vector<string> teams(void);
+
+    bool has_roster(string team);
+
+    // Like read_roster_players and write_roster_players
+    //
+    string read_roster(string team, RosterPlayerArray& players_arr);
+    string write_roster(string team, const RosterPlayerArray& players_arr);
+    string remove_roster(string team);
+
+    // The player index - the teams (sorted) that have a player with
+    // this name
+    //
+    vector<string> player_teams(string name);
+
+    // The texts in the store, by name (like reports.txt), sorted
+    //
+    vector<string> texts(void);
+
+    bool has_text(string name);
+    string read_text(string name, string& text);
+    string write_text(string name, const string& text);
+    string append_text(string name, const string& text);
+    string remove_text(string name);
+
+    // Rewrites the file with just the records that count. Returns ""
+    // on success, and an error message if something went wrong.
+    //
+    string compact(void);
+
+    // The size of the file, and how much of it is records that count
+    //
+    size_t file_size(void);
+    size_t live_size(void);
+
+private:
+    // Where the data of a record is in the file
+    //
+    struct chunk
+    {
+        size_t offset;
+        size_t size;
+    };
+
+    string refresh(void);
+    string scan(size_t from);
+    string append_record(int kind, const string& key, const string& data);
+    string read_chunks(const vector<chunk>& chunks, string& data);
+    void apply_record(int kind, const string& key, size_t offset, size_t size);
+
+    string filename;
+    unsigned generation;
+
+    // How much of the file has been scanned, and how many bytes of
+    // it are records that count
+    //
+    size_t scanned_size;
+    size_t live_bytes;
+
+    map<string, vector<chunk> > rosters;
+    map<string, vector<chunk> > text_chunks;
+
+    // The player index: built the first time it's needed, and then
+    // kept up to date by write_roster and remove_roster
+    //
+    bool players_indexed;
+    map<string, vector<string> > player_index;
+
+    void index_roster(string team, const RosterPlayerArray& players_arr, bool add);
+
+    // Locks the store (exclusive to change it, shared to read it) on
+    // <store>.lock, which stays the same file when compact() replaces
+    // the store. The lock is held until unlock is called as many
+    // times as lock; store_lock does it for a scope. lock returns ""
+    // on success, and an error message if something went wrong.
+    //
+    string lock(bool exclusive);
+    void unlock(void);
+
+    friend class store_lock;
+
+    int lock_fd;
+    unsigned lock_depth;
+    bool lock_exclusive;
+};
+
+
+// The league store of the league in dir (dir is "" or ends with a
+// separator, like the work_dir of the tools), or 0 if there isn't
+// one (no league.db in dir). A broken store is fatal.
+//
+league_store* league_store_of(string dir);
+
+const char LEAGUE_STORE_FILENAME[] = "league.db";
+
+// The directory of a league file (like work/uva.txt -> work/), its
+// name in the directory (uva.txt), and that name without the
+// extension (uva)
+//
+string league_file_dir(string filename);
+string league_file_name(string filename);
+string league_file_key(string filename);
+
+// Read, write and append to a league file (like table.txt) - in the
+// league store of its directory if there's one, and on disk if not.
+// read_league_file returns false if there's no such file; the others
+// return "" on success, and an error message if something went
+// wrong.
+//
+bool read_league_file(string filename, string& text);
+string write_league_file(string filename, const string& text);
+string append_league_file(string filename, const string& text);
+
+
+#endif // LEAGUE_STORE_H
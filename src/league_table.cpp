@@ -3,20 +3,21 @@
 //
 // This program is free software, licensed with the GPL (www.fsf.org)
 // 
+#include <cctype>
+#include <cstdlib>
+#include <set>
+#include <sstream>
+
 #include "league_table.h"
+#include "league_store.h"
 
 
+// The teams by points - the teams with the same points are placed by
+// the tie breaks
+//
 bool team_data_predicate(league_table::team_data data1, league_table::team_data data2)
 {
-    if (data1.points != data2.points)
-        return data1.points > data2.points;
-    else
-    {
-        if (data1.goal_difference != data2.goal_difference)
-            return data1.goal_difference > data2.goal_difference;
-        else
-            return data1.goals_for > data2.goals_for;
-    }
+    return data1.points > data2.points;
 }
 
 
@@ -26,135 +27,383 @@ bool league_table::team_exists(string name)
 }
 
 
-void league_table::read_league_table_file(string filename)
+void league_table::parse_league_table(const string& table_text, string filename)
 {
-    ifstream table_in(filename.c_str());
+    istringstream table_in(table_text);
+    string line;
 
-    // The file doesn't have to exist (if it doesn't, a new table is
-    // created). But if it exists, it must be in correct format
+    // skip header
     //
-    if (table_in)
-    {
-        string line;
-
-        // skip header
-        //
-        getline(table_in, line);
-        getline(table_in, line);
+    getline(table_in, line);
+    getline(table_in, line);
 
-        while (getline(table_in, line))
-        {
-            if (is_only_whitespace(line))
-                continue;
+    while (getline(table_in, line))
+    {
+        if (is_only_whitespace(line))
+            continue;
 
-            vector<string> tokens = tokenize(line);
+        vector<string> tokens = tokenize(line);
 
-            // The structure of a line must be:
-            //
-            // PLACE TEAMNAME+ PL W D L GF GA GD PTS
-            //
-            // TEAMNAME may be multiple tokens, so we count from the
-            // end ! The first token is PLACE, the last 8 tokens are
-            // as specified, and everything between the first and
-            // the last 8 is the team name.
-            //
-            // Note: when the team name is restructured from the
-            // tokens, each token is separated by one space
-            //
-            unsigned num_tokens = tokens.size();
+        // The structure of a line must be:
+        //
+        // PLACE TEAMNAME+ PL W D L GF GA GD PTS
+        //
+        // TEAMNAME may be multiple tokens, so we count from the
+        // end ! The first token is PLACE, the last 8 tokens are
+        // as specified, and everything between the first and
+        // the last 8 is the team name.
+        //
+        // Note: when the team name is restructured from the
+        // tokens, each token is separated by one space
+        //
+        unsigned num_tokens = tokens.size();
 
-            if (num_tokens < 10)
-                die("The following line in %s has too few tokens:\n%s", filename.c_str(), line.c_str());
+        if (num_tokens < 10)
+            die("The following line in %s has too few tokens:\n%s", filename.c_str(), line.c_str());
 
-            int points = str_atoi(tokens[num_tokens - 1]);
-            int goal_difference = str_atoi(tokens[num_tokens - 2]);
-            int goals_against = str_atoi(tokens[num_tokens - 3]);
-            int goals_for = str_atoi(tokens[num_tokens - 4]);
-            int lost = str_atoi(tokens[num_tokens - 5]);
-            int drawn = str_atoi(tokens[num_tokens - 6]);
-            int won = str_atoi(tokens[num_tokens - 7]);
-            int played = str_atoi(tokens[num_tokens - 8]);
+        int points = str_atoi(tokens[num_tokens - 1]);
+        int goal_difference = str_atoi(tokens[num_tokens - 2]);
+        int goals_against = str_atoi(tokens[num_tokens - 3]);
+        int goals_for = str_atoi(tokens[num_tokens - 4]);
+        int lost = str_atoi(tokens[num_tokens - 5]);
+        int drawn = str_atoi(tokens[num_tokens - 6]);
+        int won = str_atoi(tokens[num_tokens - 7]);
+        int played = str_atoi(tokens[num_tokens - 8]);
 
-            string name = tokens[1];
+        string name = tokens[1];
 
-            for (unsigned i = 2; i <= num_tokens - 9; ++i)
-                name += " " + tokens[i];
+        for (unsigned i = 2; i <= num_tokens - 9; ++i)
+            name += " " + tokens[i];
 
-            add_new_team(name, played, won, drawn, lost, goals_for, goals_against,
-                         goal_difference, points);
-        }
+        add_new_team(name, played, won, drawn, lost, goals_for, goals_against,
+                     goal_difference, points);
     }
 }
 
 
 void league_table::read_results_file(string filename)
 {
-    ifstream results_in(filename.c_str());
+    string results_text;
 
-    if (!results_in)
+    if (!read_league_file(filename, results_text))
         die("Unable to open results file %s", filename.c_str());
 
+    add_results(results_text);
+}
+
+
+// Parses a line of a results file. Returns false if it isn't a result
+//
+static bool parse_result_line(const string& line, string& name_1, int& score_1,
+                              int& score_2, string& name_2)
+{
+    if (is_only_whitespace(line))
+        return false;
+
+    vector<string> tokens = tokenize(line);
+
+    // A reports file consists not only of results,
+    // but also from scorers, injured players, etc.
+    // The results must be extracted and taken into account. The
+    // rest must be ignored. The results lines look as follows:
+    //
+    // TEAMNAME1+ SCORE - SCORE TEAMNAME2+
+    //
+    // Where both TEAMNAMEs can be several tokens long.
+    //
+    // Note: incorrectly formed results lines will be ignored.
+    // The reports file is machine-generated, so this should not
+    // be a problem in real situations.
+    //
+
+    if (tokens.size() < 5)
+        return false;
+
+    unsigned dash_index = 0;
+
+    for (vector<string>::const_iterator i = tokens.begin() + 1; i != tokens.end() - 1; ++i)
+    {
+        string score_1 = *(i - 1);
+        string dash = *i;
+        string score_2 = *(i + 1);
+
+        if (is_number(score_1) && dash == "-" && is_number(score_2))
+            dash_index = i - tokens.begin();
+        else
+            continue;
+    }
+
+    if (dash_index == 0)
+        return false;
+
+    // If we're here, dash_index is the token number of the dash in a correctly
+    // formed result line.
+    //
+    score_1 = str_atoi(tokens[dash_index - 1]);
+    score_2 = str_atoi(tokens[dash_index + 1]);
+
+    name_1 = tokens[0];
+
+    for (unsigned i = 1; i <= dash_index - 2; ++i)
+        name_1 += " " + tokens[i];
+
+    name_2 = tokens[dash_index + 2];
+
+    for (unsigned i = dash_index + 3; i < tokens.size(); ++i)
+        name_2 += " " + tokens[i];
+
+    return true;
+}
+
+
+void league_table::add_results(const string& results_text, size_t from)
+{
+    istringstream results_in(results_text.substr(from));
+
     string line;
 
     while (getline(results_in, line))
     {
-        if (is_only_whitespace(line))
+        string name_1, name_2;
+        int score_1, score_2;
+
+        if (!parse_result_line(line, name_1, score_1, score_2, name_2))
             continue;
 
-        vector<string> tokens = tokenize(line);
+        add_game_result(name_1, score_1, score_2, name_2);
+    }
+}
 
-        // A reports file consists not only of results,
-        // but also from scorers, injured players, etc.
-        // The results must be extracted and taken into account. The
-        // rest must be ignored. The results lines look as follows:
-        //
-        // TEAMNAME1+ SCORE - SCORE TEAMNAME2+
-        //
-        // Where both TEAMNAMEs can be several tokens long.
-        //
-        // Note: incorrectly formed results lines will be ignored.
-        // The reports file is machine-generated, so this should not
-        // be a problem in real situations.
-        //
 
-        if (tokens.size() < 5)
-            continue;
+void league_table::add_game_result(string name_1, int score_1, int score_2, string name_2)
+{
+    add_team_result(name_1, score_1, score_2);
+    add_team_result(name_2, score_2, score_1);
+
+    unsigned id_1 = team_ids.intern(name_1);
+    unsigned id_2 = team_ids.intern(name_2);
+
+    head_to_head& games_1 = games_between(id_1, id_2);
+    head_to_head& games_2 = games_between(id_2, id_1);
+
+    if (score_1 > score_2)
+    {
+        games_1.won++;
+        games_2.lost++;
+    }
+    else if (score_1 < score_2)
+    {
+        games_1.lost++;
+        games_2.won++;
+    }
+    else
+    {
+        games_1.drawn++;
+        games_2.drawn++;
+    }
+
+    games_1.goals_for += score_1;
+    games_1.goals_against += score_2;
+    games_2.goals_for += score_2;
+    games_2.goals_against += score_1;
+}
+
+
+league_table::head_to_head& league_table::games_between(unsigned id_1, unsigned id_2)
+{
+    unsigned needed = max(id_1, id_2) + 1;
+
+    if (needed > matrix_size)
+    {
+        unsigned new_size = max(needed, matrix_size * 2);
+        vector<head_to_head> new_matrix(new_size * new_size);
+
+        for (unsigned i = 0; i < matrix_size; ++i)
+            for (unsigned j = 0; j < matrix_size; ++j)
+                new_matrix[i * new_size + j] = matrix[i * matrix_size + j];
 
-        unsigned dash_index = 0;
+        matrix.swap(new_matrix);
+        matrix_size = new_size;
+    }
+
+    return matrix[id_1 * matrix_size + id_2];
+}
+
+
+string league_table::dump_head_to_head(void)
+{
+    string ret;
 
-        for (vector<string>::const_iterator i = tokens.begin() + 1; i != tokens.end() - 1; ++i)
+    // A line for each two teams, with the games of the first against
+    // the second:
+    //
+    // TEAM1 <tab> TEAM2 <tab> W <tab> D <tab> L <tab> GF <tab> GA
+    //
+    for (unsigned i = 0; i < team_ids.size(); ++i)
+    {
+        for (unsigned j = i + 1; j < team_ids.size(); ++j)
         {
-            string score_1 = *(i - 1);
-            string dash = *i;
-            string score_2 = *(i + 1);
+            const head_to_head& games = games_between(i, j);
 
-            if (is_number(score_1) && dash == "-" && is_number(score_2))
-                dash_index = i - tokens.begin();
-            else
+            if (games.won + games.drawn + games.lost == 0)
                 continue;
+
+            ret += format_str("%s\t%s\t%d\t%d\t%d\t%d\t%d\n",
+                              team_ids.name(i).c_str(), team_ids.name(j).c_str(),
+                              games.won, games.drawn, games.lost,
+                              games.goals_for, games.goals_against);
         }
+    }
+
+    return ret;
+}
+
+
+void league_table::parse_head_to_head(const string& text)
+{
+    istringstream text_in(text);
+    string line;
 
-        if (dash_index == 0)
+    while (getline(text_in, line))
+    {
+        vector<string> tokens = tokenize(line, "\t");
+
+        if (tokens.size() != 7)
             continue;
 
-        // If we're here, dash_index is the token number of the dash in a correctly
-        // formed result line.
-        //
-        int score_1 = str_atoi(tokens[dash_index - 1]);
-        int score_2 = str_atoi(tokens[dash_index + 1]);
+        unsigned id_1 = team_ids.intern(tokens[0]);
+        unsigned id_2 = team_ids.intern(tokens[1]);
+
+        head_to_head& games_1 = games_between(id_1, id_2);
+        head_to_head& games_2 = games_between(id_2, id_1);
+
+        games_1.won += str_atoi(tokens[2]);
+        games_1.drawn += str_atoi(tokens[3]);
+        games_1.lost += str_atoi(tokens[4]);
+        games_1.goals_for += str_atoi(tokens[5]);
+        games_1.goals_against += str_atoi(tokens[6]);
 
-        string name_1 = tokens[0];
+        games_2.won += str_atoi(tokens[4]);
+        games_2.drawn += str_atoi(tokens[3]);
+        games_2.lost += str_atoi(tokens[2]);
+        games_2.goals_for += str_atoi(tokens[6]);
+        games_2.goals_against += str_atoi(tokens[5]);
+    }
+}
 
-        for (unsigned i = 1; i <= dash_index - 2; ++i)
-            name_1 += " " + tokens[i];
 
-        string name_2 = tokens[dash_index + 2];
+string league_table::set_tie_breaks(string rules)
+{
+    vector<string> names = tokenize(rules, ", \t");
+    vector<tie_break> new_tie_breaks;
 
-        for (unsigned i = dash_index + 3; i < tokens.size(); ++i)
-            name_2 += " " + tokens[i];
+    if (names.empty())
+        names = tokenize("GD,GF", ",");
 
-        add_team_result(name_1, score_1, score_2);
-        add_team_result(name_2, score_2, score_1);
+    for (vector<string>::const_iterator name = names.begin(); name != names.end(); ++name)
+    {
+        string rule = *name;
+        transform(rule.begin(), rule.end(), rule.begin(), ::toupper);
+
+        if (rule == "GD")
+            new_tie_breaks.push_back(GD);
+        else if (rule == "GF")
+            new_tie_breaks.push_back(GF);
+        else if (rule == "W")
+            new_tie_breaks.push_back(WINS);
+        else if (rule == "H2H_PTS")
+            new_tie_breaks.push_back(H2H_PTS);
+        else if (rule == "H2H_GD")
+            new_tie_breaks.push_back(H2H_GD);
+        else if (rule == "H2H_GF")
+            new_tie_breaks.push_back(H2H_GF);
+        else
+            return format_str("Unknown tie break %s", name->c_str());
+    }
+
+    tie_breaks = new_tie_breaks;
+    return "";
+}
+
+
+// For place_tied_teams: the value of a team by a tie break, and its
+// place among the tied teams
+//
+static bool tie_break_value_predicate(const pair<int, unsigned>& value1, const pair<int, unsigned>& value2)
+{
+    return value1.first > value2.first;
+}
+
+
+void league_table::place_tied_teams(vector<team_data>::iterator first, vector<team_data>::iterator last,
+                                    unsigned tie_break_num)
+{
+    if (last - first < 2 || tie_break_num == tie_breaks.size())
+        return;
+
+    tie_break rule = tie_breaks[tie_break_num];
+
+    // The ids of the tied teams, for the head-to-head tie breaks
+    //
+    vector<unsigned> ids;
+
+    for (vector<team_data>::iterator team = first; team != last; ++team)
+        ids.push_back(team_ids.find(team->name));
+
+    vector<pair<int, unsigned> > values;
+
+    for (unsigned i = 0; i < ids.size(); ++i)
+    {
+        const team_data& team = first[i];
+        int value = 0;
+
+        if (rule == GD)
+            value = team.goal_difference;
+        else if (rule == GF)
+            value = team.goals_for;
+        else if (rule == WINS)
+            value = team.won;
+        else if (ids[i] != name_index::NO_NAME)
+        {
+            // The mini-table of the games between the tied teams
+            //
+            for (unsigned j = 0; j < ids.size(); ++j)
+            {
+                if (j == i || ids[j] == name_index::NO_NAME)
+                    continue;
+
+                const head_to_head& games = games_between(ids[i], ids[j]);
+
+                if (rule == H2H_PTS)
+                    value += games.won * 3 + games.drawn;
+                else if (rule == H2H_GD)
+                    value += games.goals_for - games.goals_against;
+                else
+                    value += games.goals_for;
+            }
+        }
+
+        values.push_back(make_pair(value, i));
+    }
+
+    stable_sort(values.begin(), values.end(), tie_break_value_predicate);
+
+    vector<team_data> tied(first, last);
+
+    for (unsigned i = 0; i < values.size(); ++i)
+        first[i] = tied[values[i].second];
+
+    // The teams that are still tied go on to the next tie break
+    //
+    unsigned group_start = 0;
+
+    for (unsigned i = 1; i <= values.size(); ++i)
+    {
+        if (i == values.size() || values[i].first != values[group_start].first)
+        {
+            place_tied_teams(first + group_start, first + i, tie_break_num + 1);
+            group_start = i;
+        }
     }
 }
 
@@ -210,9 +459,8 @@ void league_table::add_team_result(string name, int scored, int conceded)
 }
 
 
-string league_table::dump_league_table(void)
+vector<league_table::team_data> league_table::placed_teams(void)
 {
-    string ret;
     vector<team_data> sorted_teams;
 
     for (map<string, team_data>::const_iterator i = teams.begin();
@@ -221,7 +469,50 @@ string league_table::dump_league_table(void)
         sorted_teams.push_back(i->second);
     }
 
-    sort(sorted_teams.begin(), sorted_teams.end(), team_data_predicate);
+    stable_sort(sorted_teams.begin(), sorted_teams.end(), team_data_predicate);
+
+    vector<team_data>::iterator group_start = sorted_teams.begin();
+
+    for (vector<team_data>::iterator i = sorted_teams.begin(); i != sorted_teams.end(); ++i)
+    {
+        if (i + 1 == sorted_teams.end() || (i + 1)->points != group_start->points)
+        {
+            place_tied_teams(group_start, i + 1, 0);
+            group_start = i + 1;
+        }
+    }
+
+    return sorted_teams;
+}
+
+
+vector<pair<string, int> > league_table::standings(void)
+{
+    vector<team_data> sorted_teams = placed_teams();
+    vector<pair<string, int> > ret;
+
+    for (vector<team_data>::const_iterator i = sorted_teams.begin(); i != sorted_teams.end(); ++i)
+        ret.push_back(make_pair(i->name, i->points));
+
+    return ret;
+}
+
+
+unsigned league_table::num_games(void)
+{
+    unsigned played = 0;
+
+    for (map<string, team_data>::const_iterator i = teams.begin(); i != teams.end(); ++i)
+        played += i->second.played;
+
+    return played / 2;
+}
+
+
+string league_table::dump_league_table(void)
+{
+    string ret;
+    vector<team_data> sorted_teams = placed_teams();
 
     // print header
     //
@@ -250,3 +541,377 @@ string league_table::dump_league_table(void)
 
     return ret;
 }
+
+
+// FNV-1a, of size bytes of text
+//
+static unsigned text_hash(const string& text, size_t size)
+{
+    unsigned hash = 2166136261u;
+
+    for (size_t i = 0; i < size; ++i)
+    {
+        hash ^= (unsigned char) text[i];
+        hash *= 16777619u;
+    }
+
+    return hash & 0xffffffffu;
+}
+
+
+// The checkpoint of a table file. It's a text league file, with a
+// line for each of:
+//
+// results_file <the name of the results file>
+// results_size <how many bytes of it were added to the table>
+// results_hash <the hash of these bytes>
+// table_hash   <the hash of the table they made>
+//
+// and then sections, each a line with its name and then its text:
+//
+// games              the games that were added from the results
+//                    file, a line for each: the hash of its report
+//                    and its teams (see results_game)
+// head_to_head       the head-to-head results of the table
+// base_head_to_head  those from before the results file
+// base_table         the table from before the results file
+//
+struct results_checkpoint
+{
+    results_checkpoint()
+        : results_size(0), results_hash(0), table_hash(0), has_games(false)
+    {}
+
+    string results_file;
+    size_t results_size;
+    unsigned results_hash;
+    unsigned table_hash;
+    bool has_games;
+    string games;
+    string head_to_head;
+    string base_head_to_head;
+    string base_table;
+};
+
+
+static string checkpoint_filename(string table_filename)
+{
+    return table_filename + ".checkpoint";
+}
+
+
+// A game of a results file: its teams, and the hash of its report
+// (the result line and the lines after it, up to the next result,
+// without the empty ones)
+//
+struct results_game
+{
+    string teams;
+    unsigned hash;
+};
+
+
+static vector<results_game> games_of(const string& results_text)
+{
+    istringstream results_in(results_text);
+    vector<results_game> games;
+    string report;
+    string line;
+
+    while (getline(results_in, line))
+    {
+        string name_1, name_2;
+        int score_1, score_2;
+
+        if (parse_result_line(line, name_1, score_1, score_2, name_2))
+        {
+            if (!games.empty())
+                games.back().hash = text_hash(report, report.size());
+
+            results_game game;
+            game.teams = name_1 + " - " + name_2;
+            games.push_back(game);
+            report = "";
+        }
+
+        if (!is_only_whitespace(line))
+            report += line + "\n";
+    }
+
+    if (!games.empty())
+        games.back().hash = text_hash(report, report.size());
+
+    return games;
+}
+
+
+static string dump_games(const vector<results_game>& games)
+{
+    string ret;
+
+    for (vector<results_game>::const_iterator i = games.begin(); i != games.end(); ++i)
+        ret += format_str("%u %s\n", i->hash, i->teams.c_str());
+
+    return ret;
+}
+
+
+static vector<results_game> parse_games(const string& text)
+{
+    istringstream games_in(text);
+    vector<results_game> games;
+    string line;
+
+    while (getline(games_in, line))
+    {
+        str_index space = line.find(' ');
+
+        if (space == string::npos)
+            continue;
+
+        results_game game;
+        game.hash = strtoul(line.substr(0, space).c_str(), 0, 10);
+        game.teams = line.substr(space + 1);
+        games.push_back(game);
+    }
+
+    return games;
+}
+
+
+// How a results file changed since some of its games were added to a
+// table (when what was added isn't just its start, which has more
+// results after it)
+//
+enum results_change
+{
+    // The results that were added were edited: most of their games
+    // are still there as they were, or the games are the same ones,
+    // in the same order, and some of them are still as they were
+    //
+    RESULTS_EDITED,
+
+    // It's a new results file (of a new round): none of the games
+    // that were added is there as it was, and the games aren't the
+    // same ones
+    //
+    RESULTS_NEW,
+
+    // Anything else - like the same games, all with other reports
+    // (a new round of a league of two teams, or all the results
+    // edited), which can't be told apart
+    //
+    RESULTS_UNKNOWN
+};
+
+
+static results_change compare_games(const vector<results_game>& added,
+                                    const vector<results_game>& games)
+{
+    if (added.empty())
+        return RESULTS_NEW;
+
+    multiset<unsigned> added_hashes;
+    bool same_teams = added.size() == games.size();
+
+    for (unsigned i = 0; i < added.size(); ++i)
+    {
+        added_hashes.insert(added[i].hash);
+
+        if (same_teams && added[i].teams != games[i].teams)
+            same_teams = false;
+    }
+
+    unsigned kept = 0;
+
+    for (vector<results_game>::const_iterator i = games.begin(); i != games.end(); ++i)
+    {
+        multiset<unsigned>::iterator found = added_hashes.find(i->hash);
+
+        if (found != added_hashes.end())
+        {
+            added_hashes.erase(found);
+            kept++;
+        }
+    }
+
+    if (kept > 0 && (same_teams || 2 * kept > added.size()))
+        return RESULTS_EDITED;
+    else if (kept == 0 && !same_teams)
+        return RESULTS_NEW;
+    else
+        return RESULTS_UNKNOWN;
+}
+
+
+// Returns false if there's no checkpoint, or if it isn't complete
+//
+static bool read_results_checkpoint(string table_filename, results_checkpoint& checkpoint)
+{
+    string text;
+
+    if (!read_league_file(checkpoint_filename(table_filename), text))
+        return false;
+
+    istringstream checkpoint_in(text);
+    string line;
+    unsigned fields = 0;
+    string* section = 0;
+
+    while (getline(checkpoint_in, line))
+    {
+        if (line == "games")
+        {
+            section = &checkpoint.games;
+            checkpoint.has_games = true;
+        }
+        else if (line == "head_to_head")
+            section = &checkpoint.head_to_head;
+        else if (line == "base_head_to_head")
+            section = &checkpoint.base_head_to_head;
+        else if (line == "base_table")
+            section = &checkpoint.base_table;
+        else if (section)
+            *section += line + "\n";
+        else
+        {
+            str_index space = line.find(' ');
+            string key = line.substr(0, space);
+            string value = space == string::npos ? "" : line.substr(space + 1);
+
+            if (key == "results_file")
+                checkpoint.results_file = value;
+            else if (key == "results_size")
+                checkpoint.results_size = strtoul(value.c_str(), 0, 10);
+            else if (key == "results_hash")
+                checkpoint.results_hash = strtoul(value.c_str(), 0, 10);
+            else if (key == "table_hash")
+                checkpoint.table_hash = strtoul(value.c_str(), 0, 10);
+            else
+                continue;
+
+            fields++;
+        }
+    }
+
+    return fields == 4 && checkpoint.has_games;
+}
+
+
+void league_table::read_league_table_file(string filename)
+{
+    string table_text;
+
+    // The file doesn't have to exist (if it doesn't, a new table is
+    // created). But if it exists, it must be in correct format
+    //
+    if (!read_league_file(filename, table_text))
+        return;
+
+    parse_league_table(table_text, filename);
+
+    results_checkpoint checkpoint;
+
+    if (read_results_checkpoint(filename, checkpoint)
+        && checkpoint.table_hash == text_hash(table_text, table_text.size()))
+        parse_head_to_head(checkpoint.head_to_head);
+}
+
+
+string update_league_table_file(string table_filename, string results_filename, string tie_breaks,
+                                string& table_text)
+{
+    string old_table_text;
+    string results_text;
+    league_table table;
+
+    string msg = table.set_tie_breaks(tie_breaks);
+
+    if (msg != "")
+        return msg;
+
+    bool has_table = read_league_file(table_filename, old_table_text);
+
+    if (!read_league_file(results_filename, results_text))
+        die("Unable to open results file %s", results_filename.c_str());
+
+    // The table (and head-to-head results) the results are added to,
+    // and where the results that weren't added yet start. Without a
+    // checkpoint of this table, it's the whole results file.
+    //
+    string table_start = old_table_text;
+    string head_to_head_start;
+    size_t from = 0;
+
+    string base_table = table_start;
+    string base_head_to_head;
+
+    vector<results_game> games = games_of(results_text);
+    results_checkpoint checkpoint;
+
+    if (has_table && read_results_checkpoint(table_filename, checkpoint)
+        && checkpoint.table_hash == text_hash(old_table_text, old_table_text.size()))
+    {
+        head_to_head_start = checkpoint.head_to_head;
+        base_head_to_head = head_to_head_start;
+
+        if (checkpoint.results_file == league_file_name(results_filename))
+        {
+            if (checkpoint.results_size <= results_text.size()
+                && checkpoint.results_hash == text_hash(results_text, checkpoint.results_size))
+            {
+                // More results were added to the results file
+                //
+                from = checkpoint.results_size;
+                base_table = checkpoint.base_table;
+                base_head_to_head = checkpoint.base_head_to_head;
+            }
+            else
+            {
+                results_change change = compare_games(parse_games(checkpoint.games), games);
+
+                if (change == RESULTS_EDITED)
+                {
+                    // Results that were added to the table were edited, so
+                    // the table is made again
+                    //
+                    table_start = base_table = checkpoint.base_table;
+                    head_to_head_start = base_head_to_head = checkpoint.base_head_to_head;
+                }
+                else if (change == RESULTS_UNKNOWN)
+                {
+                    return format_str("Can't tell whether %s has the results of a new round, or "
+                                      "edits of the results already in %s. To add all of it to "
+                                      "the table, remove %s",
+                                      results_filename.c_str(), table_filename.c_str(),
+                                      checkpoint_filename(table_filename).c_str());
+                }
+            }
+        }
+    }
+
+    table.parse_league_table(table_start, table_filename);
+    table.parse_head_to_head(head_to_head_start);
+    table.add_results(results_text, from);
+    table_text = table.dump_league_table();
+
+    string new_table_text = table_text + "\n";
+    msg = write_league_file(table_filename, new_table_text);
+
+    if (msg != "")
+        return msg;
+
+    return write_league_file(checkpoint_filename(table_filename),
+                             format_str("results_file %s\n"
+                                        "results_size %lu\n"
+                                        "results_hash %u\n"
+                                        "table_hash %u\n",
+                                        league_file_name(results_filename).c_str(),
+                                        (unsigned long) results_text.size(),
+                                        text_hash(results_text, results_text.size()),
+                                        text_hash(new_table_text, new_table_text.size()))
+                             + "games\n" + dump_games(games)
+                             + "head_to_head\n" + table.dump_head_to_head()
+                             + "base_head_to_head\n" + base_head_to_head
+                             + "base_table\n" + base_table);
+}
@@ -13,6 +13,7 @@
 #include <fstream>
 #include <functional>
 #include "util.h"
+#include "name_index.h"
 
 using namespace std;
 
@@ -21,7 +22,11 @@ class league_table
 {
 public:
     league_table()
-    {}
+        : matrix_size(0)
+    {
+        tie_breaks.push_back(GD);
+        tie_breaks.push_back(GF);
+    }
 
     bool team_exists(string name);
 
@@ -39,7 +44,23 @@ public:
     //
     void add_team_result(string name, int scored = 0, int conceded = 0);
 
-    // Reads a league table file and fills in the teams data
+    // adds the result of a game - for both teams, and to their
+    // head-to-head results
+    //
+    void add_game_result(string name_1, int score_1, int score_2, string name_2);
+
+    // Sets the rules that place teams with the same points, in the
+    // order they're applied: a comma separated list of GD, GF, W
+    // (goal difference, goals for and wins in all the games), and
+    // H2H_PTS, H2H_GD, H2H_GF (the same in the games between the
+    // teams that are still tied). The default is GD,GF. Returns "" on
+    // success, and an error message if a rule is unknown.
+    //
+    string set_tie_breaks(string rules);
+
+    // Reads a league table file and fills in the teams data, and the
+    // head-to-head results from its checkpoint, if it has one (see
+    // update_league_table_file)
     //
     void read_league_table_file(string filename);
 
@@ -47,10 +68,33 @@ public:
     //
     void read_results_file(string filename);
 
+    // Adds the results in results_text, from the offset from on
+    //
+    void add_results(const string& results_text, size_t from = 0);
+
+    // Fills in the teams data from the text of a league table file
+    // (filename is for the errors)
+    //
+    void parse_league_table(const string& table_text, string filename);
+
+    // The head-to-head results as text (a line for each two teams that
+    // played each other), to be kept between runs, and back
+    //
+    string dump_head_to_head(void);
+    void parse_head_to_head(const string& text);
+
     // returns the (properly sorted and formatted) league table as a string
     //
     string dump_league_table(void);
 
+    // The teams in the order of the table, with their points
+    //
+    vector<pair<string, int> > standings(void);
+
+    // The number of games in the table
+    //
+    unsigned num_games(void);
+
 private:
     struct team_data
     {
@@ -78,8 +122,68 @@ private:
 
     friend bool team_data_predicate(team_data data1, team_data data2);
 
+    // The teams, placed
+    //
+    vector<team_data> placed_teams(void);
+
     map<string, team_data> teams;
+
+    // The games of a team against another
+    //
+    struct head_to_head
+    {
+        head_to_head()
+            : won(0), drawn(0), lost(0), goals_for(0), goals_against(0)
+        {}
+
+        int won;
+        int drawn;
+        int lost;
+        int goals_for;
+        int goals_against;
+    };
+
+    // The head-to-head results matrix: the games of team_ids i against
+    // team_ids j are in matrix[i * matrix_size + j]
+    //
+    name_index team_ids;
+    vector<head_to_head> matrix;
+    unsigned matrix_size;
+
+    head_to_head& games_between(unsigned id_1, unsigned id_2);
+
+    enum tie_break {GD, GF, WINS, H2H_PTS, H2H_GD, H2H_GF};
+
+    vector<tie_break> tie_breaks;
+
+    // Places the teams in [first, last), which have the same points
+    // and are tied by the tie breaks before tie_break_num
+    //
+    void place_tied_teams(vector<team_data>::iterator first, vector<team_data>::iterator last,
+                          unsigned tie_break_num);
 };
 
 
+// Updates a league table file with the results of a results file,
+// and sets table_text to the new table. tie_breaks are the rules of
+// set_tie_breaks. Returns "" on success, and an error message if
+// something went wrong.
+//
+// Only the results that weren't added to the table yet are added: a
+// checkpoint next to the table (<table file>.checkpoint) keeps how
+// much of the results file was added, with a hash of that part and of
+// the table it made, the head-to-head results of the teams, and a
+// hash of the report of each game that was added. When results that
+// were added are edited (most of these games are still there as they
+// were), the table is made again from the one the checkpoint has from
+// before the results file. A new results file (for a new round, with
+// none of these games as they were), or a table without a checkpoint,
+// gets all of the results file added. A results file that can't be
+// told to be either (like a new round of a league of two teams, with
+// the same game again) is an error.
+//
+string update_league_table_file(string table_filename, string results_filename, string tie_breaks,
+                                string& table_text);
+
+
 #endif // LEAGUE_TABLE_H
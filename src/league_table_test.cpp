@@ -0,0 +1,197 @@
+// ESMS - Electronic Soccer Management Simulator
+// Copyright (C) <1998-2005>  Eli Bendersky
+//
+// This program is free software, licensed with the GPL (www.fsf.org)
+//
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include <unistd.h>
+
+#include "league_table.h"
+#include "league_store.h"
+
+
+// wait on exit ?
+//
+bool waitflag = false;
+
+
+//
+// Tests of update_league_table_file and its checkpoint, and of the
+// league store the league files can be kept in. Run by "make check";
+// exits with 1 if a test fails.
+//
+
+static string test_dir;
+static unsigned num_failed = 0;
+
+
+static void check(bool ok, string what)
+{
+    if (!ok)
+    {
+        cout << "FAILED: " << what << endl;
+        num_failed++;
+    }
+}
+
+
+// Writes reports.txt, and updates table.txt with it. Returns the
+// error of update_league_table_file ("" if there's none)
+//
+static string update_with(string reports)
+{
+    string msg = write_league_file(test_dir + "reports.txt", reports);
+
+    if (msg != "")
+        die("%s", msg.c_str());
+
+    string table_text;
+    return update_league_table_file(test_dir + "table.txt", test_dir + "reports.txt", "GD,GF",
+                                    table_text);
+}
+
+
+// The P, GF and Pts of a team in table.txt, as "P GF Pts"
+//
+static string team_line(string team)
+{
+    league_table table;
+    table.read_league_table_file(test_dir + "table.txt");
+
+    istringstream table_in(table.dump_league_table());
+    string line;
+
+    while (getline(table_in, line))
+    {
+        vector<string> tokens = tokenize(line);
+
+        if (tokens.size() == 10 && tokens[1] == team)
+            return tokens[2] + " " + tokens[6] + " " + tokens[9];
+    }
+
+    return "";
+}
+
+
+static void remove_league_files(void)
+{
+    remove((test_dir + "table.txt").c_str());
+    remove((test_dir + "table.txt.checkpoint").c_str());
+    remove((test_dir + "reports.txt").c_str());
+}
+
+
+// A new round that starts with the game the last one started with is
+// added to the table, and isn't taken for an edit of the last round
+//
+static void test_repeated_fixture(void)
+{
+    remove_league_files();
+
+    check(update_with("A 1 - 0 B\nA_Scorer (A) 10'\n\n\nC 0 - 0 D\n\n\n") == "",
+          "repeated fixture: round 1");
+    check(update_with("A 2 - 2 B\nA_Scorer (A) 20'\nB_Scorer (B) 30'\nA_Scorer (A) 40'\n"
+                      "B_Scorer (B) 50'\n\n\nD 1 - 0 C\nD_Scorer (D) 60'\n\n\n") == "",
+          "repeated fixture: round 2");
+
+    check(team_line("A") == "2 3 4", "repeated fixture: A is " + team_line("A"));
+    check(team_line("B") == "2 2 1", "repeated fixture: B is " + team_line("B"));
+    check(team_line("C") == "2 0 1", "repeated fixture: C is " + team_line("C"));
+    check(team_line("D") == "2 1 4", "repeated fixture: D is " + team_line("D"));
+}
+
+
+// More results in the results file are added, and an edited result
+// makes the table again
+//
+static void test_added_and_edited_results(void)
+{
+    remove_league_files();
+
+    string game_1 = "A 1 - 0 B\nA_Scorer (A) 10'\n\n\n";
+    string game_2 = "C 0 - 0 D\n\n\n";
+    string game_3 = "E 3 - 1 F\nE_Scorer (E) 10'\nE_Scorer (E) 20'\nE_Scorer (E) 30'\n"
+                    "F_Scorer (F) 40'\n\n\n";
+
+    check(update_with(game_1) == "", "added results: round 1");
+    check(update_with(game_1 + game_2 + game_3) == "", "added results: more results");
+    check(team_line("A") == "1 1 3", "added results: A is " + team_line("A"));
+    check(team_line("E") == "1 3 3", "added results: E is " + team_line("E"));
+
+    check(update_with(game_1 + "C 2 - 0 D\nC_Scorer (C) 10'\nC_Scorer (C) 20'\n\n\n" + game_3) == "",
+          "edited results: round 1");
+    check(team_line("A") == "1 1 3", "edited results: A is " + team_line("A"));
+    check(team_line("C") == "1 2 3", "edited results: C is " + team_line("C"));
+    check(team_line("D") == "1 0 0", "edited results: D is " + team_line("D"));
+}
+
+
+// A league of two teams that plays the same game again can't be told
+// from an edit of the last round, so it's an error (and the table
+// isn't changed)
+//
+static void test_same_games(void)
+{
+    remove_league_files();
+
+    check(update_with("A 1 - 0 B\nA_Scorer (A) 10'\n\n\n") == "", "same games: round 1");
+    check(update_with("A 0 - 1 B\nB_Scorer (B) 80'\n\n\n") != "", "same games: round 2");
+    check(team_line("A") == "1 1 3", "same games: A is " + team_line("A"));
+}
+
+
+// A store compacted by another process, and left with the size it had
+// by chance, is scanned again (the records moved)
+//
+static void test_store_compacted_to_same_size(void)
+{
+    string store_name = test_dir + "league.db";
+    league_store reader, writer;
+
+    check(league_store::create(store_name) == "", "compacted store: create");
+    check(reader.open(store_name) == "", "compacted store: open");
+    check(reader.write_text("b", "BBBB") == "" && reader.write_text("a", "AAAA") == "",
+          "compacted store: write");
+
+    // "b" is written again and dropped by the compaction, which sorts
+    // the records, so "a" is now where "b" was
+    //
+    check(writer.open(store_name) == "", "compacted store: open again");
+    check(writer.write_text("b", "CCCC") == "" && writer.compact() == "", "compacted store: compact");
+    check(writer.file_size() == reader.file_size(), "compacted store: the size changed");
+
+    string text;
+    check(reader.read_text("a", text) == "" && text == "AAAA", "compacted store: a is " + text);
+    check(reader.read_text("b", text) == "" && text == "CCCC", "compacted store: b is " + text);
+
+    remove(store_name.c_str());
+    remove((store_name + ".lock").c_str());
+}
+
+
+int main(void)
+{
+    char dir_template[] = "/tmp/league_table_testXXXXXX";
+
+    if (!mkdtemp(dir_template))
+        die("Unable to create a test directory");
+
+    test_dir = string(dir_template) + "/";
+
+    test_repeated_fixture();
+    test_added_and_edited_results();
+    test_same_games();
+    test_store_compacted_to_same_size();
+
+    remove_league_files();
+    rmdir(dir_template);
+
+    if (num_failed > 0)
+        return 1;
+
+    cout << "league_table_test: OK" << endl;
+    return 0;
+}
@@ -0,0 +1,264 @@
+// ESMS - Electronic Soccer Management Simulator
+// Copyright (C) <1998-2005>  Eli Bendersky
+//
+// This program is free software, licensed with the GPL (www.fsf.org)
+//
+#include <algorithm>
+#include <cstdio>
+#include <iostream>
+#include <sys/stat.h>
+
+#include "league_store.h"
+#include "rosterplayer.h"
+#include "anyoption.h"
+#include "util.h"
+
+
+// wait on exit ?
+//
+bool waitflag = true;
+
+
+//
+// lgstore moves a league between its text files and a league store
+// (see league_store.h):
+//
+// --import       puts the rosters of the teams in teams.dir, table.txt
+//                (and its checkpoint) and reports.txt into a new league.db
+// --export       writes them back from league.db to the text files
+// --compact      drops the records league.db doesn't need anymore
+// --list         shows what's in league.db
+// --find_player  shows the teams that have a player
+//
+
+// The league files kept in a store, besides the rosters
+//
+static const char* const league_texts[] = {"table.txt", "table.txt.checkpoint", "reports.txt"};
+static const unsigned num_league_texts = sizeof(league_texts) / sizeof(league_texts[0]);
+
+
+static void import_league(string work_dir)
+{
+    string store_filename = work_dir + LEAGUE_STORE_FILENAME;
+    struct stat st;
+
+    if (stat(store_filename.c_str(), &st) == 0)
+        die("%s already exists", store_filename.c_str());
+
+    ifstream dir_file((work_dir + "teams.dir").c_str());
+
+    if (!dir_file)
+        die("Failed to open file %steams.dir", work_dir.c_str());
+
+    // Everything is read before the store is made, so a league that
+    // can't be read is left as it was
+    //
+    vector<string> teams;
+    vector<RosterPlayerArray> rosters;
+    string line;
+
+    while (getline(dir_file, line))
+    {
+        line.erase(remove(line.begin(), line.end(), ' '), line.end());
+
+        if (is_only_whitespace(line))
+            continue;
+
+        RosterPlayerArray players;
+        string msg = read_roster_file(work_dir + line, players);
+
+        if (msg != "")
+            die("%s", msg.c_str());
+
+        teams.push_back(league_file_key(line));
+        rosters.push_back(players);
+    }
+
+    vector<string> text_names;
+    vector<string> texts;
+
+    for (unsigned i = 0; i < num_league_texts; ++i)
+    {
+        string text;
+
+        if (read_league_file(work_dir + league_texts[i], text))
+        {
+            text_names.push_back(league_texts[i]);
+            texts.push_back(text);
+        }
+    }
+
+    string msg = league_store::create(store_filename);
+
+    if (msg != "")
+        die("%s", msg.c_str());
+
+    league_store store;
+    msg = store.open(store_filename);
+
+    for (unsigned i = 0; msg == "" && i < teams.size(); ++i)
+        msg = store.write_roster(teams[i], rosters[i]);
+
+    for (unsigned i = 0; msg == "" && i < texts.size(); ++i)
+        msg = store.write_text(text_names[i], texts[i]);
+
+    if (msg != "")
+    {
+        remove(store_filename.c_str());
+        die("%s", msg.c_str());
+    }
+
+    cout << "Imported " << teams.size() << " rosters and " << texts.size() << " league files into "
+         << store_filename << endl;
+    cout << "(the text files aren't used while " << store_filename << " is there)" << endl;
+}
+
+
+static void export_league(string work_dir)
+{
+    league_store* store = league_store_of(work_dir);
+
+    if (!store)
+        die("No %s in the league directory", LEAGUE_STORE_FILENAME);
+
+    vector<string> teams = store->teams();
+
+    for (vector<string>::const_iterator team = teams.begin(); team != teams.end(); ++team)
+    {
+        RosterPlayerArray players;
+        string msg = store->read_roster(*team, players);
+
+        if (msg == "")
+            msg = write_roster_file(work_dir + *team + ".txt", players);
+
+        if (msg != "")
+            die("%s", msg.c_str());
+    }
+
+    vector<string> texts = store->texts();
+
+    for (vector<string>::const_iterator name = texts.begin(); name != texts.end(); ++name)
+    {
+        string text;
+        string msg = store->read_text(*name, text);
+
+        if (msg != "")
+            die("%s", msg.c_str());
+
+        string filename = work_dir + *name;
+        FILE* file = fopen(filename.c_str(), "w");
+
+        if (!file)
+            die("Failed to open %s", filename.c_str());
+
+        bool ok = fwrite(text.data(), 1, text.size(), file) == text.size();
+
+        if (fclose(file) != 0 || !ok)
+            die("Failed to write %s", filename.c_str());
+    }
+
+    cout << "Exported " << teams.size() << " rosters and " << texts.size() << " league files from "
+         << work_dir << LEAGUE_STORE_FILENAME << endl;
+    cout << "(remove it to go back to the text files)" << endl;
+}
+
+
+static league_store* existing_store(string work_dir)
+{
+    league_store* store = league_store_of(work_dir);
+
+    if (!store)
+        die("No %s in the league directory", LEAGUE_STORE_FILENAME);
+
+    return store;
+}
+
+
+int main(int argc, char* argv[])
+{
+    // handling/parsing command line arguments
+    //
+    AnyOption* opt = new AnyOption();
+    opt->noPOSIX();
+
+    opt->setOption("work_dir");
+    opt->setFlag("no_wait_on_exit");
+    opt->setFlag("import");
+    opt->setFlag("export");
+    opt->setFlag("compact");
+    opt->setFlag("list");
+    opt->setOption("find_player");
+
+    opt->processCommandArgs(argc, argv);
+
+    if (opt->getFlag("no_wait_on_exit"))
+        waitflag = false;
+
+    string work_dir;
+
+    if (opt->getValue("work_dir"))
+        work_dir = opt->getValue("work_dir");
+    else
+        work_dir = "";
+
+    if (opt->getFlag("import"))
+        import_league(work_dir);
+    else if (opt->getFlag("export"))
+        export_league(work_dir);
+    else if (opt->getFlag("compact"))
+    {
+        league_store* store = existing_store(work_dir);
+        size_t old_size = store->file_size();
+        string msg = store->compact();
+
+        if (msg != "")
+            die("%s", msg.c_str());
+
+        cout << "Compacted " << work_dir << LEAGUE_STORE_FILENAME << " from " << old_size
+             << " to " << store->file_size() << " bytes" << endl;
+    }
+    else if (opt->getFlag("list"))
+    {
+        league_store* store = existing_store(work_dir);
+        vector<string> teams = store->teams();
+
+        for (vector<string>::const_iterator team = teams.begin(); team != teams.end(); ++team)
+        {
+            RosterPlayerArray players;
+            string msg = store->read_roster(*team, players);
+
+            if (msg != "")
+                die("%s", msg.c_str());
+
+            printf("%-20s %3u players\n", team->c_str(), (unsigned) players.size());
+        }
+
+        vector<string> texts = store->texts();
+
+        for (vector<string>::const_iterator name = texts.begin(); name != texts.end(); ++name)
+        {
+            string text;
+            store->read_text(*name, text);
+            printf("%-20s %7u bytes\n", name->c_str(), (unsigned) text.size());
+        }
+
+        printf("\n%u of the %u bytes of the store are in use\n",
+               (unsigned) store->live_size(), (unsigned) store->file_size());
+    }
+    else if (opt->getValue("find_player"))
+    {
+        string name = opt->getValue("find_player");
+        vector<string> teams = existing_store(work_dir)->player_teams(name);
+
+        if (teams.empty())
+            cout << "No player " << name << endl;
+
+        for (vector<string>::const_iterator team = teams.begin(); team != teams.end(); ++team)
+            cout << name << " plays for " << *team << endl;
+    }
+    else
+        die("Usage: lgstore [--work_dir <dir>] --import | --export | --compact | --list | --find_player <name>");
+
+    MY_EXIT(0);
+    return 0;
+}
@@ -5,7 +5,9 @@
 // 
 #include <cstdlib>
 #include "league_table.h"
+#include "league_store.h"
 #include "anyoption.h"
+#include "config.h"
 
 
 // wait on exit ?
@@ -55,24 +57,25 @@ int main(int argc, char* argv[])
     else
         results_file = work_dir + "reports.txt";
 
-    league_table table;
-
     cout << results_file << endl;
 
-    table.read_league_table_file(table_file);
-    table.read_results_file(results_file);
+    // The tie breaks are those of league.dat, if the league has one
+    //
+    string tie_breaks;
 
-    string table_text = table.dump_league_table();
+    if (ifstream((work_dir + "league.dat").c_str()))
+    {
+        the_config().load_config_file(work_dir + "league.dat");
+        tie_breaks = the_config().get_config_value("TABLE_TIE_BREAKS");
+    }
 
-    ofstream tf(table_file.c_str());
+    string table_text;
+    string msg = update_league_table_file(table_file, results_file, tie_breaks, table_text);
 
-    if (tf)
-    {
-        tf << table_text << endl;
+    if (msg == "")
         cout << "Table file " << table_file << " updated" << endl;
-    }
     else
-        die("Something went wrong opening %s for writing !", table_file.c_str());
+        die("Something went wrong updating %s: %s", table_file.c_str(), msg.c_str());
 
     MY_EXIT(0);
     return 0;
@@ -0,0 +1,660 @@
+// ESMS - Electronic Soccer Management Simulator
+// Copyright (C) <1998-2005>  Eli Bendersky
+//
+// This program is free software, licensed with the GPL (www.fsf.org)
+//
+#include "match_events.h"
+#include "binary_file.h"
+#include "util.h"
+
+#include <cerrno>
+#include <cstring>
+
+
+// The binary format (all the numbers are little-endian):
+//
+// "ESMSEVT" and a version byte (MATCH_RECORD_VERSION)
+//
+// For each team:
+//   name (a string - u16 length and the chars)
+//   score (i16)
+//   number of players (u8)
+//   for each player: name, minutes, St/Tk/Ps/Sh ability change and
+//                    fitness (i16 each)
+//
+// Number of events (u32), and the events: type, team, minute, formal
+// minute, player and other (u8 each) and value (i32)
+//
+static const char MATCH_RECORD_MAGIC[] = "ESMSEVT";
+static const unsigned char MATCH_RECORD_VERSION = 1;
+
+
+// The JSON-lines format has a line for the match (teams, score and
+// the names of the players), a line for each event and a line with
+// the final stats of each player. In event lines, other and value
+// get the names given here, and are left out when they're not used
+// (or when other is 0).
+//
+enum value_kind {VALUE_NONE, VALUE_INT, VALUE_CODE, VALUE_OUTCOME};
+
+struct event_type_info
+{
+    const char* name;
+    const char* other_name;
+    const char* value_name;
+    value_kind kind;
+};
+
+static const event_type_info event_types[NUM_MATCH_EVENT_TYPES] =
+{
+    {"lineup",          "status",   "pos",           VALUE_CODE},
+    {"tactic",          0,          "tactic",        VALUE_CODE},
+    {"chance",          "assister", 0,               VALUE_NONE},
+    {"tackle",          "shooter",  0,               VALUE_NONE},
+    {"shot",            0,          0,               VALUE_NONE},
+    {"save",            "shooter",  0,               VALUE_NONE},
+    {"off_target",      0,          0,               VALUE_NONE},
+    {"goal",            "assister", "gk",            VALUE_INT},
+    {"goal_cancelled",  0,          0,               VALUE_NONE},
+    {"foul",            0,          0,               VALUE_NONE},
+    {"yellow_card",     0,          0,               VALUE_NONE},
+    {"red_card",        0,          "second_yellow", VALUE_INT},
+    {"injury",          0,          0,               VALUE_NONE},
+    {"sub",             "out",      "pos",           VALUE_CODE},
+    {"position_change", 0,          "pos",           VALUE_CODE},
+    {"penalty",         "gk",       "outcome",       VALUE_OUTCOME},
+    {"shootout_kick",   "gk",       "outcome",       VALUE_OUTCOME}
+};
+
+static const char* outcome_names[] = {"scored", "saved", "off_target"};
+
+
+int pack_code(const string& code)
+{
+    int value = 0;
+
+    for (unsigned i = 0; i < code.length() && i < 3; ++i)
+        value |= (unsigned char) code[i] << (8 * i);
+
+    return value;
+}
+
+
+string unpack_code(int value)
+{
+    string code;
+
+    for (; value & 0xff; value >>= 8)
+        code += char(value & 0xff);
+
+    return code;
+}
+
+
+const char* match_event_name(int type)
+{
+    if (type < 0 || type >= NUM_MATCH_EVENT_TYPES)
+        return "unknown";
+
+    return event_types[type].name;
+}
+
+
+void derive_final_stats(const match_record& record, vector<match_player_stats> stats[2])
+{
+    for (int t = 0; t <= 1; ++t)
+    {
+        stats[t].assign(record.players[t].size(), match_player_stats());
+
+        for (unsigned i = 0; i < stats[t].size(); ++i)
+        {
+            const match_player& player = record.players[t][i];
+            match_player_stats& s = stats[t][i];
+
+            s.name = player.name;
+            s.minutes = player.minutes;
+            s.saves = s.tackles = s.keypasses = s.assists = s.shots = s.goals = 0;
+            s.yellowcards = s.redcards = s.injured = s.fouls = 0;
+            s.shots_on = s.shots_off = s.conceded = 0;
+            s.st_ab = player.st_ab;
+            s.tk_ab = player.tk_ab;
+            s.ps_ab = player.ps_ab;
+            s.sh_ab = player.sh_ab;
+            s.fitness = player.fitness;
+        }
+    }
+
+    for (vector<match_event>::const_iterator ev = record.events.begin(); ev != record.events.end(); ++ev)
+    {
+        vector<match_player_stats>& own = stats[ev->team];
+        vector<match_player_stats>& opp = stats[!ev->team];
+
+        // A corrupt record may name players that don't exist
+        //
+        if (ev->player >= own.size() || ev->other >= own.size() || ev->other >= opp.size())
+            continue;
+
+        match_player_stats& s = own[ev->player];
+
+        switch (ev->type)
+        {
+        case MEV_LINEUP:
+        case MEV_SUB:
+        case MEV_POSITION_CHANGE:
+            s.pos = unpack_code(ev->value);
+            break;
+        case MEV_CHANCE:
+            if (ev->other)
+                own[ev->other].keypasses++;
+            break;
+        case MEV_TACKLE:
+            s.tackles++;
+            break;
+        case MEV_SHOT:
+            s.shots++;
+            break;
+        case MEV_SAVE:
+            s.saves++;
+            opp[ev->other].shots_on++;
+            break;
+        case MEV_OFF_TARGET:
+            s.shots_off++;
+            break;
+        case MEV_GOAL:
+            s.goals++;
+            s.shots_on++;
+
+            if (ev->other)
+                own[ev->other].assists++;
+
+            if (ev->value > 0 && unsigned(ev->value) < opp.size())
+                opp[ev->value].conceded++;
+            break;
+        case MEV_GOAL_CANCELLED:
+            s.shots_on++;
+            break;
+        case MEV_FOUL:
+            s.fouls++;
+            break;
+        case MEV_YELLOW_CARD:
+            s.yellowcards++;
+            break;
+        case MEV_RED_CARD:
+            // A sent off player's yellow cards are forgotten - the
+            // red card is what counts for the suspension
+            //
+            s.yellowcards = 0;
+            s.redcards++;
+            break;
+        case MEV_INJURY:
+            s.injured = 1;
+            break;
+        case MEV_PENALTY:
+            // (a saved penalty isn't counted in the GK's saves)
+            //
+            if (ev->value == PEN_SCORED)
+            {
+                s.goals++;
+                opp[ev->other].conceded++;
+            }
+            break;
+        default:
+            break;
+        }
+    }
+}
+
+
+//////////////////////////////////////////////////////////
+//
+// The binary format
+//
+//////////////////////////////////////////////////////////
+
+
+bool write_match_record_binary(FILE* file, const match_record& record)
+{
+    // The record is put together in memory and written at once
+    //
+    string out(MATCH_RECORD_MAGIC);
+    put_u8(out, MATCH_RECORD_VERSION);
+
+    for (int t = 0; t <= 1; ++t)
+    {
+        put_string(out, record.team_name[t]);
+        put_u16(out, record.score[t]);
+        put_u8(out, record.players[t].size() - 1);
+
+        for (unsigned i = 1; i < record.players[t].size(); ++i)
+        {
+            const match_player& player = record.players[t][i];
+
+            put_string(out, player.name);
+            put_u16(out, player.minutes);
+            put_u16(out, player.st_ab);
+            put_u16(out, player.tk_ab);
+            put_u16(out, player.ps_ab);
+            put_u16(out, player.sh_ab);
+            put_u16(out, player.fitness);
+        }
+    }
+
+    put_u32(out, record.events.size());
+
+    for (vector<match_event>::const_iterator ev = record.events.begin(); ev != record.events.end(); ++ev)
+    {
+        put_u8(out, ev->type);
+        put_u8(out, ev->team);
+        put_u8(out, ev->minute);
+        put_u8(out, ev->formal_minute);
+        put_u8(out, ev->player);
+        put_u8(out, ev->other);
+        put_u32(out, ev->value);
+    }
+
+    return fwrite(out.data(), 1, out.size(), file) == out.size() && fflush(file) == 0;
+}
+
+
+// Reads the numbers and strings of the binary format from a buffer.
+// Reading past the end sets failed (and returns zeros).
+//
+class record_reader
+{
+public:
+    record_reader(const string& data_)
+        : data(data_), pos(0), failed(false)
+    {}
+
+    unsigned u8(void)
+    {
+        if (pos + 1 > data.size())
+        {
+            failed = true;
+            return 0;
+        }
+
+        return (unsigned char) data[pos++];
+    }
+
+    unsigned u16(void)
+    {
+        unsigned lo = u8();
+        return lo | (u8() << 8);
+    }
+
+    int i16(void)
+    {
+        return (short) u16();
+    }
+
+    unsigned u32(void)
+    {
+        unsigned lo = u16();
+        return lo | (u16() << 16);
+    }
+
+    string str(void)
+    {
+        unsigned len = u16();
+
+        if (pos + len > data.size())
+        {
+            failed = true;
+            return "";
+        }
+
+        pos += len;
+        return data.substr(pos - len, len);
+    }
+
+    const string& data;
+    size_t pos;
+    bool failed;
+};
+
+
+string read_match_record_binary(string filename, match_record& record)
+{
+    FILE* file = fopen(filename.c_str(), "rb");
+
+    if (!file)
+        return format_str("Can't open %s: %s", filename.c_str(), strerror(errno));
+
+    string data;
+    char buf[16384];
+    size_t n;
+
+    while ((n = fread(buf, 1, sizeof(buf), file)) > 0)
+        data.append(buf, n);
+
+    fclose(file);
+
+    record_reader in(data);
+
+    if (data.compare(0, strlen(MATCH_RECORD_MAGIC), MATCH_RECORD_MAGIC) != 0)
+        return format_str("%s is not a match record", filename.c_str());
+
+    in.pos = strlen(MATCH_RECORD_MAGIC);
+
+    unsigned version = in.u8();
+
+    if (version != MATCH_RECORD_VERSION)
+        return format_str("%s: unsupported match record version %u", filename.c_str(), version);
+
+    for (int t = 0; t <= 1; ++t)
+    {
+        record.team_name[t] = in.str();
+        record.score[t] = in.i16();
+
+        unsigned num_players = in.u8();
+        record.players[t].assign(num_players + 1, match_player());
+
+        for (unsigned i = 1; i <= num_players; ++i)
+        {
+            match_player& player = record.players[t][i];
+
+            player.name = in.str();
+            player.minutes = in.i16();
+            player.st_ab = in.i16();
+            player.tk_ab = in.i16();
+            player.ps_ab = in.i16();
+            player.sh_ab = in.i16();
+            player.fitness = in.i16();
+        }
+    }
+
+    unsigned num_events = in.u32();
+
+    if (in.failed || num_events > data.size())
+        return format_str("%s: truncated match record", filename.c_str());
+
+    record.events.resize(num_events);
+
+    for (unsigned i = 0; i < num_events; ++i)
+    {
+        match_event& ev = record.events[i];
+
+        ev.type = in.u8();
+        ev.team = in.u8();
+        ev.minute = in.u8();
+        ev.formal_minute = in.u8();
+        ev.player = in.u8();
+        ev.other = in.u8();
+        ev.value = (int) in.u32();
+
+        if (ev.type >= NUM_MATCH_EVENT_TYPES || ev.team > 1)
+            return format_str("%s: illegal event %u", filename.c_str(), i);
+    }
+
+    if (in.failed)
+        return format_str("%s: truncated match record", filename.c_str());
+
+    return "";
+}
+
+
+//////////////////////////////////////////////////////////
+//
+// The JSON-lines format
+//
+//////////////////////////////////////////////////////////
+
+
+static string json_string(const string& str)
+{
+    string out = "\"";
+
+    for (unsigned i = 0; i < str.length(); ++i)
+    {
+        unsigned char c = str[i];
+
+        if (c == '"' || c == '\\')
+        {
+            out += '\\';
+            out += c;
+        }
+        else if (c < 0x20)
+            out += format_str("\\u%04x", c);
+        else
+            out += c;
+    }
+
+    return out + "\"";
+}
+
+
+bool write_match_record_json(FILE* file, const match_record& record)
+{
+    string out = "{\"type\":\"match\"";
+
+    out += ",\"home\":" + json_string(record.team_name[0]);
+    out += ",\"away\":" + json_string(record.team_name[1]);
+    out += format_str(",\"score\":[%d,%d],\"players\":[", record.score[0], record.score[1]);
+
+    for (int t = 0; t <= 1; ++t)
+    {
+        out += t ? ",[" : "[";
+
+        for (unsigned i = 1; i < record.players[t].size(); ++i)
+            out += (i > 1 ? "," : "") + json_string(record.players[t][i].name);
+
+        out += "]";
+    }
+
+    out += "]}\n";
+
+    for (vector<match_event>::const_iterator ev = record.events.begin(); ev != record.events.end(); ++ev)
+    {
+        const event_type_info& info = event_types[ev->type];
+
+        out += format_str("{\"type\":\"%s\",\"minute\":%d,\"formal_minute\":%d,\"team\":%d",
+                          info.name, ev->minute, ev->formal_minute, ev->team);
+
+        if (ev->player)
+            out += format_str(",\"player\":%d", ev->player);
+
+        if (info.other_name && ev->other)
+            out += format_str(",\"%s\":%d", info.other_name, ev->other);
+
+        switch (info.kind)
+        {
+        case VALUE_INT:
+            out += format_str(",\"%s\":%d", info.value_name, ev->value);
+            break;
+        case VALUE_CODE:
+            out += format_str(",\"%s\":", info.value_name) + json_string(unpack_code(ev->value));
+            break;
+        case VALUE_OUTCOME:
+            if (ev->value >= PEN_SCORED && ev->value <= PEN_OFF_TARGET)
+                out += format_str(",\"%s\":\"%s\"", info.value_name, outcome_names[ev->value]);
+            break;
+        case VALUE_NONE:
+            break;
+        }
+
+        out += "}\n";
+    }
+
+    vector<match_player_stats> stats[2];
+    derive_final_stats(record, stats);
+
+    for (int t = 0; t <= 1; ++t)
+    {
+        for (unsigned i = 1; i < stats[t].size(); ++i)
+        {
+            const match_player_stats& s = stats[t][i];
+
+            out += format_str("{\"type\":\"player_stats\",\"team\":%d,\"player\":%u,\"name\":", t, i);
+            out += json_string(s.name) + ",\"pos\":" + json_string(s.pos);
+            out += format_str(",\"minutes\":%d,\"saves\":%d,\"tackles\":%d,\"keypasses\":%d,"
+                              "\"assists\":%d,\"shots\":%d,\"goals\":%d,\"yellow\":%d,\"red\":%d,"
+                              "\"injured\":%d,\"fouls\":%d,\"shots_on\":%d,\"shots_off\":%d,"
+                              "\"conceded\":%d,\"st_ab\":%d,\"tk_ab\":%d,\"ps_ab\":%d,\"sh_ab\":%d,"
+                              "\"fitness\":%d}\n",
+                              s.minutes, s.saves, s.tackles, s.keypasses, s.assists, s.shots,
+                              s.goals, s.yellowcards, s.redcards, s.injured, s.fouls, s.shots_on,
+                              s.shots_off, s.conceded, s.st_ab, s.tk_ab, s.ps_ab, s.sh_ab, s.fitness);
+        }
+    }
+
+    return fwrite(out.data(), 1, out.size(), file) == out.size() && fflush(file) == 0;
+}
+
+
+//////////////////////////////////////////////////////////
+//
+// The binary stats format
+//
+//////////////////////////////////////////////////////////
+
+
+// All the numbers are little-endian u32 (or i32), so a field can be
+// loaded right where it is in a mapped file:
+//
+// "ESMSSTS" and a version byte (MATCH_STATS_VERSION)
+// number of players of each team, size of the string table, and the
+//   size and the FNV-1a hash of the commentary of the match (the
+//   stats are those of that commentary, and no other)
+// the offsets of the team names in the string table
+// for each team, for each player: MATCH_STATS_FIELDS numbers - the
+//   offsets of the name and the position, and the stats in the
+//   order of match_player_stats
+// the string table - NUL-terminated strings, each stored once
+//
+static const char MATCH_STATS_MAGIC[] = "ESMSSTS";
+static const unsigned char MATCH_STATS_VERSION = 2;
+static const unsigned MATCH_STATS_HEADER_SIZE = 24;
+static const unsigned MATCH_STATS_FIELDS = 21;
+
+
+// The stats fields of match_player_stats, in the order of the format
+//
+static int match_player_stats::* const stats_fields[MATCH_STATS_FIELDS - 2] =
+{
+    &match_player_stats::minutes, &match_player_stats::saves, &match_player_stats::tackles,
+    &match_player_stats::keypasses, &match_player_stats::assists, &match_player_stats::shots,
+    &match_player_stats::goals, &match_player_stats::yellowcards, &match_player_stats::redcards,
+    &match_player_stats::injured, &match_player_stats::fouls, &match_player_stats::shots_on,
+    &match_player_stats::shots_off, &match_player_stats::conceded, &match_player_stats::st_ab,
+    &match_player_stats::tk_ab, &match_player_stats::ps_ab, &match_player_stats::sh_ab,
+    &match_player_stats::fitness
+};
+
+
+bool write_match_stats_binary(FILE* file, const string team_name[2],
+                              const vector<match_player_stats> stats[2], const string& commentary)
+{
+    unsigned num_players = stats[0].size() - 1;
+
+    if (stats[1].size() - 1 != num_players)
+        return false;
+
+    string_table strings;
+    string records;
+
+    put_u32(records, strings.intern(team_name[0]));
+    put_u32(records, strings.intern(team_name[1]));
+
+    for (int t = 0; t <= 1; ++t)
+    {
+        for (unsigned i = 1; i <= num_players; ++i)
+        {
+            const match_player_stats& s = stats[t][i];
+
+            put_u32(records, strings.intern(s.name));
+            put_u32(records, strings.intern(s.pos));
+
+            for (unsigned f = 0; f < MATCH_STATS_FIELDS - 2; ++f)
+                put_u32(records, s.*stats_fields[f]);
+        }
+    }
+
+    string out(MATCH_STATS_MAGIC);
+    put_u8(out, MATCH_STATS_VERSION);
+    put_u32(out, num_players);
+    put_u32(out, strings.table.size());
+    put_u32(out, commentary.size());
+    put_u32(out, fnv1a_hash((const unsigned char*) commentary.data(), commentary.size()));
+
+    out += records;
+    out += strings.table;
+
+    return fwrite(out.data(), 1, out.size(), file) == out.size() && fflush(file) == 0;
+}
+
+
+string read_match_stats_binary(string filename, string team_name[2],
+                               vector<match_player_stats> stats[2], unsigned& commentary_size,
+                               unsigned& commentary_hash)
+{
+    mapped_file file;
+
+    if (!file.map_file(filename))
+        return format_str("Can't open %s: %s", filename.c_str(), strerror(errno));
+
+    const unsigned char* data = file.data;
+
+    if (file.size < MATCH_STATS_HEADER_SIZE
+            || memcmp(data, MATCH_STATS_MAGIC, strlen(MATCH_STATS_MAGIC)) != 0)
+        return format_str("%s is not a stats file", filename.c_str());
+
+    if (data[7] != MATCH_STATS_VERSION)
+        return format_str("%s: unsupported stats file version %u", filename.c_str(), data[7]);
+
+    unsigned num_players = load_u32(data + 8);
+    unsigned table_size = load_u32(data + 12);
+    commentary_size = load_u32(data + 16);
+    commentary_hash = load_u32(data + 20);
+
+    // (the sizes are checked one at a time, so they can't overflow)
+    //
+    size_t records_size = 8 + 2 * (size_t) num_players * MATCH_STATS_FIELDS * 4;
+
+    if (num_players > 255 || table_size > file.size
+            || MATCH_STATS_HEADER_SIZE + records_size + table_size != file.size)
+        return format_str("%s: corrupt stats file", filename.c_str());
+
+    const unsigned char* records = data + MATCH_STATS_HEADER_SIZE;
+    const char* table = (const char*) records + records_size;
+
+    // The strings must all be terminated within the table
+    //
+    if (table_size > 0 && table[table_size - 1] != '\0')
+        return format_str("%s: corrupt stats file", filename.c_str());
+
+    for (int t = 0; t <= 1; ++t)
+    {
+        unsigned offset = load_u32(records + 4 * t);
+
+        if (offset >= table_size)
+            return format_str("%s: corrupt stats file", filename.c_str());
+
+        team_name[t] = table + offset;
+    }
+
+    for (int t = 0; t <= 1; ++t)
+    {
+        stats[t].assign(num_players + 1, match_player_stats());
+
+        for (unsigned i = 1; i <= num_players; ++i)
+        {
+            const unsigned char* rec = records + 8 + ((t * num_players) + i - 1) * MATCH_STATS_FIELDS * 4;
+            match_player_stats& s = stats[t][i];
+
+            unsigned name_offset = load_u32(rec);
+            unsigned pos_offset = load_u32(rec + 4);
+
+            if (name_offset >= table_size || pos_offset >= table_size)
+                return format_str("%s: corrupt stats file", filename.c_str());
+
+            s.name = table + name_offset;
+            s.pos = table + pos_offset;
+
+            for (unsigned f = 0; f < MATCH_STATS_FIELDS - 2; ++f)
+                s.*stats_fields[f] = (int) load_u32(rec + 8 + 4 * f);
+        }
+    }
+
+    return "";
+}
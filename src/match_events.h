@@ -0,0 +1,200 @@
+// ESMS - Electronic Soccer Management Simulator
+// Copyright (C) <1998-2005>  Eli Bendersky
+//
+// This program is free software, licensed with the GPL (www.fsf.org)
+//
+#ifndef MATCH_EVENTS_H
+#define MATCH_EVENTS_H
+
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+
+using namespace std;
+
+
+// The kinds of events of a match. The fields of an event (see
+// match_event) mean, for each kind:
+//
+// MEV_LINEUP           - player starts on position value, other is
+//                        1 if he plays and 2 if he's on the bench
+//                        (minute 0, one for each player)
+// MEV_TACTIC           - the team plays tactic value (at minute 0,
+//                        and then on each change)
+// MEV_CHANCE           - player got a chance, other assisted it (0
+//                        for a solo chance)
+// MEV_TACKLE           - player tackled the chance of other (of the
+//                        other team)
+// MEV_SHOT             - player shot
+// MEV_SAVE             - player (a GK) saved the shot of other (of
+//                        the other team)
+// MEV_OFF_TARGET       - the shot of player was off target
+// MEV_GOAL             - player scored, other assisted (0 for no
+//                        assist) and value (of the other team) was
+//                        the GK
+// MEV_GOAL_CANCELLED   - the goal of player was cancelled
+// MEV_FOUL             - player fouled
+// MEV_YELLOW_CARD      - player got a yellow card
+// MEV_RED_CARD         - player was sent off, value is 1 if it was
+//                        for a second yellow card
+// MEV_INJURY           - player was injured
+// MEV_SUB              - player came on for other, on position value
+// MEV_POSITION_CHANGE  - player moved to position value
+// MEV_PENALTY          - player took a penalty against the GK other
+//                        (of the other team), value is its
+//                        penalty_outcome
+// MEV_SHOOTOUT_KICK    - the same, in the penalty shootout
+//
+// Positions (like DMR or GK) and tactics (like N) are packed into
+// value with pack_code.
+//
+enum match_event_type
+{
+    MEV_LINEUP,
+    MEV_TACTIC,
+    MEV_CHANCE,
+    MEV_TACKLE,
+    MEV_SHOT,
+    MEV_SAVE,
+    MEV_OFF_TARGET,
+    MEV_GOAL,
+    MEV_GOAL_CANCELLED,
+    MEV_FOUL,
+    MEV_YELLOW_CARD,
+    MEV_RED_CARD,
+    MEV_INJURY,
+    MEV_SUB,
+    MEV_POSITION_CHANGE,
+    MEV_PENALTY,
+    MEV_SHOOTOUT_KICK,
+    NUM_MATCH_EVENT_TYPES
+};
+
+
+enum penalty_outcome {PEN_SCORED, PEN_SAVED, PEN_OFF_TARGET};
+
+
+// An event of a match. team is the team of player (0 - home,
+// 1 - away), and players are numbered as in the teamsheet.
+//
+struct match_event
+{
+    unsigned char type;
+    unsigned char team;
+
+    // The gross and the net minute (see match_context)
+    //
+    unsigned char minute;
+    unsigned char formal_minute;
+
+    unsigned char player;
+    unsigned char other;
+    int value;
+};
+
+
+// What a match record holds about a player besides his events -
+// the results of the match that aren't events
+//
+struct match_player
+{
+    string name;
+    int minutes;
+    int st_ab, tk_ab, ps_ab, sh_ab;
+    int fitness;
+};
+
+
+// The stats of a player in a match - the final stats table of the
+// commentary (derived from the events by derive_final_stats, or
+// read from a stats file by read_match_stats_binary)
+//
+struct match_player_stats
+{
+    string name;
+
+    // The position he finished the match on
+    //
+    string pos;
+
+    int minutes;
+    int saves;
+    int tackles;
+    int keypasses;
+    int assists;
+    int shots;
+    int goals;
+    int yellowcards;
+    int redcards;
+    int injured;
+    int fouls;
+    int shots_on;
+    int shots_off;
+    int conceded;
+    int st_ab, tk_ab, ps_ab, sh_ab;
+    int fitness;
+};
+
+
+// Everything about a played match: the teams, their players
+// (players[team][n] is player n, [0] is unused), and the events
+// in the order they happened
+//
+struct match_record
+{
+    string team_name[2];
+    int score[2];
+    vector<match_player> players[2];
+    vector<match_event> events;
+};
+
+
+// A position or tactic (up to 3 chars) packed into an int, and back
+//
+int pack_code(const string& code);
+string unpack_code(int value);
+
+const char* match_event_name(int type);
+
+// Derives the final stats of the players from the events of the
+// record. stats[team] gets an element for each player, from 1
+// (so stats[team][0] is unused).
+//
+void derive_final_stats(const match_record& record, vector<match_player_stats> stats[2]);
+
+// Write the record to a file in the compact binary format or as
+// JSON lines (see match_events.cpp for both formats). Return false
+// if the writing failed.
+//
+bool write_match_record_binary(FILE* file, const match_record& record);
+bool write_match_record_json(FILE* file, const match_record& record);
+
+// Reads a record written by write_match_record_binary. Returns ""
+// on success, and an error message if something went wrong.
+//
+string read_match_record_binary(string filename, match_record& record);
+
+
+// The final stats of a match in a small fixed-layout binary file,
+// for updtr (see match_events.cpp for the format). stats[team] has
+// an element for each player, from 1 (so stats[team][0] is unused).
+// The positions are those of the final stats table. commentary is the
+// commentary of the match, as written to its file: its size and hash
+// are kept, so a reader can tell whether the file is still the one
+// the stats come from.
+//
+bool write_match_stats_binary(FILE* file, const string team_name[2],
+                              const vector<match_player_stats> stats[2], const string& commentary);
+
+// Reads a file written by write_match_stats_binary, with the size and
+// the hash of the commentary it was written with. Returns "" on
+// success, and an error message if something went wrong.
+//
+string read_match_stats_binary(string filename, string team_name[2],
+                               vector<match_player_stats> stats[2], unsigned& commentary_size,
+                               unsigned& commentary_hash);
+
+
+#endif // MATCH_EVENTS_H
@@ -0,0 +1,336 @@
+// ESMS - Electronic Soccer Management Simulator
+// Copyright (C) <1998-2005>  Eli Bendersky
+//
+// This program is free software, licensed with the GPL (www.fsf.org)
+//
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <unistd.h>
+
+#include "match_events.h"
+#include "binary_file.h"
+#include "util.h"
+
+
+// wait on exit ?
+//
+bool waitflag = false;
+
+
+//
+// Tests of the binary formats of match_events: a match record and a
+// stats file are written, read back and compared with what was
+// written. Run by "make check"; exits with 1 if a test fails.
+//
+
+static string test_dir;
+static unsigned num_failed = 0;
+
+
+static void check(bool ok, string what)
+{
+    if (!ok)
+    {
+        cout << "FAILED: " << what << endl;
+        num_failed++;
+    }
+}
+
+
+static void add_player(match_record& record, int team, string name, int minutes, int st_ab,
+                       int tk_ab, int ps_ab, int sh_ab, int fitness)
+{
+    match_player player;
+
+    player.name = name;
+    player.minutes = minutes;
+    player.st_ab = st_ab;
+    player.tk_ab = tk_ab;
+    player.ps_ab = ps_ab;
+    player.sh_ab = sh_ab;
+    player.fitness = fitness;
+
+    record.players[team].push_back(player);
+}
+
+
+static void add_event(match_record& record, int type, int team, int minute, int formal_minute,
+                      int player, int other, int value)
+{
+    match_event ev;
+
+    ev.type = type;
+    ev.team = team;
+    ev.minute = minute;
+    ev.formal_minute = formal_minute;
+    ev.player = player;
+    ev.other = other;
+    ev.value = value;
+
+    record.events.push_back(ev);
+}
+
+
+// A short match with an event of each kind, players with negative
+// abilities, and a penalty shootout
+//
+static match_record test_record(void)
+{
+    match_record record;
+
+    record.team_name[0] = "uva";
+    record.team_name[1] = "klm";
+    record.score[0] = 2;
+    record.score[1] = 1;
+
+    for (int t = 0; t <= 1; ++t)
+        record.players[t].push_back(match_player());
+
+    add_player(record, 0, "J_Viskishte", 90, 48, 0, 0, 0, 100);
+    add_player(record, 0, "G_Nocki", 90, 0, -42, -60, -60, 73);
+    add_player(record, 0, "A_Sub", 25, 0, 0, 12, 300, 95);
+    add_player(record, 1, "L_Ryili", 90, 62, 0, 0, 0, 100);
+    add_player(record, 1, "C_Umnablobt", 120, 0, 18, 59, 0, 61);
+    add_player(record, 1, "K_Bench", 0, 0, 0, 0, 0, 100);
+
+    add_event(record, MEV_LINEUP, 0, 0, 0, 1, 1, pack_code("GK"));
+    add_event(record, MEV_LINEUP, 0, 0, 0, 2, 1, pack_code("DMR"));
+    add_event(record, MEV_LINEUP, 0, 0, 0, 3, 2, pack_code("FW"));
+    add_event(record, MEV_LINEUP, 1, 0, 0, 1, 1, pack_code("GK"));
+    add_event(record, MEV_LINEUP, 1, 0, 0, 2, 1, pack_code("DC"));
+    add_event(record, MEV_LINEUP, 1, 0, 0, 3, 2, pack_code("MF"));
+    add_event(record, MEV_TACTIC, 0, 0, 0, 0, 0, pack_code("N"));
+    add_event(record, MEV_TACTIC, 1, 0, 0, 0, 0, pack_code("A"));
+    add_event(record, MEV_CHANCE, 0, 12, 12, 2, 0, 0);
+    add_event(record, MEV_TACKLE, 1, 12, 12, 2, 2, 0);
+    add_event(record, MEV_CHANCE, 1, 30, 30, 2, 1, 0);
+    add_event(record, MEV_SHOT, 1, 30, 30, 2, 0, 0);
+    add_event(record, MEV_SAVE, 0, 30, 30, 1, 2, 0);
+    add_event(record, MEV_SHOT, 1, 44, 44, 2, 0, 0);
+    add_event(record, MEV_OFF_TARGET, 1, 44, 44, 2, 0, 0);
+    add_event(record, MEV_FOUL, 0, 47, 45, 2, 0, 0);
+    add_event(record, MEV_YELLOW_CARD, 0, 47, 45, 2, 0, 0);
+    add_event(record, MEV_SUB, 0, 65, 63, 3, 2, pack_code("FW"));
+    add_event(record, MEV_POSITION_CHANGE, 1, 66, 64, 2, 0, pack_code("DMC"));
+    add_event(record, MEV_SHOT, 0, 70, 68, 3, 0, 0);
+    add_event(record, MEV_GOAL, 0, 70, 68, 3, 0, 1);
+    add_event(record, MEV_SHOT, 0, 80, 78, 3, 0, 0);
+    add_event(record, MEV_GOAL_CANCELLED, 0, 80, 78, 3, 0, 0);
+    add_event(record, MEV_INJURY, 1, 85, 83, 1, 0, 0);
+    add_event(record, MEV_RED_CARD, 1, 88, 86, 2, 0, 1);
+    add_event(record, MEV_PENALTY, 0, 90, 90, 1, 1, PEN_SCORED);
+    add_event(record, MEV_PENALTY, 1, 255, 255, 3, 1, PEN_SAVED);
+    add_event(record, MEV_SHOOTOUT_KICK, 0, 255, 255, 3, 1, PEN_OFF_TARGET);
+    add_event(record, MEV_SHOOTOUT_KICK, 1, 255, 255, 2, 1, -1);
+
+    return record;
+}
+
+
+static bool same_players(const vector<match_player>& left, const vector<match_player>& right)
+{
+    if (left.size() != right.size())
+        return false;
+
+    for (unsigned i = 1; i < left.size(); ++i)
+    {
+        const match_player& l = left[i];
+        const match_player& r = right[i];
+
+        if (l.name != r.name || l.minutes != r.minutes || l.st_ab != r.st_ab || l.tk_ab != r.tk_ab
+                || l.ps_ab != r.ps_ab || l.sh_ab != r.sh_ab || l.fitness != r.fitness)
+            return false;
+    }
+
+    return true;
+}
+
+
+static bool same_events(const vector<match_event>& left, const vector<match_event>& right)
+{
+    if (left.size() != right.size())
+        return false;
+
+    for (unsigned i = 0; i < left.size(); ++i)
+    {
+        const match_event& l = left[i];
+        const match_event& r = right[i];
+
+        if (l.type != r.type || l.team != r.team || l.minute != r.minute
+                || l.formal_minute != r.formal_minute || l.player != r.player
+                || l.other != r.other || l.value != r.value)
+            return false;
+    }
+
+    return true;
+}
+
+
+static bool same_stats(const vector<match_player_stats>& left, const vector<match_player_stats>& right)
+{
+    if (left.size() != right.size())
+        return false;
+
+    for (unsigned i = 1; i < left.size(); ++i)
+    {
+        const match_player_stats& l = left[i];
+        const match_player_stats& r = right[i];
+
+        if (l.name != r.name || l.pos != r.pos || l.minutes != r.minutes || l.saves != r.saves
+                || l.tackles != r.tackles || l.keypasses != r.keypasses || l.assists != r.assists
+                || l.shots != r.shots || l.goals != r.goals || l.yellowcards != r.yellowcards
+                || l.redcards != r.redcards || l.injured != r.injured || l.fouls != r.fouls
+                || l.shots_on != r.shots_on || l.shots_off != r.shots_off
+                || l.conceded != r.conceded || l.st_ab != r.st_ab || l.tk_ab != r.tk_ab
+                || l.ps_ab != r.ps_ab || l.sh_ab != r.sh_ab || l.fitness != r.fitness)
+            return false;
+    }
+
+    return true;
+}
+
+
+// Writes data to a file of the test directory
+//
+static void write_test_file(string filename, string data)
+{
+    FILE* file = fopen(filename.c_str(), "wb");
+
+    if (!file || fwrite(data.data(), 1, data.size(), file) != data.size())
+        die("Can't write %s", filename.c_str());
+
+    fclose(file);
+}
+
+
+static string read_test_file(string filename)
+{
+    FILE* file = fopen(filename.c_str(), "rb");
+
+    if (!file)
+        die("Can't open %s", filename.c_str());
+
+    string data;
+    char buf[4096];
+    size_t n;
+
+    while ((n = fread(buf, 1, sizeof(buf), file)) > 0)
+        data.append(buf, n);
+
+    fclose(file);
+    return data;
+}
+
+
+// A match record is read back as it was written, and a truncated one
+// is an error
+//
+static void test_match_record(void)
+{
+    string filename = test_dir + "uva_klm.evt";
+    match_record record = test_record();
+
+    FILE* file = fopen(filename.c_str(), "wb");
+
+    if (!file)
+        die("Can't open %s", filename.c_str());
+
+    check(write_match_record_binary(file, record), "match record: write");
+    fclose(file);
+
+    match_record read_record;
+    string msg = read_match_record_binary(filename, read_record);
+
+    check(msg == "", "match record: read - " + msg);
+
+    for (int t = 0; t <= 1; ++t)
+    {
+        check(read_record.team_name[t] == record.team_name[t], "match record: team names");
+        check(read_record.score[t] == record.score[t], "match record: score");
+        check(same_players(read_record.players[t], record.players[t]), "match record: players");
+    }
+
+    check(same_events(read_record.events, record.events), "match record: events");
+
+    string data = read_test_file(filename);
+    write_test_file(filename, data.substr(0, data.size() - 3));
+
+    match_record truncated_record;
+    check(read_match_record_binary(filename, truncated_record) != "", "match record: truncated");
+
+    remove(filename.c_str());
+}
+
+
+// The stats of a match are read back as they were written, with the
+// size and the hash of the commentary they were written with, and a
+// stats file cut short is an error
+//
+static void test_match_stats(void)
+{
+    string filename = test_dir + "uva_klm.sts";
+    match_record record = test_record();
+
+    vector<match_player_stats> stats[2];
+    derive_final_stats(record, stats);
+
+    string commentary = "uva 2 - 1 klm\n\nA_Sub (uva) 70'\n";
+
+    FILE* file = fopen(filename.c_str(), "wb");
+
+    if (!file)
+        die("Can't open %s", filename.c_str());
+
+    check(write_match_stats_binary(file, record.team_name, stats, commentary), "match stats: write");
+    fclose(file);
+
+    string team_name[2];
+    vector<match_player_stats> read_stats[2];
+    unsigned commentary_size = 0, commentary_hash = 0;
+
+    string msg = read_match_stats_binary(filename, team_name, read_stats, commentary_size,
+                                         commentary_hash);
+
+    check(msg == "", "match stats: read - " + msg);
+    check(commentary_size == commentary.size(), "match stats: commentary size");
+    check(commentary_hash == fnv1a_hash((const unsigned char*) commentary.data(), commentary.size()),
+          "match stats: commentary hash");
+
+    for (int t = 0; t <= 1; ++t)
+    {
+        check(team_name[t] == record.team_name[t], "match stats: team names");
+        check(same_stats(read_stats[t], stats[t]), "match stats: stats");
+    }
+
+    string data = read_test_file(filename);
+    write_test_file(filename, data.substr(0, data.size() - 1));
+
+    check(read_match_stats_binary(filename, team_name, read_stats, commentary_size,
+                                  commentary_hash) != "",
+          "match stats: truncated");
+
+    remove(filename.c_str());
+}
+
+
+int main(void)
+{
+    char dir_template[] = "/tmp/match_events_testXXXXXX";
+
+    if (!mkdtemp(dir_template))
+        die("Unable to create a test directory");
+
+    test_dir = string(dir_template) + "/";
+
+    test_match_record();
+    test_match_stats();
+
+    rmdir(dir_template);
+
+    if (num_failed > 0)
+        return 1;
+
+    cout << "match_events_test: OK" << endl;
+    return 0;
+}
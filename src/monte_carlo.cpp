@@ -0,0 +1,268 @@
+// ESMS - Electronic Soccer Management Simulator
+// Copyright (C) <1998-2005>  Eli Bendersky
+//
+// This program is free software, licensed with the GPL (www.fsf.org)
+//
+#include "monte_carlo.h"
+#include "thread_pool.h"
+
+#include <cmath>
+#include <algorithm>
+
+
+// The games are run in batches of BATCH_SIZE (the stop condition is
+// checked between batches), and each batch is split into jobs of
+// JOB_SIZE games, each running in one match_context
+//
+const unsigned BATCH_SIZE = 1024;
+const unsigned JOB_SIZE = 64;
+
+
+double monte_carlo_result::ci_half_width(void) const
+{
+    if (num_games == 0)
+        return 1.0;
+
+    double max_width = 0;
+    unsigned counts[3] = {home_wins, draws, away_wins};
+
+    for (int i = 0; i < 3; ++i)
+    {
+        double p = counts[i] / (double) num_games;
+        double width = 1.96 * sqrt(p * (1 - p) / num_games);
+
+        if (width > max_width)
+            max_width = width;
+    }
+
+    return max_width;
+}
+
+
+void monte_carlo_result::add(const monte_carlo_result& other)
+{
+    num_games += other.num_games;
+    home_wins += other.home_wins;
+    draws += other.draws;
+    away_wins += other.away_wins;
+
+    for (map<pair<int, int>, unsigned>::const_iterator iter = other.scorelines.begin();
+         iter != other.scorelines.end(); ++iter)
+    {
+        scorelines[iter->first] += iter->second;
+    }
+
+    for (int j = 0; j <= 1; ++j)
+    {
+        if (players[j].size() < other.players[j].size())
+            players[j].resize(other.players[j].size());
+
+        for (unsigned i = 0; i < other.players[j].size(); ++i)
+        {
+            const monte_carlo_player& from = other.players[j][i];
+            monte_carlo_player& to = players[j][i];
+
+            if (to.name == "")
+                to.name = from.name;
+
+            to.games_played += from.games_played;
+            to.goals += from.goals;
+            to.assists += from.assists;
+            to.yellowcards += from.yellowcards;
+            to.redcards += from.redcards;
+        }
+    }
+}
+
+
+// Adds the outcome of a finished game to a result
+//
+static void add_game(monte_carlo_result& result, const match_context& ctx)
+{
+    int home_score = ctx.team[0].score, away_score = ctx.team[1].score;
+
+    result.num_games++;
+
+    if (home_score > away_score)
+        result.home_wins++;
+    else if (home_score == away_score)
+        result.draws++;
+    else
+        result.away_wins++;
+
+    result.scorelines[make_pair(home_score, away_score)]++;
+
+    for (int j = 0; j <= 1; ++j)
+    {
+        result.players[j].resize(ctx.num_players + 1);
+
+        for (int i = 1; i <= ctx.num_players; ++i)
+        {
+            const playerstruct& player = ctx.team[j].player[i];
+            monte_carlo_player& totals = result.players[j][i];
+
+            if (totals.name == "")
+                totals.name = player.name;
+
+            if (player.minutes > 0)
+                totals.games_played++;
+
+            totals.goals += player.goals;
+            totals.assists += player.assists;
+            totals.yellowcards += player.yellowcards;
+            totals.redcards += player.redcards;
+        }
+    }
+}
+
+
+// The games of one batch
+//
+struct monte_carlo_batch
+{
+    const match_inputs* inputs;
+    unsigned random_seed;
+    unsigned first_game;
+    unsigned num_games;
+
+    // One result and error message per job
+    //
+    vector<monte_carlo_result> results;
+    vector<string> errors;
+};
+
+
+static void run_monte_carlo_job(unsigned job_num, void* data)
+{
+    monte_carlo_batch* batch = (monte_carlo_batch*) data;
+
+    unsigned first = job_num * JOB_SIZE;
+    unsigned last = min(first + JOB_SIZE, batch->num_games);
+
+    match_inputs inputs = *batch->inputs;
+    match_context* ctx = new match_context;
+
+    for (unsigned i = first; i < last; ++i)
+    {
+        inputs.rng = rng_stream(batch->random_seed, 0, batch->first_game + i);
+
+        string msg = simulate_match(*ctx, inputs);
+
+        if (msg != "")
+        {
+            batch->errors[job_num] = msg;
+            break;
+        }
+
+        add_game(batch->results[job_num], *ctx);
+    }
+
+    delete ctx;
+}
+
+
+string run_monte_carlo(const match_inputs& inputs, unsigned random_seed, unsigned max_games,
+                       double target_ci_width, unsigned num_threads, monte_carlo_result& result)
+{
+    // The sink is shared by all the threads - a null sink has no state
+    //
+    null_commentary_sink no_commentary;
+
+    match_inputs quiet_inputs = inputs;
+    quiet_inputs.comm = &no_commentary;
+    quiet_inputs.shootout = SHOOTOUT_NEVER;
+
+    result = monte_carlo_result();
+    result.team_name[0] = inputs.team_name[0];
+    result.team_name[1] = inputs.team_name[1];
+
+    while (result.num_games < max_games)
+    {
+        monte_carlo_batch batch;
+        batch.inputs = &quiet_inputs;
+        batch.random_seed = random_seed;
+        batch.first_game = result.num_games;
+        batch.num_games = min(BATCH_SIZE, max_games - result.num_games);
+
+        unsigned num_jobs = (batch.num_games + JOB_SIZE - 1) / JOB_SIZE;
+        batch.results.resize(num_jobs);
+        batch.errors.resize(num_jobs);
+
+        run_parallel(num_jobs, num_threads, run_monte_carlo_job, &batch);
+
+        for (unsigned i = 0; i < num_jobs; ++i)
+        {
+            if (batch.errors[i] != "")
+                return batch.errors[i];
+
+            result.add(batch.results[i]);
+        }
+
+        if (target_ci_width > 0 && 2 * result.ci_half_width() < target_ci_width)
+            break;
+    }
+
+    return "";
+}
+
+
+static bool more_likely_scoreline(const pair<pair<int, int>, unsigned>& lhs,
+                                  const pair<pair<int, int>, unsigned>& rhs)
+{
+    if (lhs.second != rhs.second)
+        return lhs.second > rhs.second;
+
+    return lhs.first < rhs.first;
+}
+
+
+void print_monte_carlo_result(FILE* out, const monte_carlo_result& result)
+{
+    double n = result.num_games;
+
+    if (result.num_games == 0)
+        return;
+
+    fprintf(out, "Monte Carlo simulation: %s - %s, %u games\n\n",
+            result.team_name[0].c_str(), result.team_name[1].c_str(), result.num_games);
+
+    fprintf(out, "Home win   %6.2f%%\n", 100 * result.home_wins / n);
+    fprintf(out, "Draw       %6.2f%%\n", 100 * result.draws / n);
+    fprintf(out, "Away win   %6.2f%%\n", 100 * result.away_wins / n);
+    fprintf(out, "(95%% confidence: +-%.2f%%)\n", 100 * result.ci_half_width());
+
+    // Scorelines, from the most likely
+    //
+    vector<pair<pair<int, int>, unsigned> > scorelines(result.scorelines.begin(), result.scorelines.end());
+    sort(scorelines.begin(), scorelines.end(), more_likely_scoreline);
+
+    fprintf(out, "\nScore    Games     Prob\n");
+    fprintf(out, "-----------------------\n");
+
+    for (unsigned i = 0; i < scorelines.size(); ++i)
+    {
+        fprintf(out, "%2d-%-2d  %7u  %6.2f%%\n", scorelines[i].first.first, scorelines[i].first.second,
+                scorelines[i].second, 100 * scorelines[i].second / n);
+    }
+
+    // Expected stats per game of each player who played
+    //
+    for (int j = 0; j <= 1; ++j)
+    {
+        fprintf(out, "\n<<< %s >>>\n", result.team_name[j].c_str());
+        fprintf(out, "\nName          Played   Gls   Ass   Yel   Red\n");
+        fprintf(out, "---------------------------------------------\n");
+
+        for (unsigned i = 1; i < result.players[j].size(); ++i)
+        {
+            const monte_carlo_player& player = result.players[j][i];
+
+            if (player.games_played == 0)
+                continue;
+
+            fprintf(out, "%-13s %5.1f%% %5.2f %5.2f %5.2f %5.2f\n", player.name.c_str(),
+                    100 * player.games_played / n, player.goals / n, player.assists / n,
+                    player.yellowcards / n, player.redcards / n);
+        }
+    }
+}
@@ -0,0 +1,97 @@
+// ESMS - Electronic Soccer Management Simulator
+// Copyright (C) <1998-2005>  Eli Bendersky
+//
+// This program is free software, licensed with the GPL (www.fsf.org)
+//
+#ifndef MONTE_CARLO_H
+#define MONTE_CARLO_H
+
+
+#include <map>
+#include <string>
+#include <vector>
+#include <cstdio>
+
+#include "game.h"
+
+
+using namespace std;
+
+
+// The totals of one player over all the simulated games
+//
+struct monte_carlo_player
+{
+    monte_carlo_player()
+        : games_played(0), goals(0), assists(0), yellowcards(0), redcards(0)
+    {}
+
+    string name;
+    unsigned games_played;
+    unsigned goals;
+    unsigned assists;
+    unsigned yellowcards;
+    unsigned redcards;
+};
+
+
+// The results of running the same match many times
+//
+struct monte_carlo_result
+{
+    monte_carlo_result()
+        : num_games(0), home_wins(0), draws(0), away_wins(0)
+    {}
+
+    string team_name[2];
+
+    unsigned num_games;
+    unsigned home_wins;
+    unsigned draws;
+    unsigned away_wins;
+
+    // The number of games that ended with each score (home, away)
+    //
+    map<pair<int, int>, unsigned> scorelines;
+
+    // Indexed like the players of the teamsheets (1 .. num_players,
+    // 0 is unused)
+    //
+    vector<monte_carlo_player> players[2];
+
+    // The largest 95% confidence interval half-width of the home win,
+    // draw and away win probabilities
+    //
+    double ci_half_width(void) const;
+
+    void add(const monte_carlo_result& other);
+};
+
+
+// Simulates the match given by inputs (ignoring inputs.comm and
+// inputs.shootout - the games are run without commentary and without
+// penalty shootouts) up to max_games times on
+// num_threads threads. Game i is played with the random stream of
+// week 0, fixture i of random_seed (so game 0 is the game esms plays
+// with this seed).
+//
+// If target_ci_width is positive, the simulation stops early when
+// the 95% confidence intervals of the home win, draw and away win
+// probabilities are all narrower than target_ci_width (for example,
+// 0.02 for +-1%). The check is done after each batch of games, so
+// the result doesn't depend on the amount of threads.
+//
+// Returns "" on success, and an error message if the inputs are
+// illegal.
+//
+string run_monte_carlo(const match_inputs& inputs, unsigned random_seed, unsigned max_games,
+                       double target_ci_width, unsigned num_threads, monte_carlo_result& result);
+
+
+// Prints the probabilities and the expected player stats of a
+// Monte Carlo run
+//
+void print_monte_carlo_result(FILE* out, const monte_carlo_result& result);
+
+
+#endif // MONTE_CARLO_H
@@ -0,0 +1,79 @@
+// ESMS - Electronic Soccer Management Simulator
+// Copyright (C) <1998-2005>  Eli Bendersky
+//
+// This program is free software, licensed with the GPL (www.fsf.org)
+//
+#include "name_index.h"
+
+
+const unsigned name_index::NO_NAME;
+
+
+// FNV-1a
+//
+unsigned name_index::hash(const string& name)
+{
+    unsigned h = 2166136261u;
+
+    for (string::const_iterator c = name.begin(); c != name.end(); ++c)
+    {
+        h ^= (unsigned char) *c;
+        h *= 16777619u;
+    }
+
+    return h;
+}
+
+
+unsigned name_index::slot_of(const string& name) const
+{
+    unsigned mask = slots.size() - 1;
+    unsigned slot = hash(name) & mask;
+
+    while (slots[slot] != NO_NAME && names[slots[slot]] != name)
+        slot = (slot + 1) & mask;
+
+    return slot;
+}
+
+
+void name_index::grow(void)
+{
+    slots.assign(slots.empty() ? 64 : 2 * slots.size(), NO_NAME);
+
+    for (unsigned id = 0; id < names.size(); ++id)
+        slots[slot_of(names[id])] = id;
+}
+
+
+unsigned name_index::intern(const string& name)
+{
+    if (2 * (names.size() + 1) > slots.size())
+        grow();
+
+    unsigned slot = slot_of(name);
+
+    if (slots[slot] == NO_NAME)
+    {
+        slots[slot] = names.size();
+        names.push_back(name);
+    }
+
+    return slots[slot];
+}
+
+
+unsigned name_index::find(const string& name) const
+{
+    if (slots.empty())
+        return NO_NAME;
+
+    return slots[slot_of(name)];
+}
+
+
+void name_index::clear(void)
+{
+    names.clear();
+    slots.clear();
+}
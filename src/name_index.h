@@ -0,0 +1,71 @@
+// ESMS - Electronic Soccer Management Simulator
+// Copyright (C) <1998-2005>  Eli Bendersky
+//
+// This program is free software, licensed with the GPL (www.fsf.org)
+//
+#ifndef NAME_INDEX_H
+#define NAME_INDEX_H
+
+
+#include <string>
+#include <vector>
+
+
+using namespace std;
+
+
+// Interns names (of players, or teams): gives each name a dense id - 0 for
+// the first name added, 1 for the next new one and so on - found by
+// hashing, so matching the players of a teamsheet or a stats file
+// to a roster costs a lookup per player instead of a scan of the
+// roster.
+//
+class name_index
+{
+public:
+    // The id find returns for a name that isn't in the index
+    //
+    static const unsigned NO_NAME = ~0u;
+
+    name_index()
+    {}
+
+    // Returns the id of name, adding it if it's new
+    //
+    unsigned intern(const string& name);
+
+    // Returns the id of name, or NO_NAME
+    //
+    unsigned find(const string& name) const;
+
+    const string& name(unsigned id) const
+    {
+        return names[id];
+    }
+
+    unsigned size(void) const
+    {
+        return names.size();
+    }
+
+    void clear(void);
+
+private:
+    static unsigned hash(const string& name);
+
+    // Returns the slot of name, or the empty slot it belongs in
+    //
+    unsigned slot_of(const string& name) const;
+
+    void grow(void);
+
+    vector<string> names;
+
+    // An open-addressing table of ids (NO_NAME in the empty slots),
+    // at most half full. Its size is a power of 2.
+    //
+    vector<unsigned> slots;
+};
+
+
+#endif // NAME_INDEX_H
@@ -7,22 +7,12 @@
 #include "comment.h"
 
 
-/* Variables used from @esms.c */
-extern struct teams team[2];
-extern FILE* comm;
-
-
-/* maximum of 11 PK takers is possible for each team */
-struct playerstruct PenaltyTaker[2][11];
-int KickTakers[2]; /* num of penalty kick takers available for each team */
-int PenScore[2] = {0};  /* penalties scored by teams 0 and 1 */
-
-
-void RunPenaltyShootout(void)
+void match_context::RunPenaltyShootout(void)
 {
     int nTeam, nPenaltyNum;    /* used in the main penalties loop */
 
-    fprintf(comm, "\n%s\n", the_commentary().rand_comment("PENALTYSHOOTOUT").c_str());
+    if (play_by_play)
+        comm->print("\n%s\n", comment(comm_rng, EV_PENALTYSHOOTOUT));
 
     AssignPenaltyTakers();
 
@@ -90,15 +80,14 @@ void RunPenaltyShootout(void)
 	}
     }
 
-    if (GoalDiff() > 0)
-	fprintf(comm, "\n%s", the_commentary().rand_comment("WONPENALTYSHOOTOUT", team[0].name).c_str());
-    else
-	fprintf(comm, "\n%s", the_commentary().rand_comment("WONPENALTYSHOOTOUT", team[1].name).c_str());
+    if (play_by_play)
+	comm->print("\n%s", comment(comm_rng, EV_WONPENALTYSHOOTOUT,
+							      team[GoalDiff() > 0 ? 0 : 1].name));
 }
 
 /* Returns the goal difference (negative if team 1 leads)
 */
-int GoalDiff(void)
+int match_context::GoalDiff(void)
 {
     return (PenScore[0] - PenScore[1]);
 }
@@ -108,7 +97,7 @@ int GoalDiff(void)
 ** not injured and not suspended, and wasn't substituted) to be the penalty
 ** kick takers.
 */
-void AssignPenaltyTakers()
+void match_context::AssignPenaltyTakers()
 {
     int nTeam, nTaker, nPlayer;      /* counters to loop through the teams */
     int max = 0, index = 0;          /* used for finding the best shooters */
@@ -119,7 +108,7 @@ void AssignPenaltyTakers()
     {
 	for (nPlayer = 1; nPlayer <= num_players; nPlayer++)
 	{
-	    if (team[nTeam].player[nPlayer].active == 1)
+	    if (team[nTeam].hot.active[nPlayer] == 1)
 		KickTakers[nTeam]++;
 	}
     }
@@ -133,7 +122,7 @@ void AssignPenaltyTakers()
 	{
 	    for (nPlayer = 1; nPlayer <= num_players; nPlayer++)
 	    {
-		if ((team[nTeam].player[nPlayer].sh > max) && (team[nTeam].player[nPlayer].active == 1))
+		if ((team[nTeam].player[nPlayer].sh > max) && (team[nTeam].hot.active[nPlayer] == 1))
 		{
 		    max = team[nTeam].player[nPlayer].sh;
 		    index = nPlayer;
@@ -143,8 +132,9 @@ void AssignPenaltyTakers()
 	    /* copy the stats of the suitable player to PenaltyTaker */
 	    strcpy(PenaltyTaker[nTeam][nTaker].name, team[nTeam].player[index].name);
 	    PenaltyTaker[nTeam][nTaker].sh = team[nTeam].player[index].sh;
+	    PenaltyTakerNum[nTeam][nTaker] = index;
 	    /* set active = 0, making sure that this player won't be chosen again */
-	    team[nTeam].player[index].active = 0;
+	    team[nTeam].hot.active[index] = 0;
 
 	    max = index = 0;
 	}
@@ -154,29 +144,43 @@ void AssignPenaltyTakers()
 
 /* This function takes care of the penalties taken 
 */
-void TakePenalty(int nTeam, int nPenaltyNum)
+void match_context::TakePenalty(int nTeam, int nPenaltyNum)
 {
-    fprintf(comm, "\n%s", the_commentary().rand_comment("PENALTY", PenaltyTaker[nTeam][nPenaltyNum].name).c_str());
+    if (play_by_play)
+        comm->print("\n%s", comment(comm_rng, EV_PENALTY, PenaltyTaker[nTeam][nPenaltyNum].name));
 
     /* checking if a goal was scored */
     if (randomp(8000 + PenaltyTaker[nTeam][nPenaltyNum].sh*100 -
 		team[!nTeam].player[team[!nTeam].current_gk].st*100))
     {
-	fprintf(comm, "%s", the_commentary().rand_comment("GOAL").c_str());;
-
 	PenScore[nTeam]++;
-	fprintf(comm, "\n          ...  %s %d-%d %s...", team[0].name, PenScore[0],
-		PenScore[1],  team[1].name);
+
+	add_event(MEV_SHOOTOUT_KICK, nTeam, PenaltyTakerNum[nTeam][nPenaltyNum],
+		  team[!nTeam].current_gk, PEN_SCORED);
+
+	if (play_by_play)
+	{
+	    comm->write(comment(comm_rng, EV_GOAL));
+	    comm->print("\n          ...  %s %d-%d %s...", team[0].name, PenScore[0],
+		    PenScore[1],  team[1].name);
+	}
     }
     else
     {
 	int rnd = my_random(10);
-	if (rnd < 5)
-	    fprintf(comm, "%s", the_commentary().rand_comment("SAVE", 
-							team[!nTeam].player[team[!nTeam].current_gk].name).c_str());
-	else
-	    fprintf(comm, "%s", the_commentary().rand_comment("OFFTARGET", 
-							team[!nTeam].player[team[!nTeam].current_gk].name).c_str());
+
+	add_event(MEV_SHOOTOUT_KICK, nTeam, PenaltyTakerNum[nTeam][nPenaltyNum],
+		  team[!nTeam].current_gk, rnd < 5 ? PEN_SAVED : PEN_OFF_TARGET);
+
+	if (play_by_play)
+	{
+	    if (rnd < 5)
+		comm->write(comment(comm_rng, EV_SAVE, 
+							    team[!nTeam].player[team[!nTeam].current_gk].name));
+	    else
+		comm->write(comment(comm_rng, EV_OFFTARGET, 
+							    team[!nTeam].player[team[!nTeam].current_gk].name));
+	}
     }
 }
 
@@ -0,0 +1,194 @@
+// ESMS - Electronic Soccer Management Simulator
+// Copyright (C) <1998-2005>  Eli Bendersky
+//
+// This program is free software, licensed with the GPL (www.fsf.org)
+//
+#include "rng.h"
+
+
+// Distinguishes the keys of game streams from the keys of
+// other generators built on the same function
+//
+const unsigned GAME_KEY_TAG = 0x45534d53;
+
+// The high counter word used to derive child keys. The parent
+// stream would have to generate 2^63 numbers to reach it.
+//
+const unsigned SPLIT_CTR_TAG = 0xffffffff;
+
+
+static inline unsigned rotl32(unsigned x, unsigned n)
+{
+    return (x << n) | (x >> (32 - n));
+}
+
+
+static const unsigned rotations[8] = {13, 15, 26, 6, 17, 29, 16, 24};
+
+
+// Threefry-2x32-20: encrypts the counter in with the given key
+//
+static void threefry2x32(const unsigned key[2], const unsigned in[2], unsigned out[2])
+{
+    unsigned ks[3];
+    ks[0] = key[0];
+    ks[1] = key[1];
+    ks[2] = 0x1bd11bda ^ key[0] ^ key[1];
+
+    unsigned x0 = in[0] + ks[0];
+    unsigned x1 = in[1] + ks[1];
+
+    for (unsigned r = 0; r < 20; ++r)
+    {
+        x0 += x1;
+        x1 = rotl32(x1, rotations[r % 8]);
+        x1 ^= x0;
+
+        // Inject the key every 4 rounds
+        //
+        if (r % 4 == 3)
+        {
+            unsigned s = (r + 1) / 4;
+
+            x0 += ks[s % 3];
+            x1 += ks[(s + 1) % 3] + s;
+        }
+    }
+
+    out[0] = x0;
+    out[1] = x1;
+}
+
+
+// The same as threefry2x32, for RNG_BUFFER_BLOCKS consecutive counters
+// starting at ctr. Each round is applied to all the lanes at once, in
+// loops without dependencies between the lanes, so they vectorize.
+// out gets the two words of each block one after the other, in the
+// order threefry2x32 would produce them.
+//
+static void threefry2x32_bulk(const unsigned key[2], const unsigned ctr[2], unsigned out[RNG_BUFFER_SIZE])
+{
+    unsigned ks[3];
+    ks[0] = key[0];
+    ks[1] = key[1];
+    ks[2] = 0x1bd11bda ^ key[0] ^ key[1];
+
+    unsigned x0[RNG_BUFFER_BLOCKS];
+    unsigned x1[RNG_BUFFER_BLOCKS];
+
+    for (unsigned i = 0; i < RNG_BUFFER_BLOCKS; ++i)
+    {
+        // The counter is 64 bits wide - the high word gets the carry
+        //
+        unsigned lo = ctr[0] + i;
+        unsigned hi = ctr[1] + (lo < ctr[0] ? 1 : 0);
+
+        x0[i] = lo + ks[0];
+        x1[i] = hi + ks[1];
+    }
+
+    for (unsigned r = 0; r < 20; ++r)
+    {
+        unsigned rot = rotations[r % 8];
+
+        for (unsigned i = 0; i < RNG_BUFFER_BLOCKS; ++i)
+        {
+            x0[i] += x1[i];
+            x1[i] = rotl32(x1[i], rot);
+            x1[i] ^= x0[i];
+        }
+
+        if (r % 4 == 3)
+        {
+            unsigned s = (r + 1) / 4;
+            unsigned k0 = ks[s % 3];
+            unsigned k1 = ks[(s + 1) % 3] + s;
+
+            for (unsigned i = 0; i < RNG_BUFFER_BLOCKS; ++i)
+            {
+                x0[i] += k0;
+                x1[i] += k1;
+            }
+        }
+    }
+
+    for (unsigned i = 0; i < RNG_BUFFER_BLOCKS; ++i)
+    {
+        out[2 * i] = x0[i];
+        out[2 * i + 1] = x1[i];
+    }
+}
+
+
+rng_stream::rng_stream(unsigned seed, unsigned week, unsigned fixture)
+{
+    unsigned seed_key[2] = {seed, GAME_KEY_TAG};
+    unsigned game[2] = {week, fixture};
+
+    threefry2x32(seed_key, game, key);
+
+    ctr[0] = ctr[1] = 0;
+    pos = RNG_BUFFER_SIZE;
+}
+
+
+rng_stream rng_stream::split(unsigned n) const
+{
+    unsigned child_ctr[2] = {n, SPLIT_CTR_TAG};
+
+    rng_stream child;
+    threefry2x32(key, child_ctr, child.key);
+
+    return child;
+}
+
+
+void rng_stream::refill(void)
+{
+    threefry2x32_bulk(key, ctr, buffer);
+
+    unsigned old_lo = ctr[0];
+    ctr[0] += RNG_BUFFER_BLOCKS;
+
+    if (ctr[0] < old_lo)
+        ++ctr[1];
+
+    pos = 0;
+}
+
+
+void rng_stream::discard(unsigned long n)
+{
+    // First use up the buffer
+    //
+    unsigned left_in_buffer = RNG_BUFFER_SIZE - pos;
+
+    if (n < left_in_buffer)
+    {
+        pos += n;
+        return;
+    }
+
+    n -= left_in_buffer;
+
+    // Then skip whole blocks (the shift is split in two so it's
+    // legal where unsigned long is 32 bits wide), and refill the
+    // buffer from the block the next number is in
+    //
+    unsigned long blocks = n / 2;
+    unsigned blocks_lo = (unsigned) (blocks & 0xffffffffUL);
+    unsigned blocks_hi = (unsigned) ((blocks >> 16) >> 16);
+
+    unsigned old_lo = ctr[0];
+    ctr[0] += blocks_lo;
+    ctr[1] += blocks_hi + (ctr[0] < old_lo ? 1 : 0);
+
+    refill();
+    pos = n % 2;
+}
+
+
+double rng_stream::uniform(void)
+{
+    return next() * (1.0 / 4294967296.0);
+}
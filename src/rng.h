@@ -0,0 +1,113 @@
+// ESMS - Electronic Soccer Management Simulator
+// Copyright (C) <1998-2005>  Eli Bendersky
+//
+// This program is free software, licensed with the GPL (www.fsf.org)
+//
+#ifndef RNG_H
+#define RNG_H
+
+
+///////////////////////
+//
+// rng_stream
+//
+// A stream of pseudo-random numbers, generated by a counter-based
+// generator (Threefry-2x32 with 20 rounds, by Salmon et al. - see
+// "Parallel Random Numbers: As Easy as 1, 2, 3", SC 2011).
+//
+// The n-th number of a stream is a function of the stream's key
+// and of n only, so:
+//
+// * A stream is fully determined by what it was created from -
+//   the league seed, the week and the fixture of a game. A game
+//   plays the same whatever thread runs it, and whatever else
+//   runs alongside.
+//
+// * discard(n) jumps n numbers ahead at no cost.
+//
+// * split(n) creates independent child streams (for example, for
+//   the commentary of a match or for each game of a Monte Carlo
+//   run), that never overlap with their parent.
+//
+// The numbers are generated RNG_BUFFER_BLOCKS blocks (of 2 numbers)
+// at a time into a buffer. The lanes of a refill are independent, so
+// the compiler can vectorize it (with -O3, or -O2 on recent gcc).
+//
+// A stream is a value - copying it copies its position.
+//
+const unsigned RNG_BUFFER_BLOCKS = 32;
+const unsigned RNG_BUFFER_SIZE = 2 * RNG_BUFFER_BLOCKS;
+
+
+class rng_stream
+{
+public:
+    // The stream of a game: seed is the league seed, week is the
+    // number of the week in fixtures.txt and fixture the number of
+    // the game in the week. A single game (esms) is week 0,
+    // fixture 0.
+    //
+    explicit rng_stream(unsigned seed = 0, unsigned week = 0, unsigned fixture = 0);
+
+    // Returns the n-th child stream of this stream. Children depend
+    // only on the key of this stream, not on its position.
+    //
+    rng_stream split(unsigned n) const;
+
+    // Skips the next n numbers of the stream
+    //
+    void discard(unsigned long n);
+
+    // Returns a pseudo-random integer in the range 0..2^32-1
+    //
+    unsigned next(void)
+    {
+        if (pos == RNG_BUFFER_SIZE)
+            refill();
+
+        return buffer[pos++];
+    }
+
+    // Returns a pseudo-random integer in the range 0..n-1 (n > 0).
+    //
+    // The range of next() is cut into n buckets of equal size and
+    // the number of the bucket is returned. The few numbers above
+    // the last full bucket are rejected, so the result is unbiased.
+    // For a constant n, the compiler turns this into a multiplication
+    // and a compare.
+    //
+    unsigned below(unsigned n)
+    {
+        unsigned bucket = 0xffffffffu / n;
+        unsigned limit = bucket * n;
+        unsigned r;
+
+        do
+        {
+            r = next();
+        }
+        while (r >= limit);
+
+        return r / bucket;
+    }
+
+    // Returns a pseudo-random real number in the range [0, 1)
+    //
+    double uniform(void);
+
+private:
+    void refill(void);
+
+    unsigned key[2];
+
+    // The counter of the next block to generate, and the blocks
+    // generated last (of which the numbers from pos onwards are
+    // still unused)
+    //
+    unsigned ctr[2];
+    unsigned buffer[RNG_BUFFER_SIZE];
+    unsigned pos;
+};
+
+
+#endif // RNG_H
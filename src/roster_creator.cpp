@@ -22,12 +22,18 @@ using namespace std;
 #include "config.h"
 #include "rosterplayer.h"
 #include "anyoption.h"
+#include "rng.h"
 
 // whether there is a wait on exit
 //
 bool waitflag = true;
 
 
+// The random stream all the rosters are generated from
+//
+rng_stream creator_rng;
+
+
 char nationalities[20][4] = {"arg", "aus", "bra", "bul",
                              "cam", "cro", "den", "eng",
                              "fra", "ger", "hol", "ire",
@@ -71,7 +77,7 @@ bool more_sh(const RosterPlayer& p1, const RosterPlayer& p2)
 
 int main(int argc, char* argv[])
 {
-    srand((unsigned) time(NULL));
+    creator_rng = rng_stream(time(NULL));
 
     // handling/parsing command line arguments
     //
@@ -272,10 +278,7 @@ int main(int argc, char* argv[])
 //
 inline unsigned uniform_random(unsigned max)
 {
-    double d = rand() / (double) RAND_MAX;
-    unsigned u = (unsigned)  (d * (max + 1));
-
-    return (u == max + 1 ? max - 1 : u);
+    return creator_rng.below(max + 1);
 }
 
 
@@ -307,8 +310,8 @@ void fill_gaussian_vars_arr(double* arr, unsigned amount)
         {
             do
             {
-                double u1 = rand() / (double)RAND_MAX;
-                double u2 = rand() / (double)RAND_MAX;
+                double u1 = creator_rng.uniform();
+                double u2 = creator_rng.uniform();
 
                 v1 = 2*u1 - 1;
                 v2 = 2*u2 - 1;
@@ -0,0 +1,1106 @@
+// ESMS - Electronic Soccer Management Simulator
+// Copyright (C) <1998-2005>  Eli Bendersky
+//
+// This program is free software, licensed with the GPL (www.fsf.org)
+//
+#include "roster_pipeline.h"
+#include "rosterplayer.h"
+#include "config.h"
+#include "comment.h"
+#include "util.h"
+#include "league_store.h"
+#include "rng.h"
+#include "match_events.h"
+#include "binary_file.h"
+#include "thread_pool.h"
+#include <iostream>
+#include <vector>
+#include <map>
+#include <string>
+#include <fstream>
+#include <functional>
+#include <algorithm>
+#include <sys/stat.h>
+
+using namespace std;
+
+
+bool is_stats_header_line(string line)
+{
+    vector<string> toks = tokenize(line, " \t");
+
+    if (toks.size() >= 3 && toks[0] == "<<<" && toks[toks.size() - 1] == ">>>")
+        return true;
+    else
+        return false;
+}
+
+
+void match_stats_to_game_stats(const vector<match_player_stats>& stats, vector<player_game_stats>& team)
+{
+    int dp_for_yellow = the_config().get_int_config("DP_FOR_YELLOW", 4);
+    int dp_for_red = the_config().get_int_config("DP_FOR_RED", 10);
+
+    team.clear();
+
+    for (unsigned i = 1; i < stats.size(); ++i)
+    {
+        const match_player_stats& s = stats[i];
+
+        player_game_stats player;
+        player.name = s.name;
+        player.pos = s.pos;
+        player.minutes = s.minutes;
+        player.games = (player.minutes > 0) ? 1 : 0;
+        player.saves = s.saves;
+        player.tackles = s.tackles;
+        player.keypasses = s.keypasses;
+        player.assists = s.assists;
+        player.shots = s.shots;
+        player.goals = s.goals;
+        player.yellow = s.yellowcards;
+        player.red = s.redcards;
+        player.injured = s.injured;
+        player.st_ab = s.st_ab;
+        player.tk_ab = s.tk_ab;
+        player.ps_ab = s.ps_ab;
+        player.sh_ab = s.sh_ab;
+        player.fitness = s.fitness;
+        player.dp = dp_for_red * player.red + dp_for_yellow * player.yellow;
+
+        team.push_back(player);
+    }
+}
+
+
+// Reads the stats of a game from the binary stats file esms writes
+// next to its commentary. Returns false if there's no usable stats
+// file: when there's none, when the commentary isn't the one it was
+// written with (it was edited or replaced after the game - even in the
+// same second), or when it can't be read.
+//
+static bool get_players_game_stats_binary(string stats_filename, vector<player_game_stats>& home_team,
+                                          vector<player_game_stats>& away_team)
+{
+    string binary_filename = stats_filename.substr(0, stats_filename.find_last_of(".")) + ".sts";
+
+    struct stat binary_st;
+
+    if (stat(binary_filename.c_str(), &binary_st) != 0)
+        return false;
+
+    string team_name[2];
+    vector<match_player_stats> stats[2];
+    unsigned commentary_size, commentary_hash;
+
+    string msg = read_match_stats_binary(binary_filename, team_name, stats, commentary_size,
+                                         commentary_hash);
+
+    if (msg != "")
+    {
+        cerr << msg << ", reading the stats from " << stats_filename << endl;
+        return false;
+    }
+
+    mapped_file commentary;
+
+    if (!commentary.map_file(stats_filename) || commentary.size != commentary_size
+            || fnv1a_hash(commentary.data, commentary.size) != commentary_hash)
+        return false;
+
+    match_stats_to_game_stats(stats[0], home_team);
+    match_stats_to_game_stats(stats[1], away_team);
+
+    return true;
+}
+
+
+// Fills in the vectors with stats from filename (the commentary
+// of a game), or from the binary stats file of the game if there's
+// one (see get_players_game_stats_binary)
+//
+void get_players_game_stats(string stats_filename, vector<player_game_stats>& home_team,
+                            vector<player_game_stats>& away_team)
+{
+    if (get_players_game_stats_binary(stats_filename, home_team, away_team))
+        return;
+
+    ifstream file(stats_filename.c_str());
+
+    if (!file)
+        die("Failed to open file %s\n", stats_filename.c_str());
+
+    int dp_for_yellow = the_config().get_int_config("DP_FOR_YELLOW", 4);
+    int dp_for_red = the_config().get_int_config("DP_FOR_RED", 10);
+    int num_subs = the_config().get_int_config("NUM_SUBS", 7);
+    int num_players = 11 + num_subs;
+    string line;
+    int team_count = 0;
+
+    while (getline(file, line))
+    {
+        if (is_stats_header_line(line))
+        {
+            ++team_count;
+            vector<player_game_stats> team;
+
+            // get the following empty line and lines with column headers
+            //
+            getline(file, line);
+            getline(file, line);
+            getline(file, line);
+
+            for (int i = 0; i < num_players; ++i)
+            {
+                getline(file, line);
+                vector<string> tokens = tokenize(line);
+
+                if (tokens.size() != 24)
+                    die("Illegal stats line in file %s:\n%s\n", stats_filename.c_str(), line.c_str());
+
+                player_game_stats player;
+                player.name = tokens[0];
+                player.pos = tokens[1];
+                player.minutes = str_atoi(tokens[9]);
+                player.games = (player.minutes > 0) ? 1 : 0;
+                player.saves = str_atoi(tokens[10]);
+                player.tackles = str_atoi(tokens[11]);
+                player.keypasses = str_atoi(tokens[12]);
+                player.assists = str_atoi(tokens[13]);
+                player.shots = str_atoi(tokens[14]);
+                player.goals = str_atoi(tokens[15]);
+                player.yellow = str_atoi(tokens[16]);
+                player.red = str_atoi(tokens[17]);
+                player.injured = str_atoi(tokens[18]);
+                player.st_ab = str_atoi(tokens[19]);
+                player.tk_ab = str_atoi(tokens[20]);
+                player.ps_ab = str_atoi(tokens[21]);
+                player.sh_ab = str_atoi(tokens[22]);
+                player.fitness = str_atoi(tokens[23]);
+                player.dp = dp_for_red * player.red + dp_for_yellow * player.yellow;
+
+                team.push_back(player);
+            }
+
+
+            if (team_count == 1)
+                home_team = team;
+            else
+                away_team = team;
+        }
+    }
+}
+
+
+bool report_line_predicate(const report_line& left, const report_line& right)
+{
+    if (left.stage != right.stage)
+        return left.stage < right.stage;
+
+    if (left.num != right.num)
+        return left.num < right.num;
+
+    return left.side < right.side;
+}
+
+
+// Handles a skill change as a result of the ability crossing a threshold
+//
+// Given:
+//   - player name, skill name (for printing to report)
+//   - ab_points, skill - the ability and skill affected. In case of a skill change,
+//     these values are modified by the function
+//   - team - where the report line goes
+//
+void handle_skill_change(string player_name, string skill_name, int& ab_points, int& skill, pipeline_team& team)
+{
+    // Increase ?
+    if (ab_points >= 1000)
+    {
+        ab_points -= 700;
+        skill++;
+        team.report(team.skill_changes, the_commentary().rand_comment(team.rng, EV_UPDTR_SKILL_INCREASE,
+                    player_name.c_str(),
+                    team.team_name.c_str(),
+                    skill_name.c_str()));
+    }
+    // Decrease ?
+    else if (ab_points < 0)
+    {
+        ab_points += 300;
+        skill--;
+        team.report(team.skill_changes, the_commentary().rand_comment(team.rng, EV_UPDTR_SKILL_DECREASE,
+                    player_name.c_str(),
+                    team.team_name.c_str(),
+                    skill_name.c_str()));
+    }
+
+    return;
+}
+
+
+bool perf_predicate(const pair<string, int>& left, const pair<string, int>& right)
+{
+    return left.second > right.second;
+}
+
+
+int calc_perf_points(int goals, int shots, int tackles, int saves, int assists, int keypasses, int dp)
+{
+    return goals * 9 + shots + tackles * 6 + saves * 3 + assists * 7 + keypasses * 4 - dp * 2;
+}
+
+
+string make_header(string header_name)
+{
+    string line(header_name.length() + 4, '-');
+    string ret = line + "\n  " + header_name + "\n" + line + "\n";
+
+    return ret;
+}
+
+
+// Reads the stats of the games in stats.dir
+//
+static void read_stats_dir(vector<stats_game>& games)
+{
+    int num_subs = the_config().get_int_config("NUM_SUBS", 7);
+    int num_players = 11 + num_subs;
+
+    ifstream dir_file("stats.dir");
+
+    if (!dir_file)
+        die("Failed to open file stats.dir\n");
+
+    string line;
+
+    // Read the stats of each line in the stats.dir file (that is, of
+    // each game to update the rosters with)
+    //
+    while (getline(dir_file, line))
+    {
+        // delete spaces
+        line.erase(remove
+                   (line.begin(), line.end(), ' '), line.end());
+
+        vector<string> parts = tokenize(line, "_");
+
+        if (parts.size() != 2)
+            die("Illegal stats file name %s in stats.dir\n", line.c_str());
+
+        stats_game game;
+        game.filename = line;
+        game.team_name[0] = parts[0];
+        game.team_name[1] = parts[1].substr(0, parts[1].find_first_of("."));
+
+        get_players_game_stats(line, game.stats[0], game.stats[1]);
+
+        if (game.stats[0].size() != unsigned(num_players))
+            die("Expected %d players of %s in stats file %s\n",
+                num_players, game.team_name[0].c_str(), line.c_str());
+
+        if (game.stats[1].size() != unsigned(num_players))
+            die("Expected %d players of %s in stats file %s\n",
+                num_players, game.team_name[1].c_str(), line.c_str());
+
+        games.push_back(game);
+    }
+}
+
+
+// Adds the round summary of the games to stats_report
+//
+void roster_pipeline::add_round_summary(const vector<stats_game>& games)
+{
+    map<string, int> weekly_stats;
+    weekly_stats["goals"] = weekly_stats["goals_DF"] = weekly_stats["goals_DM"] = weekly_stats["goals_MF"] =
+		weekly_stats["goals_AM"] = weekly_stats["goals_FW"] = weekly_stats["assists"] =
+		weekly_stats["assists_DF"] = weekly_stats["assists_DM"] = weekly_stats["assists_MF"] =
+		weekly_stats["assists_DM"] = weekly_stats["assists_FW"] = weekly_stats["yellows"] =
+		weekly_stats["reds"] = weekly_stats["injuries"] = 0;
+
+    vector<pair<string, int> > weekly_performers;
+
+    for (vector<stats_game>::const_iterator game = games.begin(); game != games.end(); ++game)
+    {
+        for (int team_n = 0; team_n <= 1; ++team_n)
+        {
+            for (unsigned player_n = 0; player_n < game->stats[team_n].size(); ++player_n)
+            {
+                const player_game_stats& player_stats = game->stats[team_n][player_n];
+
+                // Generate weekly statistics
+                //
+                weekly_stats["goals"] += player_stats.goals;
+                weekly_stats["assists"] += player_stats.assists;
+                weekly_stats["yellows"] += player_stats.yellow;
+                weekly_stats["reds"] += player_stats.red;
+                weekly_stats["injuries"] += player_stats.injured;
+
+                if (player_stats.pos != "GK")
+                {
+                    string only_position = player_stats.pos.substr(0, 2);
+
+                    weekly_stats["goals_" + only_position] += player_stats.goals;
+                    weekly_stats["assists_" + only_position] += player_stats.assists;
+                }
+
+                string name_and_team = player_stats.name + " (" + game->team_name[team_n] + ")";
+
+                int perf_points = calc_perf_points(player_stats.goals,
+                                                   player_stats.shots,
+                                                   player_stats.tackles,
+                                                   player_stats.saves,
+                                                   player_stats.assists,
+                                                   player_stats.keypasses,
+                                                   player_stats.dp);
+
+                weekly_performers.push_back(make_pair(name_and_team, perf_points));
+            }
+        }
+    }
+
+    stats_report.push_back(make_header("Round summary"));
+    stats_report.push_back(format_str("Goals:        %3d  (DFs - %d, DMs - %d, MFs - %d, AMs - %d, FWs - %d)",
+                                      weekly_stats["goals"], weekly_stats["goals_DF"],
+                                      weekly_stats["goals_DM"], weekly_stats["goals_MF"],
+                                      weekly_stats["goals_AM"], weekly_stats["goals_FW"]));
+    stats_report.push_back(format_str("Assists:      %3d  (DFs - %d, DMs - %d, MFs - %d, AMs - %d, FWs - %d)",
+                                      weekly_stats["assists"], weekly_stats["assists_DF"],
+                                      weekly_stats["assists_DM"], weekly_stats["assists_MF"],
+                                      weekly_stats["assists_AM"], weekly_stats["assists_FW"]));
+    stats_report.push_back(format_str("Yellow cards: %3d", weekly_stats["yellows"]));
+    stats_report.push_back(format_str("Red cards:    %3d", weekly_stats["reds"]));
+    stats_report.push_back(format_str("Injuries:     %3d", weekly_stats["injuries"]));
+
+    sort(weekly_performers.begin(), weekly_performers.end(), perf_predicate);
+
+    stats_report.push_back("\nTop performers:\n");
+
+    for (vector<pair<string, int> >::const_iterator it = weekly_performers.begin();
+            it != weekly_performers.end(); ++it)
+    {
+        if (it - weekly_performers.begin() > 10)
+            break;
+
+        stats_report.push_back(format_str("%-20s  %d", it->first.c_str(), it->second));
+    }
+}
+
+
+
+
+// The stats stage: applies the stats of the games of a team to its
+// roster, in the order of stats.dir
+//
+static void update_team_stats(pipeline_team& team, const vector<stats_game>& games)
+{
+    int max_inj = the_config().get_int_config("MAX_INJURY_LENGTH", 9);
+    int suspension_margin = the_config().get_int_config("SUSPENSION_MARGIN", 10);
+    RosterPlayerArray& players = team.players;
+    string team_name = team.team_name;
+
+    // The roster names are interned once, so looking the players of
+    // the games up doesn't scan the roster for each
+    //
+    name_index roster_names;
+    vector<unsigned> player_of_name = index_roster_names(players, roster_names);
+
+    for (vector<pair<unsigned, int> >::const_iterator game = team.games.begin(); game != team.games.end(); ++game)
+    {
+        const stats_game& stats_file = games[game->first];
+        const vector<player_game_stats>& stats = stats_file.stats[game->second];
+
+        team.tag.num = game->first;
+        team.tag.side = game->second;
+
+        // For each player in the stats: look it up in the roster, and
+        // update everything
+        //
+        for (unsigned player_n = 0; player_n < stats.size(); ++player_n)
+        {
+            const player_game_stats& player_stats = stats[player_n];
+            unsigned name_id = roster_names.find(player_stats.name);
+
+            if (name_id == name_index::NO_NAME)
+            {
+                team.error = format_str("Player %s (from %s) not found in roster %s.txt\n",
+                                        player_stats.name.c_str(), stats_file.filename.c_str(), team_name.c_str());
+                team.error_game_num = game->first;
+                return;
+            }
+
+            RosterPlayerIterator player = players.begin() + player_of_name[name_id];
+
+            // Add all simple stats
+            //
+            player->games += player_stats.games;
+            player->saves += player_stats.saves;
+            player->tackles += player_stats.tackles;
+            player->keypasses += player_stats.keypasses;
+            player->shots += player_stats.shots;
+            player->goals += player_stats.goals;
+            player->assists += player_stats.assists;
+            player->st_ab += player_stats.st_ab;
+            player->tk_ab += player_stats.tk_ab;
+            player->ps_ab += player_stats.ps_ab;
+            player->sh_ab += player_stats.sh_ab;
+
+            // Take care of skill increases and decreases
+            //
+            handle_skill_change(player->name, "St", player->st_ab, player->st, team);
+            handle_skill_change(player->name, "Tk", player->tk_ab, player->tk, team);
+            handle_skill_change(player->name, "Ps", player->ps_ab, player->ps, team);
+            handle_skill_change(player->name, "Sh", player->sh_ab, player->sh, team);
+
+            // Take care of DP and suspensions
+            //
+            // A suspension takes place if after the update, a player's
+            // DP crossed some factor of suspension_margin. Then, the length of
+            // the suspension is this factor.
+            //
+            // For example:
+            //
+            // A player's DP before the game was 18, and he got 3 DP during
+            // the game, and suspension_margin = 10. His total DP now is 21, so
+            // he crossed a factor (crossed = was below it prior to the update,
+            // and is above it after the update). Then, his suspension period
+            // is 2 (since it's int(DP/suspension_margin).
+            //
+            int dp_after_update = player->dp + player_stats.dp;
+
+            // Note: relying on C++'s division of integers --> integral part
+            //
+            if ((player->dp / suspension_margin) < (dp_after_update / suspension_margin))
+            {
+                player->suspension = dp_after_update / suspension_margin;
+
+                if (player->suspension == 1)
+                    team.report(team.suspensions, the_commentary().rand_comment(team.rng, EV_UPDTR_SUSPENDED_1,
+                                player->name.c_str(),
+                                team_name.c_str()));
+                else
+                    team.report(team.suspensions, the_commentary().rand_comment(team.rng, EV_UPDTR_SUSPENDED_N,
+                                player->name.c_str(),
+                                team_name.c_str(),
+                                player->suspension));
+            }
+
+            player->dp = dp_after_update;
+
+            // Take care of injuries
+            //
+            if (player_stats.injured)
+            {
+                player->injury = team.rng.below(team.rng.below(max_inj + 1) + 1);
+                string comm_line;
+
+                if (player->injury == 0)
+                    comm_line = the_commentary().rand_comment(team.rng, EV_UPDTR_INJURY_NONE,
+                                player->name.c_str(),
+                                team_name.c_str());
+                else if (player->injury == 1)
+                    comm_line = the_commentary().rand_comment(team.rng, EV_UPDTR_INJURY_1,
+                                player->name.c_str(),
+                                team_name.c_str());
+                else if (player->injury <= 4)
+                    comm_line = the_commentary().rand_comment(team.rng, EV_UPDTR_INJURY_LIGHT,
+                                player->name.c_str(),
+                                team_name.c_str(),
+                                player->injury);
+                else
+                    comm_line = the_commentary().rand_comment(team.rng, EV_UPDTR_INJURY_HARD,
+                                player->name.c_str(),
+                                team_name.c_str(),
+                                player->injury);
+
+                team.report(team.injuries, comm_line);
+            }
+
+            // Take care of fitness
+            //
+            player->fitness = player_stats.fitness;
+        }
+    }
+}
+
+
+void transformer_recover_fitness(RosterPlayer& player, pipeline_team& team, unsigned half)
+{
+	int gain = the_config().get_int_config("UPDTR_FITNESS_GAIN", 20);
+	if (half) gain /= 2;
+	
+	player.fitness += gain;
+	
+	if (player.fitness > 100)
+		player.fitness = 100;
+}
+
+
+void transformer_increase_ages(RosterPlayer& player, pipeline_team& team, unsigned)
+{
+	player.age += 1;
+}
+
+
+void transformer_reset_stats(RosterPlayer& player, pipeline_team& team, unsigned inj_sus_flag)
+{
+	player.games = player.saves = player.tackles = player.keypasses = player.shots = player.goals = player.assists = player.dp = 0;
+	player.fitness = 100;
+	
+	if (inj_sus_flag & INJURIES)
+		player.injury = 0;
+	
+	if (inj_sus_flag & SUSPENSIONS)
+		player.suspension = 0;
+}
+
+
+void transformer_decrease_sus_inj(RosterPlayer& player, pipeline_team& team, unsigned inj_sus_flag)
+{
+	if (inj_sus_flag & SUSPENSIONS)
+	{
+		// those with 0 will be decreased to -1, hence they will generate
+		// no report on "coming back".
+		//
+		player.suspension--;
+
+		if (player.suspension == 0)
+			team.report(team.suspensions, the_commentary().rand_comment(team.rng, EV_UPDTR_END_SUSPENSION,
+										player.name.c_str(),
+										team.team_name.c_str()));
+		else if (player.suspension < 0)
+			player.suspension = 0;
+	}
+
+	if (inj_sus_flag & INJURIES)
+	{
+		player.injury--;
+
+		if (player.injury == 0)
+		{
+			team.report(team.injuries, the_commentary().rand_comment(team.rng, EV_UPDTR_END_INJURY,
+									player.name.c_str(),
+									team.team_name.c_str()));
+
+			player.fitness = the_config().get_int_config("UPDTR_FITNESS_AFTER_INJURY", 80);
+		}
+		else if (player.injury < 0)
+			player.injury = 0;
+	}
+}
+
+
+void add_recover_fitness(roster_pipeline& pipeline, bool half)
+{
+    pipeline.add_player_stage(transformer_recover_fitness, half,
+                              format_str("Fitness recovered (%s%%)\n", half ? "50" : "100"));
+}
+
+
+void add_reset_stats(roster_pipeline& pipeline, unsigned inj_sus_flag)
+{
+    string done = "Stats reset\n";
+
+	if (inj_sus_flag & INJURIES)
+		done += "Injuries reset\n";
+	
+	if (inj_sus_flag & SUSPENSIONS)
+		done += "Suspensions reset\n";
+
+    pipeline.add_player_stage(transformer_reset_stats, inj_sus_flag, done);
+}
+
+
+void add_decrease_suspensions_injuries(roster_pipeline& pipeline, unsigned inj_sus_flag)
+{
+    string done;
+
+	if (inj_sus_flag & INJURIES)
+		done += "Injuries decreased\n";
+	
+	if (inj_sus_flag & SUSPENSIONS)
+		done += "Suspensions decreased\n";
+
+    pipeline.add_player_stage(transformer_decrease_sus_inj, inj_sus_flag, done);
+}
+
+
+// The leaders reports, in the order they're made
+//
+struct leaders_category
+{
+    int player_stat::* stat;
+    const char* heading;
+    const char* stat_name;
+};
+
+static const leaders_category leaders_categories[] =
+{
+    {&player_stat::goals, "Scorers", "Gls"},
+    {&player_stat::perf_points, "Performers", "Pts"},
+    {&player_stat::assists, "Assisters", "Ass"},
+    {&player_stat::dp, "Disciplinary points", "DPs"}
+};
+
+static const unsigned num_leaders_categories = sizeof(leaders_categories) / sizeof(leaders_categories[0]);
+
+// How many players each leaders report shows
+//
+static const unsigned num_leaders_shown = 15;
+
+
+bool leaderboard::better(const player_stat& left, const player_stat& right) const
+{
+    if (left.*stat != right.*stat)
+        return left.*stat > right.*stat;
+
+    if (left.games != right.games)
+        return left.games < right.games;
+
+    if (left.team_num != right.team_num)
+        return left.team_num < right.team_num;
+
+    return left.player_num < right.player_num;
+}
+
+
+// Adapts leaderboard::better to the heap algorithms
+//
+struct leaderboard_predicate
+{
+    leaderboard_predicate(const leaderboard& board_)
+        : board(board_)
+    {}
+
+    bool operator()(const player_stat& left, const player_stat& right) const
+    {
+        return board.better(left, right);
+    }
+
+    const leaderboard& board;
+};
+
+
+void leaderboard::add(const player_stat& player)
+{
+    if (heap.size() < size)
+    {
+        heap.push_back(player);
+        push_heap(heap.begin(), heap.end(), leaderboard_predicate(*this));
+    }
+    else if (size > 0 && better(player, heap.front()))
+    {
+        pop_heap(heap.begin(), heap.end(), leaderboard_predicate(*this));
+        heap.back() = player;
+        push_heap(heap.begin(), heap.end(), leaderboard_predicate(*this));
+    }
+}
+
+
+void leaderboard::merge(const leaderboard& other)
+{
+    for (vector<player_stat>::const_iterator player = other.heap.begin(); player != other.heap.end(); ++player)
+        add(*player);
+}
+
+
+vector<player_stat> leaderboard::leaders(void) const
+{
+    vector<player_stat> list = heap;
+    sort_heap(list.begin(), list.end(), leaderboard_predicate(*this));
+    return list;
+}
+
+
+void make_leaders_report(const leaderboard& board, const leaders_category& category, vector<string>& leaders_report)
+{
+    vector<player_stat> list = board.leaders();
+
+    leaders_report.push_back("\n\n" + string(category.heading) + ":");
+    leaders_report.push_back(format_str("\nName                 Games    %s\n"
+                                        "---------------------------------", category.stat_name));
+
+    for (unsigned i = 0; i < list.size(); ++i)
+    {
+        string name_and_team = list[i].name + " (" + list[i].team_name + ")";
+
+        leaders_report.push_back(format_str("%-20s %5d  %5d", name_and_team.c_str(),
+                                            list[i].games, list[i].*category.stat));
+    }
+}
+
+
+void roster_pipeline::add_player_stage(player_transformer transformer, unsigned arg, string done)
+{
+    stage s;
+    s.transformer = transformer;
+    s.arg = arg;
+    s.done = done;
+
+    stages.push_back(s);
+}
+
+
+void roster_pipeline::add_stats_stage(void)
+{
+    add_player_stage(0, 0, "");
+}
+
+
+void roster_pipeline::add_leaders(void)
+{
+    with_leaders = true;
+}
+
+
+void roster_pipeline::use_rosters(const vector<string>* team_names, map<string, RosterPlayerArray>* rosters)
+{
+    memory_team_names = team_names;
+    memory_rosters = rosters;
+}
+
+
+void roster_pipeline::use_games(const vector<stats_game>* games)
+{
+    memory_games = games;
+}
+
+
+// What the jobs of roster_pipeline::run share
+//
+struct pipeline_jobs
+{
+    const vector<pair<player_transformer, unsigned> >* stages;
+    const vector<stats_game>* games;
+    vector<pipeline_team>* teams;
+    bool with_leaders;
+
+    // Whether the jobs read and write the rosters
+    //
+    bool roster_io;
+};
+
+
+// Takes a team through the pipeline
+//
+static void run_team_pipeline(unsigned job_num, void* data)
+{
+    pipeline_jobs* jobs = (pipeline_jobs*) data;
+    pipeline_team& team = (*jobs->teams)[job_num];
+
+    if (jobs->roster_io)
+        team.read_error = read_roster_players(team.team_name + ".txt", team.players);
+
+    if (team.read_error != "")
+        return;
+
+    for (unsigned stage_num = 0; stage_num < jobs->stages->size(); ++stage_num)
+    {
+        player_transformer transformer = (*jobs->stages)[stage_num].first;
+        unsigned arg = (*jobs->stages)[stage_num].second;
+
+        team.tag.stage = stage_num;
+
+        if (!transformer)
+        {
+            update_team_stats(team, *jobs->games);
+
+            if (team.error != "")
+                return;
+        }
+        else if (team.dir_num >= 0)
+        {
+            team.tag.num = team.dir_num;
+            team.tag.side = 0;
+
+            for (RosterPlayerIterator player = team.players.begin(); player != team.players.end(); ++player)
+                transformer(*player, team, arg);
+        }
+    }
+
+    if (jobs->with_leaders && team.dir_num >= 0)
+    {
+        for (unsigned i = 0; i < num_leaders_categories; ++i)
+            team.leaders.push_back(leaderboard(leaders_categories[i].stat, num_leaders_shown));
+
+        for (RosterPlayerIterator player = team.players.begin(); player != team.players.end(); ++player)
+        {
+            int perf_points = calc_perf_points(player->goals,
+                                               player->shots,
+                                               player->tackles,
+                                               player->saves,
+                                               player->assists,
+                                               player->keypasses,
+                                               player->dp);
+
+            player_stat stat(player->name,
+                             team.team_name,
+                             player->games,
+                             player->goals,
+                             player->assists,
+                             player->dp,
+                             perf_points);
+
+            stat.team_num = team.dir_num;
+            stat.player_num = player - team.players.begin();
+
+            for (unsigned i = 0; i < num_leaders_categories; ++i)
+                team.leaders[i].add(stat);
+
+            if (is_only_whitespace(player->name))
+                team.unnamed_players++;
+        }
+    }
+}
+
+
+// Writes the roster of a team that went through the pipeline
+//
+static void write_team_roster(unsigned job_num, void* data)
+{
+    pipeline_jobs* jobs = (pipeline_jobs*) data;
+    pipeline_team& team = (*jobs->teams)[job_num];
+
+    team.write_error = write_roster_players(team.team_name + ".txt", team.players);
+}
+
+
+// Adds the lines of a report of all the teams to report, in the
+// order of the stages (see report_line)
+//
+static void merge_reports(const vector<pipeline_team>& teams, vector<report_line> pipeline_team::* team_report,
+                          vector<string>& report)
+{
+    vector<report_line> lines;
+
+    for (vector<pipeline_team>::const_iterator team = teams.begin(); team != teams.end(); ++team)
+        lines.insert(lines.end(), ((*team).*team_report).begin(), ((*team).*team_report).end());
+
+    stable_sort(lines.begin(), lines.end(), report_line_predicate);
+
+    for (vector<report_line>::const_iterator line = lines.begin(); line != lines.end(); ++line)
+        report.push_back(line->text);
+}
+
+
+void roster_pipeline::run(void)
+{
+    if (stages.empty() && !with_leaders)
+        return;
+
+    bool with_stats = false;
+    bool with_player_stages = with_leaders;
+    vector<pair<player_transformer, unsigned> > stage_procs;
+
+    for (vector<stage>::const_iterator s = stages.begin(); s != stages.end(); ++s)
+    {
+        stage_procs.push_back(make_pair(s->transformer, s->arg));
+
+        if (s->transformer)
+            with_player_stages = true;
+        else
+            with_stats = true;
+    }
+
+    // The stats of the games, and the teams: those of teams.dir (if
+    // a stage needs them) and those of the games
+    //
+    vector<stats_game> dir_games;
+    const vector<stats_game>& games = memory_games ? *memory_games : dir_games;
+
+    if (with_stats)
+    {
+        if (!memory_games)
+            read_stats_dir(dir_games);
+
+        add_round_summary(games);
+    }
+
+    map<string, pipeline_team> teams_by_name;
+    int num_dir_teams = 0;
+
+    if (with_player_stages)
+    {
+        vector<string> dir_team_names;
+
+        if (memory_team_names)
+            dir_team_names = *memory_team_names;
+        else
+        {
+            ifstream dir_file("teams.dir");
+
+            if (!dir_file)
+                die("Failed to open file teams.dir\n");
+
+            string line;
+
+            while (getline(dir_file, line))
+            {
+                // delete spaces
+                line.erase(remove(line.begin(), line.end(), ' '), line.end());
+                dir_team_names.push_back(line.substr(0, line.find_first_of(".")));
+            }
+        }
+
+        for (vector<string>::const_iterator team_name = dir_team_names.begin(); team_name != dir_team_names.end(); ++team_name)
+        {
+            pipeline_team& team = teams_by_name[*team_name];
+
+            if (team.dir_num < 0)
+                team.dir_num = num_dir_teams++;
+        }
+    }
+
+    for (unsigned game_num = 0; game_num < games.size(); ++game_num)
+        for (int side = 0; side <= 1; ++side)
+            teams_by_name[games[game_num].team_name[side]].games.push_back(make_pair(game_num, side));
+
+    // The teams are numbered in the order of their names, and each
+    // gets the child of rng with its number
+    //
+    vector<pipeline_team> teams;
+    unsigned team_num = 0;
+
+    for (map<string, pipeline_team>::iterator i = teams_by_name.begin(); i != teams_by_name.end(); ++i, ++team_num)
+    {
+        i->second.team_name = i->first;
+        i->second.rng = rng.split(team_num);
+        teams.push_back(i->second);
+    }
+
+    pipeline_jobs jobs;
+    jobs.stages = &stage_procs;
+    jobs.games = &games;
+    jobs.teams = &teams;
+    jobs.with_leaders = with_leaders;
+
+    // The rosters are read and written by the jobs too, unless they're
+    // in memory or in a league store (which is used from one thread).
+    // The rosters in memory are moved into the teams, and back when
+    // they're done.
+    //
+    jobs.roster_io = !memory_rosters && !league_store_of("");
+
+    if (memory_rosters)
+    {
+        for (vector<pipeline_team>::iterator team = teams.begin(); team != teams.end(); ++team)
+        {
+            map<string, RosterPlayerArray>::iterator roster = memory_rosters->find(team->team_name);
+
+            if (roster == memory_rosters->end())
+                team->read_error = "No roster in memory";
+            else
+                team->players.swap(roster->second);
+        }
+    }
+    else if (!jobs.roster_io)
+        for (vector<pipeline_team>::iterator team = teams.begin(); team != teams.end(); ++team)
+            team->read_error = read_roster_players(team->team_name + ".txt", team->players);
+
+    run_parallel(teams.size(), threads, run_team_pipeline, &jobs);
+
+    // The teams whose rosters couldn't be read are left out
+    //
+    for (vector<pipeline_team>::iterator team = teams.begin(); team != teams.end(); )
+    {
+        if (team->read_error != "")
+        {
+            cerr << "Error reading roster " << team->team_name << ": " << team->read_error << endl;
+            team = teams.erase(team);
+        }
+        else
+            ++team;
+    }
+
+    // Nothing is written if the stats don't match a roster (the error
+    // is that of the first game with a missing player)
+    //
+    const pipeline_team* failed = 0;
+
+    for (vector<pipeline_team>::const_iterator team = teams.begin(); team != teams.end(); ++team)
+        if (team->error != "" && (!failed || team->error_game_num < failed->error_game_num))
+            failed = &*team;
+
+    if (failed)
+        die("%s", failed->error.c_str());
+
+    if (memory_rosters)
+        for (vector<pipeline_team>::iterator team = teams.begin(); team != teams.end(); ++team)
+            team->players.swap((*memory_rosters)[team->team_name]);
+    else if (!stages.empty())
+    {
+        if (jobs.roster_io)
+            run_parallel(teams.size(), threads, write_team_roster, &jobs);
+        else
+            for (vector<pipeline_team>::iterator team = teams.begin(); team != teams.end(); ++team)
+                team->write_error = write_roster_players(team->team_name + ".txt", team->players);
+
+        for (vector<pipeline_team>::const_iterator team = teams.begin(); team != teams.end(); ++team)
+            if (team->write_error != "")
+                cerr << "Error writing roster " << team->team_name << ": " << team->write_error << endl;
+    }
+
+    merge_reports(teams, &pipeline_team::skill_changes, skill_change_report);
+    merge_reports(teams, &pipeline_team::suspensions, suspension_report);
+    merge_reports(teams, &pipeline_team::injuries, injury_report);
+
+    for (vector<stage>::const_iterator s = stages.begin(); s != stages.end() && verbose; ++s)
+    {
+        if (s->transformer)
+            cout << s->done;
+        else
+            for (vector<stats_game>::const_iterator game = games.begin(); game != games.end(); ++game)
+                cout << "Rosters updated with stats " << game->filename << endl;
+    }
+
+    if (with_leaders)
+    {
+        // The leaders of the league, from those of the teams
+        //
+        vector<leaderboard> leaders;
+        unsigned unnamed_players = 0;
+
+        for (unsigned i = 0; i < num_leaders_categories; ++i)
+            leaders.push_back(leaderboard(leaders_categories[i].stat, num_leaders_shown));
+
+        for (vector<pipeline_team>::const_iterator team = teams.begin(); team != teams.end(); ++team)
+        {
+            for (unsigned i = 0; i < team->leaders.size(); ++i)
+                leaders[i].merge(team->leaders[i]);
+
+            unnamed_players += team->unnamed_players;
+        }
+
+        for (unsigned i = 0; i < unnamed_players; ++i)
+            cout << "ALARM";
+
+        for (unsigned i = 0; i < num_leaders_categories; ++i)
+            make_leaders_report(leaders[i], leaders_categories[i], leaders_report);
+
+        if (verbose)
+            cout << "Leaders generated\n";
+    }
+}
+
+
+void roster_pipeline::print_summary(ofstream& out, const vector<string>& table_report) const
+{
+    if (!injury_report.empty())
+        print_elements(out, injury_report, "\n", "\n\nInjuries:\n---------\n\n");
+
+    if (!suspension_report.empty())
+        print_elements(out, suspension_report, "\n", "\n\nSuspensions:\n------------\n\n");
+
+    if (!skill_change_report.empty())
+        print_elements(out, skill_change_report, "\n", "\n\nSkill changes:\n--------------\n\n");
+
+    if (!stats_report.empty())
+        print_elements(out, stats_report, "\n", "\n\n");
+
+    if (!table_report.empty())
+        print_elements(out, table_report, "\n", "\n\nTable:\n------\n\n");
+
+    if (!leaders_report.empty())
+        print_elements(out, leaders_report, "\n");
+}
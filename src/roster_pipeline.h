@@ -0,0 +1,327 @@
+// ESMS - Electronic Soccer Management Simulator
+// Copyright (C) <1998-2005>  Eli Bendersky
+//
+// This program is free software, licensed with the GPL (www.fsf.org)
+//
+#ifndef ROSTER_PIPELINE_H
+#define ROSTER_PIPELINE_H
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <map>
+#include <fstream>
+#include <vector>
+#include <string>
+#include "rosterplayer.h"
+#include "rng.h"
+#include "match_events.h"
+
+using namespace std;
+
+
+// For stats
+//
+struct player_game_stats
+{
+    string name;
+    string pos;
+
+    int minutes;
+    int games;
+    int shots;
+    int goals;
+    int saves;
+    int tackles;
+    int keypasses;
+    int assists;
+    int yellow;
+    int red;
+    int dp;
+    int injured;
+    int suspended;
+    int st_ab;
+    int tk_ab;
+    int ps_ab;
+    int sh_ab;
+    int fitness;
+};
+
+
+// A game of stats.dir (or one played in memory), with the stats of
+// the players of both teams
+//
+struct stats_game
+{
+    string filename;
+    string team_name[2];
+    vector<player_game_stats> stats[2];
+};
+
+
+// for leaders generation
+//
+struct player_stat
+{
+    player_stat(string name_, string team_name_, int games_, int goals_,
+                int assists_, int dp_, int perf_points_)
+            :
+            name(name_), team_name(team_name_), games(games_), goals(goals_),
+            assists(assists_), dp(dp_), perf_points(perf_points_),
+            team_num(0), player_num(0)
+    {}
+
+    string name;
+    string team_name;
+    int games;
+    int goals;
+    int assists;
+    int dp;
+    int perf_points;
+
+    // Where the player is: the number of his team in teams.dir, and
+    // his place in its roster
+    //
+    unsigned team_num;
+    unsigned player_num;
+};
+
+
+// The leaders of a stat - the best players by it, with fewer games
+// first among players with the same stat (and then the order of
+// teams.dir and of the rosters). Only the leaders are kept, so adding
+// a player costs the log of their number, and leaderboards of parts of
+// the league (like a team) are merged into that of the league.
+//
+// The leaderboards are made again on each run, and aren't kept between
+// runs: every updtr option that makes them also recovers the fitness
+// of all the teams, so each roster is in memory anyway, and the
+// leaders of a team in the four reports are most of its players. A
+// cache of the leaderboards of each team, checked against its roster
+// like the roster cache, was tried: reading and writing it took twice
+// as long as making the leaderboards. It's worth having only if a run
+// makes the leaders without reading all the rosters.
+//
+class leaderboard
+{
+public:
+    leaderboard(int player_stat::* stat_, unsigned size_)
+        : stat(stat_), size(size_)
+    {}
+
+    void add(const player_stat& player);
+    void merge(const leaderboard& other);
+
+    // The leaders, best first
+    //
+    vector<player_stat> leaders(void) const;
+
+    // Whether left is placed before right
+    //
+    bool better(const player_stat& left, const player_stat& right) const;
+
+private:
+    int player_stat::* stat;
+    unsigned size;
+
+    // A heap with the worst of the leaders on top
+    //
+    vector<player_stat> heap;
+};
+
+
+// A line of one of the reports of the roster pipeline, tagged with
+// where it comes from: the stage that made it, and the game (its
+// number in stats.dir) and the side (0 - home, 1 - away) for the
+// stats stage, or the number of the team in teams.dir for the
+// others. The teams go through the pipeline in parallel, and then
+// their lines are put in the order they'd have if the stages ran
+// one after another over all the rosters.
+//
+struct report_line
+{
+    unsigned stage;
+    unsigned num;
+    int side;
+    string text;
+};
+
+
+// A team going through the roster pipeline
+//
+struct pipeline_team
+{
+    pipeline_team()
+        : dir_num(-1), unnamed_players(0), error_game_num(0)
+    {}
+
+    // Adds a line to a report, with the tag of what's done now
+    //
+    void report(vector<report_line>& lines, string text)
+    {
+        tag.text = text;
+        lines.push_back(tag);
+    }
+
+    string team_name;
+
+    // The number of the team in teams.dir, or -1 if it's only in
+    // stats.dir (then only the stats stage updates it)
+    //
+    int dir_num;
+
+    RosterPlayerArray players;
+
+    // The games of the team in stats.dir (their numbers, and its side
+    // in each)
+    //
+    vector<pair<unsigned, int> > games;
+
+    // The random numbers of the team (injuries and the choice of the
+    // report lines) come from a stream of its own, so they don't
+    // depend on the thread that updates it
+    //
+    rng_stream rng;
+
+    report_line tag;
+    vector<report_line> skill_changes;
+    vector<report_line> suspensions;
+    vector<report_line> injuries;
+
+    // The leaders of the team (one leaderboard for each of the
+    // leaders reports), and how many of its players have no name
+    //
+    vector<leaderboard> leaders;
+    unsigned unnamed_players;
+
+    // Set (with the game it comes from) if a player of the stats
+    // isn't in the roster
+    //
+    string error;
+    unsigned error_game_num;
+
+    string read_error;
+    string write_error;
+};
+
+
+// A stage of the pipeline that transforms each player of a team
+// (arg is given to add_player_stage)
+//
+typedef void (*player_transformer)(RosterPlayer& player, pipeline_team& team, unsigned arg);
+
+
+// The roster pipeline - the updates of the rosters, done in one
+// pass. Each roster is read once, goes through all the stages in
+// the order they were added, is written once and then, with
+// add_leaders, is added to the leaders. The teams go through it in
+// parallel.
+//
+// The rosters are those of teams.dir and the stats those of the
+// games in stats.dir, unless the pipeline is given rosters and games
+// in memory (as esms_season does).
+//
+class roster_pipeline
+{
+public:
+    roster_pipeline()
+        : threads(1), verbose(true), with_leaders(false), memory_team_names(0), memory_rosters(0), memory_games(0)
+    {}
+
+    // Adds a stage that transforms each player of the teams in
+    // teams.dir. done is printed when the pipeline is done.
+    //
+    void add_player_stage(player_transformer transformer, unsigned arg, string done);
+
+    // Adds the update of the rosters with the stats of the games in
+    // stats.dir
+    //
+    void add_stats_stage(void);
+
+    // Makes the leaders of the teams in teams.dir (from the rosters
+    // after all the stages)
+    //
+    void add_leaders(void);
+
+    // Updates rosters in memory instead of the roster files: the teams
+    // (which take the place of teams.dir) and their rosters, by team
+    // name. The rosters are updated in place, and nothing is read or
+    // written. The pipeline keeps the pointers until run.
+    //
+    void use_rosters(const vector<string>* team_names, map<string, RosterPlayerArray>* rosters);
+
+    // The stats stage updates the rosters with these games instead of
+    // those of stats.dir. The pipeline keeps the pointer until run.
+    //
+    void use_games(const vector<stats_game>* games);
+
+    void run(void);
+
+    // Prints the reports to a summary file (like updtr_summary.txt),
+    // with the table (which isn't updated by the pipeline) after the
+    // round summary
+    //
+    void print_summary(ofstream& out, const vector<string>& table_report) const;
+
+    // The random stream of the pipeline (injuries and the choice of
+    // the report lines), the amount of threads the teams go through
+    // it on, and whether run prints what was done
+    //
+    rng_stream rng;
+    unsigned threads;
+    bool verbose;
+
+    // The reports, filled in by run
+    //
+    vector<string> skill_change_report;
+    vector<string> injury_report;
+    vector<string> suspension_report;
+    vector<string> stats_report;
+    vector<string> leaders_report;
+
+private:
+    struct stage
+    {
+        // 0 for the stats stage
+        //
+        player_transformer transformer;
+        unsigned arg;
+        string done;
+    };
+
+    void add_round_summary(const vector<stats_game>& games);
+
+    vector<stage> stages;
+    bool with_leaders;
+
+    const vector<string>* memory_team_names;
+    map<string, RosterPlayerArray>* memory_rosters;
+    const vector<stats_game>* memory_games;
+};
+
+
+void transformer_recover_fitness(RosterPlayer& player, pipeline_team& team, unsigned half);
+void transformer_increase_ages(RosterPlayer& player, pipeline_team& team, unsigned);
+void transformer_reset_stats(RosterPlayer& player, pipeline_team& team, unsigned inj_sus_flag);
+void transformer_decrease_sus_inj(RosterPlayer& player, pipeline_team& team, unsigned inj_sus_flag);
+
+// Add the updates of the rosters to a pipeline
+//
+void add_recover_fitness(roster_pipeline& pipeline, bool half);
+void add_reset_stats(roster_pipeline& pipeline, unsigned inj_sus_flag);
+void add_decrease_suspensions_injuries(roster_pipeline& pipeline, unsigned inj_sus_flag);
+
+void get_players_game_stats(string stats_filename, vector<player_game_stats>& home_team,
+                            vector<player_game_stats>& away_team);
+
+// The stats of a team in a game, from its final stats (stats[0] is
+// unused - see match_record)
+//
+void match_stats_to_game_stats(const vector<match_player_stats>& stats, vector<player_game_stats>& team);
+
+const unsigned SUSPENSIONS = 1;
+const unsigned INJURIES = 2;
+
+
+#endif // ROSTER_PIPELINE_H
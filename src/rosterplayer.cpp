@@ -7,18 +7,220 @@
 #include <cstdlib>
 #include <cstring>
 #include <fstream>
+#include <sstream>
+
+#ifdef WIN32
+#include <process.h>
+#else
+#include <unistd.h>
+#endif
 
 #include "rosterplayer.h"
+#include "binary_file.h"
+#include "league_store.h"
 #include "util.h"
 
 
-string read_roster_players(string roster_filename, RosterPlayerArray& players_arr)
+// A roster in binary form (see encode_roster_players) - the form
+// of the roster cache and of the rosters in a league store.
+//
+// The format (all the numbers are little-endian u32, or i32):
+//
+// the number of players and the size of the string table
+// for each player: ROSTER_BINARY_FIELDS numbers - the offsets of his
+//   name, nationality and preferred side in the string table, and
+//   the numbers of the roster columns, in order
+// the string table - NUL-terminated strings, each stored once
+//
+static const unsigned ROSTER_BINARY_FIELDS = 25;
+
+
+// The numeric columns of the roster, in order
+//
+static int RosterPlayer::* const roster_int_fields[ROSTER_BINARY_FIELDS - 3] =
 {
-    ifstream rosterfile(roster_filename.c_str());
+    &RosterPlayer::age, &RosterPlayer::st, &RosterPlayer::tk, &RosterPlayer::ps,
+    &RosterPlayer::sh, &RosterPlayer::stamina, &RosterPlayer::ag, &RosterPlayer::st_ab,
+    &RosterPlayer::tk_ab, &RosterPlayer::ps_ab, &RosterPlayer::sh_ab, &RosterPlayer::games,
+    &RosterPlayer::saves, &RosterPlayer::tackles, &RosterPlayer::keypasses, &RosterPlayer::shots,
+    &RosterPlayer::goals, &RosterPlayer::assists, &RosterPlayer::dp, &RosterPlayer::injury,
+    &RosterPlayer::suspension, &RosterPlayer::fitness
+};
 
-    if (!rosterfile)
-        return format_str("Failed to open roster %s", roster_filename.c_str());
 
+string encode_roster_players(RosterPlayerConstIterator begin, RosterPlayerConstIterator end)
+{
+    string_table strings;
+    string records;
+
+    for (RosterPlayerConstIterator player = begin; player != end; ++player)
+    {
+        put_u32(records, strings.intern(player->name));
+        put_u32(records, strings.intern(player->nationality));
+        put_u32(records, strings.intern(player->pref_side));
+
+        for (unsigned f = 0; f < ROSTER_BINARY_FIELDS - 3; ++f)
+            put_u32(records, (*player).*roster_int_fields[f]);
+    }
+
+    string out;
+    put_u32(out, end - begin);
+    put_u32(out, strings.table.size());
+
+    out += records;
+    out += strings.table;
+
+    return out;
+}
+
+
+bool decode_roster_players(const unsigned char* data, size_t size, RosterPlayerArray& players_arr)
+{
+    if (size < 8)
+        return false;
+
+    unsigned num_players = load_u32(data);
+    unsigned table_size = load_u32(data + 4);
+
+    if (num_players > size || table_size > size
+            || 8 + (size_t) num_players * ROSTER_BINARY_FIELDS * 4 + table_size != size)
+        return false;
+
+    const unsigned char* records = data + 8;
+    const char* table = (const char*) records + num_players * ROSTER_BINARY_FIELDS * 4;
+
+    if (table_size > 0 && table[table_size - 1] != '\0')
+        return false;
+
+    size_t first = players_arr.size();
+    players_arr.resize(first + num_players);
+
+    for (unsigned i = 0; i < num_players; ++i)
+    {
+        const unsigned char* rec = records + i * ROSTER_BINARY_FIELDS * 4;
+        RosterPlayer& player = players_arr[first + i];
+
+        if (load_u32(rec) >= table_size || load_u32(rec + 4) >= table_size || load_u32(rec + 8) >= table_size)
+        {
+            players_arr.resize(first);
+            return false;
+        }
+
+        player.name = table + load_u32(rec);
+        player.nationality = table + load_u32(rec + 4);
+        player.pref_side = table + load_u32(rec + 8);
+
+        for (unsigned f = 0; f < ROSTER_BINARY_FIELDS - 3; ++f)
+            player.*roster_int_fields[f] = (int) load_u32(rec + 12 + 4 * f);
+    }
+
+    return true;
+}
+
+
+// The roster cache - a binary copy of a roster, kept next to it in
+// <roster>.cache, that is read instead of the roster as long as the
+// roster is the text the cache was made from. The roster stays the
+// real thing: when it's edited by hand, the cache is just remade the
+// next time it's read.
+//
+// The rows of a roster have a fixed width, so an edit usually keeps
+// its size, and its modification time can't tell it either (a roster
+// edited right after updtr wrote it and its cache can be left with
+// the time it had, to the nanosecond). So the cache keeps a hash of
+// the text of the roster, which is checked on each read: hashing the
+// roster is a small part of the cost of parsing it.
+//
+// The format (all the numbers are little-endian u32):
+//
+// "ESMSRST" and a version byte (ROSTER_CACHE_VERSION)
+// the size of the roster, and the FNV-1a hash of its text
+// the players of the roster in binary form
+//
+static const char ROSTER_CACHE_MAGIC[] = "ESMSRST";
+static const unsigned char ROSTER_CACHE_VERSION = 4;
+static const unsigned ROSTER_CACHE_HEADER_SIZE = 16;
+
+
+static string roster_cache_name(string roster_filename)
+{
+    return roster_filename + ".cache";
+}
+
+
+// Reads the players of the cache of a roster whose text is given.
+// Returns false if there's no cache, or if it's not of this text of
+// the roster (or is broken).
+//
+static bool read_roster_cache(string roster_filename, const mapped_file& roster,
+                              RosterPlayerArray& players_arr)
+{
+    mapped_file file;
+
+    if (!file.map_file(roster_cache_name(roster_filename)))
+        return false;
+
+    const unsigned char* data = file.data;
+
+    if (file.size < ROSTER_CACHE_HEADER_SIZE
+            || memcmp(data, ROSTER_CACHE_MAGIC, strlen(ROSTER_CACHE_MAGIC)) != 0
+            || data[7] != ROSTER_CACHE_VERSION)
+        return false;
+
+    if (load_u32(data + 8) != (unsigned) roster.size
+            || load_u32(data + 12) != fnv1a_hash(roster.data, roster.size))
+        return false;
+
+    return decode_roster_players(data + ROSTER_CACHE_HEADER_SIZE,
+                                 file.size - ROSTER_CACHE_HEADER_SIZE, players_arr);
+}
+
+
+// Writes the cache of a roster, made from the roster as it is in its
+// file now. The cache is an optimization only, so failing to write it
+// isn't an error.
+//
+// The cache is written to a temporary file that's then renamed, so
+// a process reading the roster at the same time sees either the old
+// cache or the new one.
+//
+static void write_roster_cache(string roster_filename, const mapped_file& roster,
+                               RosterPlayerConstIterator begin, RosterPlayerConstIterator end)
+{
+    string out(ROSTER_CACHE_MAGIC);
+    put_u8(out, ROSTER_CACHE_VERSION);
+    put_u32(out, roster.size);
+    put_u32(out, fnv1a_hash(roster.data, roster.size));
+
+    out += encode_roster_players(begin, end);
+
+    string cache_name = roster_cache_name(roster_filename);
+    string temp_name = format_str("%s.%d", cache_name.c_str(), (int) getpid());
+
+    FILE* file = fopen(temp_name.c_str(), "wb");
+
+    if (!file)
+        return;
+
+    bool ok = fwrite(out.data(), 1, out.size(), file) == out.size();
+    ok = fclose(file) == 0 && ok;
+
+#ifdef WIN32
+    // (rename doesn't replace an existing file on Windows)
+    //
+    remove(cache_name.c_str());
+#endif
+
+    if (!ok || rename(temp_name.c_str(), cache_name.c_str()) != 0)
+        remove(temp_name.c_str());
+}
+
+
+// Reads the players of a roster from its text (roster_filename is
+// for the error messages)
+//
+static string parse_roster(istream& rosterfile, string roster_filename, RosterPlayerArray& players_arr)
+{
     string line;
 
     // two dummy reads, to read in the header
@@ -86,20 +288,68 @@ string read_roster_players(string roster_filename, RosterPlayerArray& players_ar
 }
 
 
+string read_roster_players(string roster_filename, RosterPlayerArray& players_arr)
+{
+    league_store* store = league_store_of(league_file_dir(roster_filename));
+
+    if (store)
+        return store->read_roster(league_file_key(roster_filename), players_arr);
+
+    return read_roster_file(roster_filename, players_arr);
+}
+
 
 string write_roster_players(string roster_filename, const RosterPlayerArray& players_arr)
+{
+    league_store* store = league_store_of(league_file_dir(roster_filename));
+
+    if (store)
+        return store->write_roster(league_file_key(roster_filename), players_arr);
+
+    return write_roster_file(roster_filename, players_arr);
+}
+
+
+string read_roster_file(string roster_filename, RosterPlayerArray& players_arr)
+{
+    mapped_file roster;
+
+    if (!roster.map_file(roster_filename))
+        return format_str("Failed to open roster %s", roster_filename.c_str());
+
+    if (read_roster_cache(roster_filename, roster, players_arr))
+        return "";
+
+    istringstream rosterfile(roster.size > 0 ? string((const char*) roster.data, roster.size) : string());
+
+    size_t first = players_arr.size();
+    string msg = parse_roster(rosterfile, roster_filename, players_arr);
+
+    if (msg == "")
+        write_roster_cache(roster_filename, roster, players_arr.begin() + first, players_arr.end());
+
+    return msg;
+}
+
+
+string write_roster_file(string roster_filename, const RosterPlayerArray& players_arr)
 {
     ofstream rosterfile(roster_filename.c_str());
 
     if (!rosterfile)
         return format_str("Failed to open roster %s", roster_filename.c_str());
 
-    rosterfile << "Name         Age Nat Prs St Tk Ps Sh Sm Ag KAb TAb PAb SAb Gam Sav Ktk Kps Sht Gls Ass  DP Inj Sus Fit\n";
-    rosterfile << "------------------------------------------------------------------------------------------------------\n";
+    // The roster is put together in memory, so the cache can be made
+    // from the text as it will be read back
+    //
+    ostringstream roster_text;
+
+    roster_text << "Name         Age Nat Prs St Tk Ps Sh Sm Ag KAb TAb PAb SAb Gam Sav Ktk Kps Sht Gls Ass  DP Inj Sus Fit\n";
+    roster_text << "------------------------------------------------------------------------------------------------------\n";
 
     for (RosterPlayerConstIterator player = players_arr.begin(); player != players_arr.end(); ++player)
     {
-        rosterfile << format_str("%-13s%3d%4s%4s%3d%3d%3d%3d%3d%3d%4d%4d%4d%4d%4d%4d%4d%4d%4d%4d%4d%4d%4d%4d%4d\n",
+        roster_text << format_str("%-13s%3d%4s%4s%3d%3d%3d%3d%3d%3d%4d%4d%4d%4d%4d%4d%4d%4d%4d%4d%4d%4d%4d%4d%4d\n",
                 player->name.c_str(),
                 player->age,
                 player->nationality.c_str(),
@@ -127,8 +377,38 @@ string write_roster_players(string roster_filename, const RosterPlayerArray& pla
                 player->fitness);
     }
 
-    rosterfile << endl;
-	return "";
+    roster_text << endl;
+
+    rosterfile << roster_text.str();
+    rosterfile.close();
+
+    if (!rosterfile)
+        return format_str("Failed to write roster %s", roster_filename.c_str());
+
+    // The cache is of the roster as it's in the file (whatever the
+    // line ends are there)
+    //
+    mapped_file written_file;
+    istringstream written(roster_text.str());
+    RosterPlayerArray written_players;
+
+    if (written_file.map_file(roster_filename)
+            && parse_roster(written, roster_filename, written_players) == "")
+        write_roster_cache(roster_filename, written_file, written_players.begin(), written_players.end());
+
+    return "";
 }
 
 
+vector<unsigned> index_roster_names(const RosterPlayerArray& players_arr, name_index& names)
+{
+    vector<unsigned> player_of_name;
+
+    for (unsigned i = 0; i < players_arr.size(); ++i)
+    {
+        if (names.intern(players_arr[i].name) == player_of_name.size())
+            player_of_name.push_back(i);
+    }
+
+    return player_of_name;
+}
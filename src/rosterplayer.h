@@ -6,8 +6,10 @@
 #ifndef ROSTERPLAYER_H_DEFINED
 #define ROSTERPLAYER_H_DEFINED
 
+#include <cstddef>
 #include <string>
 #include <vector>
+#include "name_index.h"
 using namespace std;
 
 
@@ -56,15 +58,36 @@ typedef vector<RosterPlayer>::const_iterator RosterPlayerConstIterator;
 
 /// Reads a roster into the vector of RosterPlayers. Uses push_back on the vector, without
 /// clearing it.
+/// If the directory of the roster has a league store (see league_store.h), the roster
+/// is read from the store - <dir>/<team>.txt is the roster of team in it.
 /// Returns "" on success, and an error message if something went wrong.
 ///
 string read_roster_players(string roster_filename, RosterPlayerArray& players_arr);
 
-/// Writes a vector of RosterPlayers into a roster.
+/// Writes a vector of RosterPlayers into a roster (in the league store of its directory,
+/// if there's one, like read_roster_players).
 /// Returns "" on success, and an error message if something went wrong.
 ///
 string write_roster_players(string roster_filename, const RosterPlayerArray& players_arr);
 
+/// The same, but always with the roster text file (and its cache), even if there's a
+/// league store - for importing rosters into the store and exporting them from it.
+///
+string read_roster_file(string roster_filename, RosterPlayerArray& players_arr);
+string write_roster_file(string roster_filename, const RosterPlayerArray& players_arr);
+
+/// Interns the names of the players into names, and returns the number (the place in
+/// players_arr) of the first player with each name, by the id of the name.
+///
+vector<unsigned> index_roster_names(const RosterPlayerArray& players_arr, name_index& names);
+
+/// A roster in binary form (see rosterplayer.cpp for the format), as kept in the
+/// roster cache and in the league store. decode_roster_players uses push_back like
+/// read_roster_players, and returns false if the data is broken.
+///
+string encode_roster_players(RosterPlayerConstIterator begin, RosterPlayerConstIterator end);
+bool decode_roster_players(const unsigned char* data, size_t size, RosterPlayerArray& players_arr);
+
 
 
 #endif // ROSTERPLAYER_H_DEFINED
@@ -0,0 +1,174 @@
+// ESMS - Electronic Soccer Management Simulator
+// Copyright (C) <1998-2005>  Eli Bendersky
+//
+// This program is free software, licensed with the GPL (www.fsf.org)
+//
+#include <algorithm>
+#include <fstream>
+
+#include "season.h"
+#include "auto_teamsheet.h"
+#include "config.h"
+#include "thread_pool.h"
+#include "util.h"
+
+
+season::season()
+    : dfs(4), mfs(4), fws(2), tactic('N'), threads(1), with_commentary(false), with_leaders(false),
+      num_games(0)
+{
+    num_subs = the_config().get_int_config("NUM_SUBS", 7);
+    table.set_tie_breaks(the_config().get_config_value("TABLE_TIE_BREAKS"));
+}
+
+
+season::~season()
+{
+    for (vector<season_game>::iterator game = games.begin(); game != games.end(); ++game)
+    {
+        delete game->comm_sink;
+        delete game->ctx;
+    }
+}
+
+
+string season::read_league(string work_dir)
+{
+    ifstream dir_file((work_dir + "teams.dir").c_str());
+
+    if (!dir_file)
+        return "Failed to open file " + work_dir + "teams.dir";
+
+    string line;
+
+    while (getline(dir_file, line))
+    {
+        // delete spaces
+        line.erase(remove(line.begin(), line.end(), ' '), line.end());
+
+        if (is_only_whitespace(line))
+            continue;
+
+        string team_name = line.substr(0, line.find_first_of("."));
+        string msg = read_roster_players(work_dir + team_name + ".txt", rosters[team_name]);
+
+        if (msg != "")
+            return msg;
+
+        team_names.push_back(team_name);
+    }
+
+    return "";
+}
+
+
+static void play_season_game(unsigned game_num, void* data)
+{
+    season_game* game = &((season_game*) data)[game_num];
+
+    game->error = simulate_match(*game->ctx, game->inputs);
+}
+
+
+string season::play_week(const week_fixtures& fixtures, unsigned seed, int week)
+{
+    num_games = fixtures.size();
+
+    while (games.size() < num_games)
+    {
+        games.push_back(season_game());
+        games.back().ctx = new match_context;
+    }
+
+    // The teamsheets of the teams, made from their rosters as they're
+    // after last week
+    //
+    for (unsigned i = 0; i < num_games; ++i)
+    {
+        season_game& game = games[i];
+
+        game.home = team_abbreviation(fixtures[i].first);
+        game.away = team_abbreviation(fixtures[i].second);
+
+        string team[2] = {game.home, game.away};
+
+        for (int j = 0; j <= 1; ++j)
+        {
+            map<string, RosterPlayerArray>::const_iterator roster = rosters.find(team[j]);
+
+            if (roster == rosters.end())
+                return format_str("Week %d: no roster of %s", week, team[j].c_str());
+
+            string teamsheet;
+            string msg = make_teamsheet(team[j], roster->second, dfs, mfs, fws, tactic, num_subs, teamsheet);
+
+            if (msg != "")
+                return format_str("Week %d: %s", week, msg.c_str());
+
+            game.inputs.teamsheet[j].read_teamsheet_text(teamsheet);
+            game.inputs.teamsheet[j].grab_line();
+            game.inputs.team_name[j] = team[j];
+            game.inputs.roster[j] = roster->second;
+        }
+
+        game.inputs.rng = rng_stream(seed, week, i + 1);
+
+        delete game.comm_sink;
+        game.comm_sink = with_commentary ? new memory_commentary_sink : 0;
+        game.inputs.comm = game.comm_sink;
+    }
+
+    run_parallel(num_games, threads, play_season_game, &games[0]);
+
+    for (unsigned i = 0; i < num_games; ++i)
+        if (games[i].error != "")
+            return format_str("Week %d, %s - %s: %s", week, games[i].home.c_str(), games[i].away.c_str(),
+                              games[i].error.c_str());
+
+    // The results go to the table, and the stats of the games to the
+    // rosters
+    //
+    vector<stats_game> stats_games(num_games);
+
+    for (unsigned i = 0; i < num_games; ++i)
+    {
+        match_context* ctx = games[i].ctx;
+
+        table.add_game_result(ctx->team[0].fullname, ctx->team[0].score,
+                              ctx->team[1].score, ctx->team[1].fullname);
+
+        vector<match_player_stats> stats[2];
+        ctx->fill_final_stats(stats);
+
+        for (int j = 0; j <= 1; ++j)
+        {
+            stats_games[i].team_name[j] = ctx->team[j].name;
+            match_stats_to_game_stats(stats[j], stats_games[i].stats[j]);
+        }
+
+        stats_games[i].filename = stats_games[i].team_name[0] + "_" + stats_games[i].team_name[1] + ".txt";
+    }
+
+    updates = roster_pipeline();
+    updates.rng = rng_stream(seed, week, 0);
+    updates.threads = threads;
+    updates.verbose = false;
+    updates.use_rosters(&team_names, &rosters);
+    updates.use_games(&stats_games);
+
+    add_decrease_suspensions_injuries(updates, SUSPENSIONS | INJURIES);
+    updates.add_stats_stage();
+    add_recover_fitness(updates, false);
+
+    if (with_leaders)
+        updates.add_leaders();
+
+    updates.run();
+
+    // The pipeline keeps pointers only until it runs
+    //
+    updates.use_rosters(0, 0);
+    updates.use_games(0);
+
+    return "";
+}
@@ -0,0 +1,121 @@
+// ESMS - Electronic Soccer Management Simulator
+// Copyright (C) <1998-2005>  Eli Bendersky
+//
+// This program is free software, licensed with the GPL (www.fsf.org)
+//
+#ifndef SEASON_H
+#define SEASON_H
+
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "game.h"
+#include "fixture_list.h"
+#include "league_table.h"
+#include "roster_pipeline.h"
+#include "rosterplayer.h"
+
+
+using namespace std;
+
+
+// A game of a week of the season
+//
+struct season_game
+{
+    season_game()
+        : comm_sink(0), ctx(0)
+    {}
+
+    // The abbreviations of the teams
+    //
+    string home, away;
+
+    match_inputs inputs;
+    memory_commentary_sink* comm_sink;
+    match_context* ctx;
+    string error;
+};
+
+
+// A season played in memory, week after week: the rosters of the
+// teams and the league table are kept in memory, and each week the
+// games are played on a pool of threads, with teamsheets made like
+// tsc makes them, and then the rosters go through the updates of
+// updtr 8 (suspensions and injuries decreased, the stats of the games
+// added and full fitness recovery) and the results are added to the
+// table.
+//
+// Nothing is read or written by the season after read_league - what
+// the games and the updates leave (the match contexts, commentaries
+// and reports) is there to be written by the caller after each week.
+//
+// A season is made after league.dat, tactics.dat and language.dat
+// are loaded (it takes NUM_SUBS and TABLE_TIE_BREAKS from league.dat).
+// The contexts of the games belong to the season, so it can't be
+// copied - a copy of the league is made by copying team_names,
+// rosters and table.
+//
+class season
+{
+public:
+    season();
+    ~season();
+
+    // Reads the teams of teams.dir and their rosters from work_dir
+    // (or its league store). Returns "" on success, and an error
+    // message if something went wrong.
+    //
+    string read_league(string work_dir);
+
+    // Plays the games of a week, and updates the rosters and the
+    // table. The random stream of game i (from 0) is that of league
+    // seed, week and fixture i + 1, like in esms_round, and the
+    // updates of the rosters use that of fixture 0. Returns "" on
+    // success, and an error message (with nothing updated) if a team
+    // has no roster, or can't field a team, or if a game can't be
+    // played.
+    //
+    string play_week(const week_fixtures& fixtures, unsigned seed, int week);
+
+    // The teams (in the order of teams.dir), their rosters, by their
+    // names, and the table
+    //
+    vector<string> team_names;
+    map<string, RosterPlayerArray> rosters;
+    league_table table;
+
+    // The formation and tactic of the teamsheets, and the amount of
+    // subs on them (NUM_SUBS of league.dat by default)
+    //
+    int dfs, mfs, fws;
+    char tactic;
+    int num_subs;
+
+    // The amount of threads the games of a week and the updates of
+    // the rosters run on
+    //
+    unsigned threads;
+
+    // Whether the games have commentaries, and the updates leaders
+    // reports
+    //
+    bool with_commentary;
+    bool with_leaders;
+
+    // The games of the last week played (the first num_games), and
+    // the roster updates made after them, with their reports
+    //
+    vector<season_game> games;
+    unsigned num_games;
+    roster_pipeline updates;
+
+private:
+    season(const season& rhs);
+    season& operator= (const season& rhs);
+};
+
+
+#endif // SEASON_H
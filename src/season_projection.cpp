@@ -0,0 +1,217 @@
+// ESMS - Electronic Soccer Management Simulator
+// Copyright (C) <1998-2005>  Eli Bendersky
+//
+// This program is free software, licensed with the GPL (www.fsf.org)
+//
+#include "season_projection.h"
+#include "thread_pool.h"
+
+#include <algorithm>
+
+
+// The seasons are split into jobs of JOB_SIZE seasons, each played
+// by one season object
+//
+const unsigned JOB_SIZE = 16;
+
+
+unsigned season_projection::team_num(string team_name)
+{
+    for (unsigned i = 0; i < team_names.size(); ++i)
+        if (team_names[i] == team_name)
+            return i;
+
+    team_names.push_back(team_name);
+    finishes.push_back(vector<unsigned>());
+    points.push_back(0);
+
+    return team_names.size() - 1;
+}
+
+
+void season_projection::add(const season_projection& other)
+{
+    num_seasons += other.num_seasons;
+
+    for (unsigned i = 0; i < other.team_names.size(); ++i)
+    {
+        unsigned t = team_num(other.team_names[i]);
+
+        if (finishes[t].size() < other.finishes[i].size())
+            finishes[t].resize(other.finishes[i].size());
+
+        for (unsigned p = 0; p < other.finishes[i].size(); ++p)
+            finishes[t][p] += other.finishes[i][p];
+
+        points[t] += other.points[i];
+    }
+}
+
+
+// What the jobs of run_season_projection share
+//
+struct projection_jobs
+{
+    const season* start;
+    const map<int, week_fixtures>* weeks;
+    unsigned random_seed;
+    unsigned num_seasons;
+
+    // The seasons of each job, and the error that stopped it
+    //
+    vector<season_projection> results;
+    vector<string> errors;
+};
+
+
+static void run_projection_job(unsigned job_num, void* data)
+{
+    projection_jobs* jobs = (projection_jobs*) data;
+    const season& start = *jobs->start;
+    season_projection& result = jobs->results[job_num];
+
+    unsigned first = job_num * JOB_SIZE;
+    unsigned last = min(first + JOB_SIZE, jobs->num_seasons);
+
+    season league;
+    league.dfs = start.dfs;
+    league.mfs = start.mfs;
+    league.fws = start.fws;
+    league.tactic = start.tactic;
+    league.num_subs = start.num_subs;
+
+    rng_stream seeds(jobs->random_seed);
+
+    for (unsigned i = first; i < last; ++i)
+    {
+        league.team_names = start.team_names;
+        league.rosters = start.rosters;
+        league.table = start.table;
+
+        unsigned seed = seeds.split(i).next();
+
+        for (map<int, week_fixtures>::const_iterator week = jobs->weeks->begin(); week != jobs->weeks->end(); ++week)
+        {
+            string msg = league.play_week(week->second, seed, week->first);
+
+            if (msg != "")
+            {
+                jobs->errors[job_num] = msg;
+                return;
+            }
+        }
+
+        vector<pair<string, int> > standings = league.table.standings();
+
+        for (unsigned place = 0; place < standings.size(); ++place)
+        {
+            unsigned t = result.team_num(standings[place].first);
+
+            if (result.finishes[t].size() < standings.size())
+                result.finishes[t].resize(standings.size());
+
+            result.finishes[t][place]++;
+            result.points[t] += standings[place].second;
+        }
+
+        result.num_seasons++;
+    }
+}
+
+
+string run_season_projection(const season& start, const map<int, week_fixtures>& weeks, unsigned random_seed,
+                             unsigned num_seasons, unsigned num_threads, season_projection& result)
+{
+    result = season_projection();
+
+    // The teams of the table first, in its order
+    //
+    league_table table = start.table;
+    vector<pair<string, int> > standings = table.standings();
+
+    for (unsigned i = 0; i < standings.size(); ++i)
+        result.team_num(standings[i].first);
+
+    projection_jobs jobs;
+    jobs.start = &start;
+    jobs.weeks = &weeks;
+    jobs.random_seed = random_seed;
+    jobs.num_seasons = num_seasons;
+
+    unsigned num_jobs = (num_seasons + JOB_SIZE - 1) / JOB_SIZE;
+    jobs.results.resize(num_jobs);
+    jobs.errors.resize(num_jobs);
+
+    run_parallel(num_jobs, num_threads, run_projection_job, &jobs);
+
+    for (unsigned i = 0; i < num_jobs; ++i)
+    {
+        if (jobs.errors[i] != "")
+            return jobs.errors[i];
+
+        result.add(jobs.results[i]);
+    }
+
+    return "";
+}
+
+
+// The order of the teams in the projection - by the points they're
+// expected to have, and then in the order of the table
+//
+struct expected_points_predicate
+{
+    expected_points_predicate(const season_projection& result_)
+        : result(result_)
+    {}
+
+    bool operator()(unsigned left, unsigned right) const
+    {
+        return result.points[left] > result.points[right];
+    }
+
+    const season_projection& result;
+};
+
+
+void print_season_projection(FILE* out, const season_projection& result)
+{
+    double n = result.num_seasons;
+
+    if (result.num_seasons == 0)
+        return;
+
+    unsigned num_places = 0;
+    vector<unsigned> order;
+
+    for (unsigned t = 0; t < result.team_names.size(); ++t)
+    {
+        num_places = max(num_places, (unsigned) result.finishes[t].size());
+        order.push_back(t);
+    }
+
+    stable_sort(order.begin(), order.end(), expected_points_predicate(result));
+
+    fprintf(out, "Season projection: %u seasons\n\n", result.num_seasons);
+    fprintf(out, "%-21s %7s", "Team", "Pts");
+
+    for (unsigned p = 1; p <= num_places; ++p)
+        fprintf(out, " %5u", p);
+
+    fprintf(out, "\n%s\n", string(29 + 6 * num_places, '-').c_str());
+
+    for (vector<unsigned>::const_iterator t = order.begin(); t != order.end(); ++t)
+    {
+        fprintf(out, "%-21s %7.2f", result.team_names[*t].c_str(), result.points[*t] / n);
+
+        for (unsigned p = 0; p < num_places; ++p)
+        {
+            unsigned seasons = p < result.finishes[*t].size() ? result.finishes[*t][p] : 0;
+            fprintf(out, " %5.1f", 100 * seasons / n);
+        }
+
+        fprintf(out, "\n");
+    }
+
+    fprintf(out, "\n(the chances of finishing in each place, in %%)\n");
+}
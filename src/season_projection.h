@@ -0,0 +1,73 @@
+// ESMS - Electronic Soccer Management Simulator
+// Copyright (C) <1998-2005>  Eli Bendersky
+//
+// This program is free software, licensed with the GPL (www.fsf.org)
+//
+#ifndef SEASON_PROJECTION_H
+#define SEASON_PROJECTION_H
+
+
+#include <cstdio>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "season.h"
+
+
+using namespace std;
+
+
+// How the seasons played from the same start finished
+//
+struct season_projection
+{
+    season_projection()
+        : num_seasons(0)
+    {}
+
+    // The teams, in the order of the table the seasons started from
+    // (and then the teams that weren't in it)
+    //
+    vector<string> team_names;
+
+    unsigned num_seasons;
+
+    // finishes[t][p] is the number of seasons team t finished in place
+    // p + 1, and points[t] the total of its points at the end of them
+    //
+    vector<vector<unsigned> > finishes;
+    vector<double> points;
+
+    // Adds the seasons of other, by the names of the teams
+    //
+    void add(const season_projection& other);
+
+    // The number of team_name in team_names (it's added if it's not
+    // there)
+    //
+    unsigned team_num(string team_name);
+};
+
+
+// Plays the weeks of fixtures from the rosters and the table of
+// start, num_seasons times, on num_threads threads. Each season is
+// played by a season of its own (on one thread, like start, but with
+// no commentary nor leaders), and season i uses the league seed of
+// stream i of random_seed, so the result doesn't depend on the amount
+// of threads.
+//
+// Returns "" on success, and an error message if a season can't be
+// played (see season::play_week).
+//
+string run_season_projection(const season& start, const map<int, week_fixtures>& weeks, unsigned random_seed,
+                             unsigned num_seasons, unsigned num_threads, season_projection& result);
+
+
+// Prints the chances of each team to finish in each place of the
+// table, and its expected points, from the most expected points
+//
+void print_season_projection(FILE* out, const season_projection& result);
+
+
+#endif // SEASON_PROJECTION_H
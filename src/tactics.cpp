@@ -151,6 +151,26 @@ void tactics_manager::init(const string filename)
     // tactics.dat)
     //
     ensure_no_uninits();
+
+    // --5-- Compile the multipliers into mult_table
+    //
+    compile_mult_table();
+}
+
+
+int tactics_manager::tactic_id(const string tactic) const
+{
+    vector<string>::const_iterator iter = find(tactics_names.begin(), tactics_names.end(), tactic);
+
+    return iter == tactics_names.end() ? -1 : iter - tactics_names.begin();
+}
+
+
+int tactics_manager::position_id(const string position) const
+{
+    vector<string>::const_iterator iter = find(positions_names.begin(), positions_names.end(), position);
+
+    return iter == positions_names.end() ? -1 : iter - positions_names.begin();
 }
 
 
@@ -287,10 +307,46 @@ void tactics_manager::ensure_no_uninits(void)
 }
 
 
+// Lays tact_matrix out in mult_table, in the order of the ids
+//
+void tactics_manager::compile_mult_table(void)
+{
+    num_tactics = tactics_names.size();
+    num_positions = positions_names.size();
+
+    assert(skills_names.size() == NUM_SKILLS);
+    assert(skills_names[SKILL_TK] == "TK" && skills_names[SKILL_PS] == "PS" && skills_names[SKILL_SH] == "SH");
+
+    mult_table.assign(num_tactics * num_tactics * num_positions * NUM_SKILLS, UNINIT);
+
+    for (int tact = 0; tact < num_tactics; ++tact)
+	for (int opp_tact = 0; opp_tact < num_tactics; ++opp_tact)
+	{
+	    const mult_matrix_t& matrix = tact_matrix[str_pair(tactics_names[tact], tactics_names[opp_tact])];
+
+	    for (int pos = 0; pos < num_positions; ++pos)
+		for (int skill = 0; skill < NUM_SKILLS; ++skill)
+		{
+		    mult_table[((tact * num_tactics + opp_tact) * num_positions + pos) * NUM_SKILLS + skill] = 
+			matrix.find(str_pair(positions_names[pos], skills_names[skill]))->second;
+		}
+	}
+}
+
+
+// Note: only looks the multiplier up (operator[] of map may insert),
+// so many matches can call it at the same time once init is done
+//
 double tactics_manager::get_mult(const string tactic, const string opp_tactic, 
 				 const string pos, const string skill)
 {
-    double mult = (tact_matrix[str_pair(tactic, opp_tactic)])[str_pair(pos, skill)];
+    map<str_pair, mult_matrix_t>::const_iterator matrix = tact_matrix.find(str_pair(tactic, opp_tactic));
+    assert(matrix != tact_matrix.end());
+
+    mult_matrix_t::const_iterator mult_i = matrix->second.find(str_pair(pos, skill));
+    assert(mult_i != matrix->second.end());
+
+    double mult = mult_i->second;
 
     assert(tactic_exists(tactic));
     assert(tactic_exists(opp_tactic));
@@ -8,6 +8,7 @@
 
 
 #include <map>
+#include <vector>
 #include <cassert>
 #include <string>
 
@@ -18,6 +19,12 @@ typedef pair<string, string> str_pair;
 typedef map<str_pair, double > mult_matrix_t;
 
 
+// The skills multipliers apply to. These are the skill ids used
+// by the fast get_mult
+//
+enum skill_id {SKILL_TK, SKILL_PS, SKILL_SH, NUM_SKILLS};
+
+
 ///////////////////////
 //
 // tactics_manager
@@ -27,6 +34,13 @@ typedef map<str_pair, double > mult_matrix_t;
 // called and all information is read from a file. Then,
 // the desired multipliers are accessed using get_mult
 //
+// When init is done, all the multipliers are also compiled into a
+// flat table, indexed by small integer ids of the tactics (their
+// index in the sorted tactics_names), positions (DF = 0 .. FW = 4)
+// and skills (skill_id). The match engine resolves its tactics and
+// positions to ids once (tactic_id, position_id), and then a
+// multiplier is a single array load.
+//
 // Implemented as a Singleton
 //
 class tactics_manager
@@ -36,6 +50,18 @@ class tactics_manager
 	double get_mult(const string tactic, const string opp_tactic, 
 			const string pos, const string skill);
 
+	double get_mult(int tactic, int opp_tactic, int pos, skill_id skill) const
+	{
+	    assert(tactic >= 0 && opp_tactic >= 0 && pos >= 0);
+	    return mult_table[((tactic * num_tactics + opp_tactic) * num_positions + pos) * NUM_SKILLS + skill];
+	}
+
+	// The id of a tactic or a position (w/o side), -1 if there's
+	// no such tactic / position (GK has no id - it has no multipliers)
+	//
+	int tactic_id(const string tactic) const;
+	int position_id(const string position) const;
+
 	bool tactic_exists(const string tactic);
 	bool position_exists(const string position);
 	bool skill_exists(const string skill);
@@ -43,7 +69,7 @@ class tactics_manager
 	string get_tactic_full_name(string name)
 	{
 	    assert(tactic_exists(name));
-	    return tactic_full_name[name];
+	    return tactic_full_name.find(name)->second;
 	}
 
 	const vector<string>& get_positions_names(void)
@@ -54,7 +80,9 @@ class tactics_manager
 	friend tactics_manager& tact_manager();
 
     private:
-	tactics_manager() {}
+	tactics_manager()
+	    : num_tactics(0), num_positions(0)
+	{}
 	tactics_manager(const tactics_manager& rhs);
 	tactics_manager& operator= (const tactics_manager& rhs);
 	
@@ -62,6 +90,7 @@ class tactics_manager
 	//
 	void set_multipliers(void);
 	void ensure_no_uninits(void);
+	void compile_mult_table(void);
 
 	// full names
 	map<string, string> tactic_full_name;
@@ -80,6 +109,11 @@ class tactics_manager
 	
 	// The main data structure - holds all the multipliers
 	map<str_pair, mult_matrix_t> tact_matrix;
+
+	// tact_matrix compiled into a flat table (see get_mult)
+	vector<double> mult_table;
+	int num_tactics;
+	int num_positions;
 };
 
 
@@ -6,6 +6,7 @@
 #include "teamsheet_reader.h"
 #include "util.h"
 #include <fstream>
+#include <sstream>
 
 
 teamsheet_reader::teamsheet_reader()
@@ -20,16 +21,28 @@ string teamsheet_reader::read_teamsheet(const string& teamsheet_name)
 	if (!infile)
 		return "Failed to open teamsheet " + teamsheet_name;
 	
+	add_lines(infile);
+	return "";
+}
+
+
+void teamsheet_reader::read_teamsheet_text(const string& text)
+{
+	istringstream lines(text);
+	add_lines(lines);
+}
+
+
+void teamsheet_reader::add_lines(istream& lines)
+{
 	file_lines.clear();
 	string line;
 	
-	while(getline(infile, line))
+	while(getline(lines, line))
 	{
 		if (!is_only_whitespace(line))
 			file_lines.push_back(line);
 	}
-
-	return "";
 }
 
 
@@ -7,6 +7,7 @@
 #define TEAMSHEET_READER_H
 
 #include <deque>
+#include <istream>
 #include <string>
 
 using namespace std;
@@ -20,6 +21,11 @@ public:
 	teamsheet_reader();
 	string read_teamsheet(const string& teamsheet_name);
 
+	/// Like read_teamsheet, with the text of the teamsheet (for the
+	/// teamsheets made in memory - see make_teamsheet)
+	///
+	void read_teamsheet_text(const string& text);
+
 	bool end_of_teamsheet();
 
 	/// Returns the current line, removing it from the store (the next grab/peek
@@ -33,6 +39,8 @@ public:
 	string peek_line();
 
 private:
+	void add_lines(istream& lines);
+
 	deque<string> file_lines;
 };
 
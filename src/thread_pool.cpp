@@ -0,0 +1,162 @@
+// ESMS - Electronic Soccer Management Simulator
+// Copyright (C) <1998-2005>  Eli Bendersky
+//
+// This program is free software, licensed with the GPL (www.fsf.org)
+//
+#include "thread_pool.h"
+#include "util.h"
+
+#include <vector>
+#include <cstring>
+
+#ifdef WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <unistd.h>
+#endif
+
+
+using namespace std;
+
+
+// The threads are Win32 threads on Windows (so no pthreads library is
+// needed there), and pthreads elsewhere
+//
+#ifdef WIN32
+typedef CRITICAL_SECTION run_lock;
+typedef HANDLE worker_thread;
+#else
+typedef pthread_mutex_t run_lock;
+typedef pthread_t worker_thread;
+#endif
+
+
+// State shared by the workers of one run_parallel call
+//
+struct parallel_run
+{
+    run_lock lock;
+    unsigned next_job;
+    unsigned num_jobs;
+    parallel_job job;
+    void* data;
+};
+
+
+static unsigned take_job(parallel_run* run)
+{
+#ifdef WIN32
+    EnterCriticalSection(&run->lock);
+    unsigned job_num = run->next_job++;
+    LeaveCriticalSection(&run->lock);
+#else
+    pthread_mutex_lock(&run->lock);
+    unsigned job_num = run->next_job++;
+    pthread_mutex_unlock(&run->lock);
+#endif
+
+    return job_num;
+}
+
+
+static void run_jobs(parallel_run* run)
+{
+    for (;;)
+    {
+        unsigned job_num = take_job(run);
+
+        if (job_num >= run->num_jobs)
+            break;
+
+        run->job(job_num, run->data);
+    }
+}
+
+
+#ifdef WIN32
+static DWORD WINAPI worker_main(LPVOID arg)
+{
+    run_jobs((parallel_run*) arg);
+    return 0;
+}
+#else
+static void* worker_main(void* arg)
+{
+    run_jobs((parallel_run*) arg);
+    return 0;
+}
+#endif
+
+
+void run_parallel(unsigned num_jobs, unsigned num_threads, parallel_job job, void* data)
+{
+    if (num_threads > num_jobs)
+        num_threads = num_jobs;
+
+    if (num_threads <= 1)
+    {
+        for (unsigned i = 0; i < num_jobs; ++i)
+            job(i, data);
+
+        return;
+    }
+
+    parallel_run run;
+    run.next_job = 0;
+    run.num_jobs = num_jobs;
+    run.job = job;
+    run.data = data;
+
+    vector<worker_thread> threads(num_threads);
+
+#ifdef WIN32
+    InitializeCriticalSection(&run.lock);
+
+    for (unsigned i = 0; i < num_threads; ++i)
+    {
+        threads[i] = CreateThread(0, 0, worker_main, &run, 0, 0);
+
+        if (!threads[i])
+            die("Can't create a worker thread (error %lu)", (unsigned long) GetLastError());
+    }
+
+    for (unsigned i = 0; i < num_threads; ++i)
+    {
+        WaitForSingleObject(threads[i], INFINITE);
+        CloseHandle(threads[i]);
+    }
+
+    DeleteCriticalSection(&run.lock);
+#else
+    pthread_mutex_init(&run.lock, 0);
+
+    for (unsigned i = 0; i < num_threads; ++i)
+    {
+        int rc = pthread_create(&threads[i], 0, worker_main, &run);
+
+        if (rc != 0)
+            die("Can't create a worker thread: %s", strerror(rc));
+    }
+
+    for (unsigned i = 0; i < num_threads; ++i)
+        pthread_join(threads[i], 0);
+
+    pthread_mutex_destroy(&run.lock);
+#endif
+}
+
+
+unsigned num_processors(void)
+{
+#ifdef WIN32
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+
+    return info.dwNumberOfProcessors < 1 ? 1 : (unsigned) info.dwNumberOfProcessors;
+#else
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+
+    return n < 1 ? 1 : (unsigned) n;
+#endif
+}
@@ -0,0 +1,33 @@
+// ESMS - Electronic Soccer Management Simulator
+// Copyright (C) <1998-2005>  Eli Bendersky
+//
+// This program is free software, licensed with the GPL (www.fsf.org)
+//
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+
+// A job run by run_parallel - job_num is the number of the job
+// (0 .. num_jobs - 1), data is passed as given to run_parallel
+//
+typedef void (*parallel_job)(unsigned job_num, void* data);
+
+
+// Runs num_jobs jobs on num_threads worker threads, and returns
+// when all of them are done. Each worker takes the next job that
+// wasn't taken yet, so the jobs may run in any order - a job should
+// only touch its own part of data.
+//
+// With num_threads <= 1 (or a single job) the jobs are run one
+// after another in the calling thread.
+//
+void run_parallel(unsigned num_jobs, unsigned num_threads, parallel_job job, void* data);
+
+
+// The number of processors available, to be used as the default
+// amount of worker threads
+//
+unsigned num_processors(void);
+
+
+#endif // THREAD_POOL_H
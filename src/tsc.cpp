@@ -6,14 +6,14 @@
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
-#include <set>
 #include <cctype>
 #include <ctime>
-#include <cassert>
 #include "tsc.h"
+#include "auto_teamsheet.h"
 #include "rosterplayer.h"
 #include "util.h"
 #include "config.h"
+#include "rng.h"
 
 
 // wait on exit
@@ -22,70 +22,12 @@ bool waitflag = true;
 
 
 
-inline int st_getter(RosterPlayerConstIterator player)
-{
-	return player->st * player->fitness / 100;
-}
-
-
-inline int tk_getter(RosterPlayerConstIterator player)
-{
-	return player->tk * player->fitness / 100;
-}
-
-
-inline int ps_getter(RosterPlayerConstIterator player)
-{
-	return player->ps * player->fitness / 100;
-}
-
-
-inline int sh_getter(RosterPlayerConstIterator player)
-{
-	return player->sh * player->fitness / 100;
-}
-
-
-/// Gets the best player on some position from an array of roster players.
-/// 
-/// players 		- the array of players
-/// chosen_players 	- a set of already chosen players (those won't be chosen again)
-/// skill 			- pointer to a function receiving a player and returning the skill by
-/// 				  which "best" is judged.
-///
-/// Returns the chosen player's name. Note: chosen_players is not modified !
-///
-string choose_best_player(	const RosterPlayerArray& players, 
-							const set<string>& chosen_players, 
-							int (*skill)(RosterPlayerConstIterator player))
-{
-	int best_skill = -1;
-	string name_of_best = "";
-	
-    for (RosterPlayerConstIterator player = players.begin(); player != players.end(); ++player)
-    {
-        if (chosen_players.find(player->name) == chosen_players.end() && 
-			skill(player) > best_skill && !player->injury && !player->suspension)
-        {
-            best_skill = skill(player);
-            name_of_best = player->name;
-        }
-    }
-
-	assert(name_of_best != "");
-	return name_of_best;
-}
-
-
 int main(int argc, char** argv)
 {
 	FILE *teamsheetfile;
 
     char teamname[200], filename[200], teamsheetname[200];
-    int i, j; 
-
     char formation[200];
-	TeamsheetPlayer t_player[25];
 
     the_config().load_config_file("league.dat");
 
@@ -139,21 +81,6 @@ int main(int argc, char** argv)
 
     int num_subs = the_config().get_int_config("NUM_SUBS", 7);
 
-    // The number of subs is not constant, therefore there is
-    // a need for some smart assignment. The following array
-    // sets the positions of thr first 5 subs, and then iterates
-    // cyclicly. For example, if there are 2 subs allowed,
-    // their positions will be GK (mandatory 1st !) and MF
-    // If 7: GK, DF, MF, DF, FW, MF, DF
-    //                              ^
-    //                              cyclic repetition begins
-    //
-    const char* sub_position[] = {"DFC", "MFC", "DFC", "FWC", "MFC"};
-
-    // Iterates (cyclicly) over positions of subs,
-    //
-    int sub_pos_iter = 0;
-
 	RosterPlayerArray players;
     string msg = read_roster_players(filename, players);
 	
@@ -168,114 +95,16 @@ int main(int argc, char** argv)
 
     parse_formation(formation, dfs, mfs, fws, tactic);
 
-    // Calculate indices of the last defender and the last midfielder
-    //
-    int last_df = dfs + 1;
-    int last_mf = dfs + mfs + 1;
-
-    // Pick the players
-    //
-    // First, the best shot stopper is picked as a GK, then
-    // others are picker according to the schedule of sub_position
-    // as described above
-    //
-	
-	// This will keep us from picking the same players more than once
-	// 
-	set<string> chosen_players;
-	
-    for (i = 1; i <= 11; i++)
-    {
-        if (i == 1)
-            t_player[i].pos = "GK";
-        else if (i >= 2 && i <= last_df)
-            t_player[i].pos = "DFC";
-        else if (i > last_df && i <= last_mf)
-            t_player[i].pos = "MFC";
-        else if (i > last_mf && i <= 11)
-            t_player[i].pos = "FWC";
-    }
-	
-    // set the best GK for N.1 position
-    //
-	t_player[1].name = choose_best_player(players, chosen_players, st_getter);
-	chosen_players.insert(t_player[1].name);
-
-    // From now on, j is the index for players in the teamsheet
-	//
-
-    // Set the starting defenders
-	//
-    for (j = 2; j <= last_df; j++)
-    {
-		t_player[j].name = choose_best_player(players, chosen_players, tk_getter);
-		chosen_players.insert(t_player[j].name);
-    }
+    string teamsheet;
+    msg = make_teamsheet(teamname, players, dfs, mfs, fws, tactic[0], num_subs, teamsheet);
 
-    // Set the starting midfielders
-	//
-    for (j = last_df + 1; j <= last_mf; j++)
-    {
-		t_player[j].name = choose_best_player(players, chosen_players, ps_getter);
-		chosen_players.insert(t_player[j].name);
-    }
-
-    // Set the starting forwards
-	//
-    for (j = last_mf + 1; j <= 11; j++)
-    {
-		t_player[j].name = choose_best_player(players, chosen_players, sh_getter);
-		chosen_players.insert(t_player[j].name);
-    }
-
-    // Set the substitute GK
-	//
-	t_player[12].name = choose_best_player(players, chosen_players, st_getter);
-	t_player[12].pos = "GK";
-	chosen_players.insert(t_player[12].name);
-	
-	string name_of_best = "";
-
-    for (j = 13; j <= num_subs + 11; ++j)
-    {
-        // What position should the current sub be on ?
-        //
-        if (!strcmp(sub_position[sub_pos_iter], "DFC"))
-			name_of_best = choose_best_player(players, chosen_players, tk_getter);
-        else if (!strcmp(sub_position[sub_pos_iter], "MFC"))
-			name_of_best = choose_best_player(players, chosen_players, ps_getter);
-        else if (!strcmp(sub_position[sub_pos_iter], "FWC"))
-			name_of_best = choose_best_player(players, chosen_players, sh_getter);
-        else
-            assert(0);
-
-		t_player[j].name = name_of_best;
-		t_player[j].pos = sub_position[sub_pos_iter];
-		chosen_players.insert(t_player[j].name);
-        sub_pos_iter = (sub_pos_iter + 1) % 5;
-    }
+    if (msg != "")
+        die(msg.c_str());
 
     sprintf(teamsheetname, "%ssht.txt", teamname);
 
     teamsheetfile = fopen(teamsheetname, "w");
-
-    // Start filling the team sheet with the roster name and the
-    // tactic
-    //
-    fprintf(teamsheetfile, "%s\n", teamname);
-    fprintf(teamsheetfile, "%s\n", tactic);
-
-    /* Print all the players and their position */
-    for (i = 1; i <= 11 + num_subs; i++)
-    {
-        fprintf(teamsheetfile, "\n%s %s", t_player[i].pos.c_str(), t_player[i].name.c_str());
-
-        if (i == 11)
-            fprintf(teamsheetfile, "\n");
-    }
-
-    /* Print the penalty kick taker (player number last_mf + 1) */
-    fprintf(teamsheetfile, "\n\nPK: %s\n\n", t_player[last_mf + 1].name.c_str());
+    fputs(teamsheet.c_str(), teamsheetfile);
 
     printf("%s created successfully\n", teamsheetname);
 
@@ -318,19 +147,19 @@ void parse_formation(char* formation, int& dfs, int& mfs,
     //
     if (!strncmp(formation, "rnd", 3))
     {
-        srand(time(NULL));
+        rng_stream rng(time(NULL));
 
         // between 3 and 5
-        dfs = 3 + rand() % 3;
+        dfs = 3 + rng.below(3);
 
         // if there are 5 dfs, max of 4 mfs
         if (dfs == 5)
         {
-            mfs = 1 + rand() % 4;
+            mfs = 1 + rng.below(4);
         }
         else // 5 mfs is also possible
         {
-            mfs = 1 + rand() % 5;
+            mfs = 1 + rng.below(5);
         }
 
         fws = 10 - dfs - mfs;
@@ -11,13 +11,6 @@
 using namespace std;
 
 
-struct TeamsheetPlayer
-{
-    string pos;
-    string name;
-};
-
-
 void EXIT(int rc);
 void chomp(char* str);
 void parse_formation(char* formation, int& dfs, int& mfs, int& fws, char* tactic);